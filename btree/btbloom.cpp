@@ -0,0 +1,96 @@
+#include <string.h>
+#include "btbloom.h"
+
+
+//-------------------------------------------------------------------
+// GetBitNumbers
+//
+// Compute the BLOOM_NUM_HASHES bits of a key within its page, by
+// double hashing on the two halves of its hash.
+//-------------------------------------------------------------------
+
+static void GetBitNumbers(const KeyView &key, unsigned int *bits)
+{
+	unsigned long long h = GetKeyHash(key);
+	unsigned int h1 = (unsigned int)h;
+	unsigned int h2 = (unsigned int)(h >> 32) | 1;
+
+	for (int i = 0; i < BLOOM_NUM_HASHES; i++)
+		bits[i] = (h1 + i * h2) % BLOOM_PAGE_BITS;
+}
+
+
+//-------------------------------------------------------------------
+// BTBloomPage::GetPageIndex
+//
+// Input   : key - the key to be added or tested.
+//           numPages - number of pages in the filter.
+// Output  : None
+// Purpose : Choose the page of the filter that holds the bits of key.
+//           The choice uses a different hash than the bits do.
+// Return  : The index of that page within the filter, from 0.
+//-------------------------------------------------------------------
+
+int BTBloomPage::GetPageIndex (const KeyView &key, int numPages)
+{
+	unsigned long long h = GetKeyHash(key) * 0x9e3779b97f4a7c15ULL;
+
+	return (int)((h >> 32) % (unsigned int)numPages);
+}
+
+
+//-------------------------------------------------------------------
+// BTBloomPage::Clear
+//
+// Input   : None
+// Output  : None
+// Purpose : Clear all bits of the page.
+//-------------------------------------------------------------------
+
+void BTBloomPage::Clear ()
+{
+	memset(HeapPage::data, 0, HEAPPAGE_DATA_SIZE);
+}
+
+
+//-------------------------------------------------------------------
+// BTBloomPage::Add
+//
+// Input   : key - a key that hashes to this page.
+// Output  : None
+// Purpose : Set the bits of key.
+//-------------------------------------------------------------------
+
+void BTBloomPage::Add (const KeyView &key)
+{
+	unsigned char *bytes = (unsigned char *)HeapPage::data;
+	unsigned int bits[BLOOM_NUM_HASHES];
+
+	GetBitNumbers(key, bits);
+	for (int i = 0; i < BLOOM_NUM_HASHES; i++)
+		bytes[bits[i] / 8] |= (unsigned char)(1 << (bits[i] % 8));
+}
+
+
+//-------------------------------------------------------------------
+// BTBloomPage::MayContain
+//
+// Input   : key - a key that hashes to this page.
+// Output  : None
+// Purpose : Test the bits of key.
+// Return  : false if key was never added, true if it may have been.
+//-------------------------------------------------------------------
+
+bool BTBloomPage::MayContain (const KeyView &key)
+{
+	const unsigned char *bytes = (const unsigned char *)HeapPage::data;
+	unsigned int bits[BLOOM_NUM_HASHES];
+
+	GetBitNumbers(key, bits);
+	for (int i = 0; i < BLOOM_NUM_HASHES; i++)
+	{
+		if (!(bytes[bits[i] / 8] & (1 << (bits[i] % 8))))
+			return false;
+	}
+	return true;
+}
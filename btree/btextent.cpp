@@ -0,0 +1,176 @@
+#include "btextent.h"
+
+
+//-------------------------------------------------------------------
+// BTFreeExtentMap::Add
+//
+// Input   : firstPage, count - a run of pages that are free.
+// Output  : None
+// Purpose : Add a run to the map, merging it with the runs right
+//           before and after it.
+//-------------------------------------------------------------------
+
+void BTFreeExtentMap::Add (PageID firstPage, int count)
+{
+	StartMap::iterator next = byStart.lower_bound(firstPage);
+
+	if (next != byStart.end() && next->first == firstPage + count) {
+		count += next->second;
+		Remove(next);
+		next = byStart.lower_bound(firstPage);
+	}
+
+	if (next != byStart.begin()) {
+		StartMap::iterator prev = next;
+
+		--prev;
+		if (prev->first + prev->second == firstPage) {
+			firstPage = prev->first;
+			count += prev->second;
+			Remove(prev);
+		}
+	}
+
+	Insert(firstPage, count);
+}
+
+
+//-------------------------------------------------------------------
+// BTFreeExtentMap::TakeNear
+//
+// Input   : near - the page the caller would like.
+// Output  : pageID - the free page nearest to near.
+// Return  : true if there was a free page, false if the map is empty.
+// Purpose : Take one page out of the map.
+//-------------------------------------------------------------------
+
+bool BTFreeExtentMap::TakeNear (PageID near, PageID &pageID)
+{
+	StartMap::iterator next = byStart.upper_bound(near);
+	StartMap::iterator prev = next;
+
+	if (byStart.empty())
+		return false;
+
+	if (prev != byStart.begin()) {
+		--prev;
+
+		// near itself is free, or the last page of the run before it is nearer
+		// than the first of the run after it
+		PageID last = prev->first + prev->second - 1;
+		if (near <= last || next == byStart.end() || near - last <= next->first - near) {
+			pageID = (near <= last) ? near : last;
+			TakePage(prev, pageID);
+			return true;
+		}
+	}
+
+	pageID = next->first;
+	TakePage(next, pageID);
+	return true;
+}
+
+
+//-------------------------------------------------------------------
+// BTFreeExtentMap::TakeRun
+//
+// Input   : count - number of pages needed.
+// Output  : firstPage - first of count consecutive free pages.
+// Return  : true if there is a run that long, false otherwise.
+// Purpose : Take the pages out of the map, from the shortest run that
+//           is long enough.
+//-------------------------------------------------------------------
+
+bool BTFreeExtentMap::TakeRun (int count, PageID &firstPage)
+{
+	SizeSet::iterator fit = bySize.lower_bound(std::make_pair(count, INVALID_PAGE));
+	int runCount;
+
+	if (fit == bySize.end())
+		return false;
+
+	firstPage = fit->second;
+	runCount = fit->first;
+	Remove(byStart.find(firstPage));
+	if (runCount > count)
+		Insert(firstPage + count, runCount - count);
+	return true;
+}
+
+
+//-------------------------------------------------------------------
+// BTFreeExtentMap::TakeSmallest
+//
+// Input   : None
+// Output  : firstPage, count - the shortest run of free pages.
+// Return  : true if there was a run, false if the map is empty.
+// Purpose : Take a whole run out of the map, to give its pages back
+//           to the database.
+//-------------------------------------------------------------------
+
+bool BTFreeExtentMap::TakeSmallest (PageID &firstPage, int &count)
+{
+	if (bySize.empty())
+		return false;
+
+	count = bySize.begin()->first;
+	firstPage = bySize.begin()->second;
+	Remove(byStart.find(firstPage));
+	return true;
+}
+
+
+//-------------------------------------------------------------------
+// BTFreeExtentMap::Insert
+//
+// Input   : firstPage, count - a run that overlaps no other.
+// Output  : None
+// Purpose : Put a run in both indexes.
+//-------------------------------------------------------------------
+
+void BTFreeExtentMap::Insert (PageID firstPage, int count)
+{
+	byStart[firstPage] = count;
+	bySize.insert(std::make_pair(count, firstPage));
+	numPages += count;
+}
+
+
+//-------------------------------------------------------------------
+// BTFreeExtentMap::Remove
+//
+// Input   : run - a run of the map.
+// Output  : None
+// Purpose : Take a run out of both indexes.
+//-------------------------------------------------------------------
+
+void BTFreeExtentMap::Remove (StartMap::iterator run)
+{
+	bySize.erase(std::make_pair(run->second, run->first));
+
+	numPages -= run->second;
+	byStart.erase(run);
+}
+
+
+//-------------------------------------------------------------------
+// BTFreeExtentMap::TakePage
+//
+// Input   : run - a run of the map.
+//           pageID - a page of that run.
+// Output  : None
+// Purpose : Take one page out of a run, leaving what is before and
+//           after it as runs of their own.
+//-------------------------------------------------------------------
+
+void BTFreeExtentMap::TakePage (StartMap::iterator run, PageID pageID)
+{
+	PageID firstPage = run->first;
+	int count = run->second;
+
+	Remove(run);
+	if (pageID > firstPage)
+		Insert(firstPage, pageID - firstPage);
+	if (pageID < firstPage + count - 1)
+		Insert(pageID + 1, firstPage + count - 1 - pageID);
+}
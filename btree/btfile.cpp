@@ -6,19 +6,82 @@
 #include "btfilescan.h"
 #include <stack>
 
+// Pin and unpin the nodes of a descent, going through the resident index
+// pages first (see BTreeFile::PinNode).
+#define PIN_NODE(a, b)   if (PinNode((a), (SortedPage *&)(b)) != OK) return FAIL;
+#define UNPIN_NODE(a, b) if (UnpinNode((a), (b)) != OK) return FAIL;
+
 const bool DEBUG_MODE = true;
 
 void BTreeFile::debugPrint(const char *msg){
 	if(DEBUG_MODE) std::cout << msg << std::endl;
 }
 
+//-------------------------------------------------------------------
+// BloomPageAdd
+//
+// Input   : firstPageID, numPages - the run of pages of a Bloom filter.
+//           key - the key to add.
+// Output  : None
+// Purpose : Set the bits of key in the page of the filter it hashes to.
+// Return  : OK if successful, FAIL otherwise.
+//-------------------------------------------------------------------
+
+static Status BloomPageAdd(PageID firstPageID, int numPages, const KeyView &key)
+{
+	PageID pageID = firstPageID + BTBloomPage::GetPageIndex(key, numPages);
+	BTBloomPage *bloomPage;
+
+	PIN(pageID, bloomPage);
+	bloomPage->Add(key);
+	UNPIN(pageID, DIRTY);
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// FreeBloomPages
+//
+// Input   : firstPageID, numPages - the run of pages of a Bloom filter,
+//                                   INVALID_PAGE for none.
+// Output  : None
+// Purpose : Free the pages of the filter.
+// Return  : OK if successful, FAIL otherwise.
+//-------------------------------------------------------------------
+
+static Status FreeBloomPages(PageID firstPageID, int numPages)
+{
+	if (firstPageID == INVALID_PAGE)
+		return OK;
+
+	for (int i = 0; i < numPages; i++) {
+		Page *page;
+
+		PIN(firstPageID + i, page);
+		FREEPAGE(firstPageID + i);
+	}
+	return OK;
+}
+
 //-------------------------------------------------------------------
 // BTreeFile::BTreeFile
 //
 // Input   : filename - filename of an index.
+//           leafType - LEAF_NODE for one entry per record, or
+//                      POSTING_NODE to keep one posting list per key
+//                      (see btposting.h).  Only used when the index
+//                      is created; an existing index keeps its own.
+//           readOnly - open an existing index for lookups and scans
+//                      only.  Everything that would change it fails,
+//                      and none of its pages are ever made dirty, so
+//                      the buffer manager never has to write them back
+//                      to evict them.  Meant for indexes that are built
+//                      once and then only read.  The pages are still
+//                      read into frames of the buffer manager like
+//                      any others; the flag only guards against changes.
 // Output  : returnStatus - status of execution of constructor.
 //           OK if successful, FAIL otherwise.
-// Purpose : Open the index file, if it exists.
+// Purpose : Open the index file, if it exists, and check that its
+//           pages are in the layout of BTREE_FORMAT_VERSION.
 //			 Otherwise, create a new index, with the specified
 //           filename. You can use
 //                MINIBASE_DB->GetFileEntry(filename, headerID);
@@ -28,15 +91,30 @@ void BTreeFile::debugPrint(const char *msg){
 //           once you have read or created it. You will use the header
 //           page to find the root node.
 //-------------------------------------------------------------------
-BTreeFile::BTreeFile (Status& returnStatus, const char *filename) {
+BTreeFile::BTreeFile (Status& returnStatus, const char *filename, NodeType leafType, bool readOnly) {
 	// Save the name of the file so we delete appropriately
 	// when DestroyFile is called.
 	dbname = strcpy(new char[strlen(filename) + 1], filename);
-
-	Status stat = MINIBASE_DB->GetFileEntry(filename, headerID);
+	defrag.active = false;
+	defrag.lastNumLeaves = -1;
+	bloomRebuild.numCleared = 0;
+	bloomRebuild.atStart = true;
+	bloomRebuild.nextLeafID = INVALID_PAGE;
+	this->readOnly = readOnly;
+
+	Status stat = GetIndexFileEntry(filename, headerID);
 	Page *_headerPage;
 	returnStatus = OK;
 
+	// A read-only index cannot be created
+	if (stat == FAIL && readOnly) {
+		std::cerr << "Index " << filename << " does not exist" << std::endl;
+		headerID = INVALID_PAGE;
+		header = NULL;
+		returnStatus = FAIL;
+		return;
+	}
+
 	// File does not exist, so we should create a new index file.
 	if (stat == FAIL) {
 		// Allocate a new header page.
@@ -51,8 +129,8 @@ BTreeFile::BTreeFile (Status& returnStatus, const char *filename) {
 		}
 
 		header = (BTreeHeaderPage *)(_headerPage);
-		header->Init(headerID);
-		stat = MINIBASE_DB->AddFileEntry(filename, headerID);
+		header->Init(headerID, leafType);
+		stat = AddIndexFileEntry(filename, headerID);
 
 		if (stat != OK) {
 			std::cerr << "Error creating file" << std::endl;
@@ -69,9 +147,18 @@ BTreeFile::BTreeFile (Status& returnStatus, const char *filename) {
 			headerID = INVALID_PAGE;
 			header = NULL;
 			returnStatus = FAIL;
+			return;
 		}
 
 		header = (BTreeHeaderPage *) _headerPage;
+
+		if (header->GetFormatVersion() != BTREE_FORMAT_VERSION) {
+			std::cerr << "Index " << filename << " is in an unknown format" << std::endl;
+			MINIBASE_BM->UnpinPage(headerID, CLEAN);
+			headerID = INVALID_PAGE;
+			header = NULL;
+			returnStatus = FAIL;
+		}
 	}
 }
 
@@ -84,15 +171,22 @@ BTreeFile::BTreeFile (Status& returnStatus, const char *filename) {
 // Output  : None
 // Purpose : Free memory and clean Up. You should be sure to
 //           unpin the header page if it has not been unpinned
-//           in DestroyFile.
+//           in DestroyFile.  The header page is written back, as it
+//           holds the root and the Bloom filter counts.
 //-------------------------------------------------------------------
 BTreeFile::~BTreeFile ()
 {
     delete [] dbname;
+
+	if (resident.ReleaseAll() != OK)
+		cerr << "ERROR : Cannot release resident pages in BTreeFile::~BTreeFile" << endl;
+
+	if (ReleaseFreeLeaves(0) != OK)
+		cerr << "ERROR : Cannot free the free leaf pages in BTreeFile::~BTreeFile" << endl;
 	
     if (headerID != INVALID_PAGE) 
 	{
-		Status st = MINIBASE_BM->UnpinPage (headerID, CLEAN);
+		Status st = MINIBASE_BM->UnpinPage (headerID, !readOnly);
 		if (st != OK)
 		{
 		cerr << "ERROR : Cannot unpin page " << headerID << " in BTreeFile::~BTreeFile" << endl;
@@ -113,19 +207,37 @@ BTreeFile::~BTreeFile ()
 //-------------------------------------------------------------------
 Status BTreeFile::DestroyFile ()
 {
+	if (readOnly) return FAIL;
+
+	hints.Clear();
+	defrag.active = false;
+
+	// The pages are about to be freed, which they cannot be while they are resident
+	if (resident.ReleaseAll() != OK) {
+		return FAIL;
+	}
+
+	if (DestroyBloomFilter() != OK) {
+		return FAIL;
+	}
+
 	if (header->GetRootPageID() != INVALID_PAGE && _DestroyFile(header->GetRootPageID()) != OK) {
 		return FAIL;
 	}
 
-	FREEPAGE(headerID);
-	headerID = INVALID_PAGE;
-	header = NULL;
+	if (FreeLeafExtent() != OK || ReleaseFreeLeaves(0) != OK) {
+		return FAIL;
+	}
 
-	if (MINIBASE_DB->DeleteFileEntry(dbname) != OK) {
-		debugPrint("[ERROR] MINIBASE_DB->DeleteFileEntry failed in BTreeFile::DestroyFile()");
+	if (DeleteIndexFileEntry(dbname, headerID) != OK) {
+		debugPrint("[ERROR] DeleteIndexFileEntry failed in BTreeFile::DestroyFile()");
 		return FAIL;
 	}
 
+	FREEPAGE(headerID);
+	headerID = INVALID_PAGE;
+	header = NULL;
+
 	return OK;
 }
 
@@ -138,7 +250,6 @@ Status BTreeFile::_DestroyFile (PageID pageID)
 	PageID curPageID;
 
 	RecordID curRid;
-	KeyType key;
 
 	PIN (pageID, page);
 	NodeType type = page->GetType ();
@@ -149,14 +260,14 @@ Status BTreeFile::_DestroyFile (PageID pageID)
 		curPageID = index->GetLeftLink();
 		if (_DestroyFile(curPageID) != OK) return FAIL;
 
-		s=index->GetFirst(curRid, key, curPageID);
+		s=index->GetFirst(curRid, NULL, curPageID);
 		if ( s == OK) {	
 			if (_DestroyFile(curPageID) != OK) return FAIL;
 
-			s = index->GetNext(curRid, key, curPageID);
+			s = index->GetNext(curRid, NULL, curPageID);
 			while ( s != DONE) {	
 				if (_DestroyFile(curPageID) != OK) return FAIL;
-				s = index->GetNext(curRid, key, curPageID);
+				s = index->GetNext(curRid, NULL, curPageID);
 			}
 		}
 
@@ -166,6 +277,11 @@ Status BTreeFile::_DestroyFile (PageID pageID)
 	case LEAF_NODE:
 		FREEPAGE(pageID);
 		break;
+
+	case POSTING_NODE:
+		if (((BTPostingPage *)page)->FreeOverflowPages() != OK) return FAIL;
+		FREEPAGE(pageID);
+		break;
 	default:		
 		assert (0);
 	}
@@ -173,22 +289,243 @@ Status BTreeFile::_DestroyFile (PageID pageID)
 	return OK;
 }
 
+//-------------------------------------------------------------------
+// BTreeFile::PinNode
+//
+// Input   : pageID - a page of the tree.
+// Output  : page - the pinned page.
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Pin a page on the way down the tree.  A resident index page
+//           is found in the resident table without asking the buffer
+//           manager; any other index page is pinned and, while there is
+//           room, made resident, in which case the table keeps the pin.
+//           Every page pinned here must be unpinned with UnpinNode.
+//-------------------------------------------------------------------
+
+Status BTreeFile::PinNode (PageID pageID, SortedPage *&page)
+{
+	page = resident.Find(pageID);
+	if (page != NULL)
+		return OK;
+
+	PIN(pageID, page);
+	if (page->GetType() == INDEX_NODE)
+		resident.Add(pageID, page);
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::UnpinNode
+//
+// Input   : pageID - a page pinned with PinNode.
+//           dirty - whether it was changed.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Unpin a page pinned with PinNode.  A resident page stays
+//           pinned, and the buffer manager is told of any change.
+//-------------------------------------------------------------------
+
+Status BTreeFile::UnpinNode (PageID pageID, bool dirty)
+{
+	Status s = resident.Unpin(pageID, dirty);
+
+	if (s != DONE)
+		return s;
+
+	UNPIN(pageID, dirty);
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::NewLeafPage
+//
+// Input   : near - the page the leaf would best go on, or
+//                  INVALID_PAGE to take the next page of the extent.
+// Output  : pageID, page - the new page, pinned.
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Allocate a page for a leaf.  It is the free leaf page
+//           nearest to near, if there is one.  Otherwise it is the next
+//           page of the current leaf extent.  Once that one is used up
+//           a new one is reserved, twice the size of the last up to
+//           LEAF_EXTENT_PAGES, or of a single page once the database
+//           has no run that long.
+//-------------------------------------------------------------------
+
+Status BTreeFile::NewLeafPage (PageID &pageID, Page *&page, PageID near)
+{
+	if (near != INVALID_PAGE && freeLeaves.TakeNear(near, pageID)) {
+		if (MINIBASE_BM->PinPage(pageID, page, true) != OK) {
+			cerr << "Unable to pin page " << pageID << endl;
+			return FAIL;
+		}
+		return OK;
+	}
+
+	if (header->GetExtentNumPages() == 0) {
+		int numPages = header->GetNextExtentSize();
+
+		if (numPages < 1)
+			numPages = 1;
+		if (NewLeafExtent(numPages) == OK)
+			header->SetNextExtentSize(numPages * 2 < LEAF_EXTENT_PAGES ? numPages * 2 : LEAF_EXTENT_PAGES);
+		else if (NewLeafExtent(1) != OK) {
+			cerr << "Unable to allocate a leaf page" << endl;
+			return FAIL;
+		}
+	}
+
+	pageID = header->GetExtentPageID();
+	if (MINIBASE_BM->PinPage(pageID, page, true) != OK) {
+		cerr << "Unable to pin page " << pageID << endl;
+		return FAIL;
+	}
+
+	if (header->GetExtentNumPages() == 1)
+		header->SetLeafExtent(INVALID_PAGE, 0);
+	else
+		header->SetLeafExtent(pageID + 1, header->GetExtentNumPages() - 1);
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::NewLeafExtent
+//
+// Input   : numPages - size of the extent.
+// Output  : None
+// Return  : OK if successful, FAIL if there is no run of numPages
+//           free pages.
+// Purpose : Give up what is left of the current leaf extent and
+//           reserve a new one for the leaves to come, from the free
+//           leaf pages if they have a run that long.
+//-------------------------------------------------------------------
+
+Status BTreeFile::NewLeafExtent (int numPages)
+{
+	PageID firstPageID;
+	Page *firstPage;
+
+	if (FreeLeafExtent() != OK)
+		return FAIL;
+
+	if (freeLeaves.TakeRun(numPages, firstPageID)) {
+		header->SetLeafExtent(firstPageID, numPages);
+		return OK;
+	}
+
+	if (MINIBASE_BM->NewPage(firstPageID, firstPage, numPages) != OK)
+		return FAIL;
+
+	// NewPage pins the first page, which is pinned again when it is used
+	UNPIN(firstPageID, CLEAN);
+
+	header->SetLeafExtent(firstPageID, numPages);
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::FreeLeafExtent
+//
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Put the pages of the current leaf extent that no leaf
+//           has been given yet with the free leaf pages.
+//-------------------------------------------------------------------
+
+Status BTreeFile::FreeLeafExtent ()
+{
+	PageID firstPageID = header->GetExtentPageID();
+	int numPages = header->GetExtentNumPages();
+
+	header->SetLeafExtent(INVALID_PAGE, 0);
+	if (numPages > 0)
+		return AddFreeLeaves(firstPageID, numPages);
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::AddFreeLeaves
+//
+// Input   : firstPageID, numPages - a run of pages no leaf uses.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Keep the pages for new leaves, giving back to the database
+//           whatever takes the free leaf pages over FREE_LEAF_MAX_PAGES.
+//-------------------------------------------------------------------
+
+Status BTreeFile::AddFreeLeaves (PageID firstPageID, int numPages)
+{
+	freeLeaves.Add(firstPageID, numPages);
+	return ReleaseFreeLeaves(FREE_LEAF_MAX_PAGES);
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::ReleaseFreeLeaves
+//
+// Input   : maxPages - number of free leaf pages to keep.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Give free leaf pages back to the database, the shortest
+//           runs first, until no more than maxPages are left.  The map
+//           of them is not kept on disk, so all of them go back
+//           whenever the file is closed or destroyed.
+//-------------------------------------------------------------------
+
+Status BTreeFile::ReleaseFreeLeaves (int maxPages)
+{
+	PageID firstPageID;
+	int numPages;
+
+	while (freeLeaves.GetNumPages() > maxPages &&
+		freeLeaves.TakeSmallest(firstPageID, numPages)) {
+		// Keep the start of the run if there is room for it
+		int keep = maxPages - freeLeaves.GetNumPages();
+
+		if (keep > 0) {
+			freeLeaves.Add(firstPageID, keep);
+			firstPageID += keep;
+			numPages -= keep;
+		}
+
+		// Another file may take the pages, and pass the checks of their hints
+		hints.ForgetAll();
+		for (int i = 0; i < numPages; i++) {
+			Page *page;
+
+			if (MINIBASE_BM->PinPage(firstPageID + i, page, true) != OK) {
+				cerr << "Unable to pin page " << firstPageID + i << endl;
+				return FAIL;
+			}
+			FREEPAGE(firstPageID + i);
+		}
+	}
+
+	return OK;
+}
+
 //-------------------------------------------------------------------
 // BTreeFile::SplitLeafNode
 //
-// Input   : key - pointer to the value of the key to be inserted.
+// Input   : key - the value of the key to be inserted.
 //           rid - RecordID of the record to be inserted.
 //			 fullPage - pointer to the page that needs to be split
 // Output  : newPageID - ID of the newly created page
-//			 newPageFirstKey - pointer to the value of the first key on the new page
+//			 separatorKey - shortest key that separates the last key on the old page
+//							from the first key on the new page
+//			 separatorLen - length of separatorKey
+//			 separatorRid - record id half of the separator
 // Return  : OK if successful, FAIL otherwise.
 // Purpose : Split a leafNode into two nodes 
 //-------------------------------------------------------------------
-Status BTreeFile::SplitLeafNode(const char *key, const RecordID rid, BTLeafPage *fullPage, PageID &newPageID, KeyType &newPageFirstKey) {
+Status BTreeFile::SplitLeafNode(const KeyView &key, const RecordID rid, BTLeafPage *fullPage, PageID &newPageID, KeyType &separatorKey, int &separatorLen, RecordID &separatorRid) {
 	
-	// Create and initialize the page for the new leaf node
+	if (fullPage->GetType() == POSTING_NODE)
+		return SplitPostingNode(key, rid, (BTPostingPage *) fullPage, newPageID, separatorKey, separatorLen, separatorRid);
+
+	// Create and initialize the page for the new leaf node, as close after the full one as there is room
 	Page *newPage;
-	NEWPAGE(newPageID, newPage);
+	if (NewLeafPage(newPageID, newPage, fullPage->PageNo() + 1) != OK)
+		return FAIL;
 	BTLeafPage *newLeafPage = (BTLeafPage *) newPage;
 	newLeafPage->Init(newPageID);
 	newLeafPage->SetType(LEAF_NODE);
@@ -208,13 +545,13 @@ Status BTreeFile::SplitLeafNode(const char *key, const RecordID rid, BTLeafPage
 	newLeafPage->SetPrevPage(fullPage->PageNo());
     fullPage->SetNextPage(newPageID);
 
-	// Move all of the records from the old page to the new page
-	while (true) {
-		KeyType movedKey;
-		RecordID movedVal, firstRid, insertedRid;
-		Status s = fullPage->GetFirst(firstRid, movedKey, movedVal);
-		if (s == DONE) break;
-		if (newLeafPage->Insert(movedKey, movedVal, insertedRid) != OK) {
+	// Move all of the records from the old page to the new page. Keys are inserted straight
+	// from the old page, which stays pinned, so they never need to be copied out.
+	while (fullPage->GetNumOfRecords() > 0) {
+		RecordID firstRid, insertedRid;
+		firstRid.pageNo = fullPage->PageNo();
+		firstRid.slotNo = 0;
+		if (newLeafPage->Insert(fullPage->GetKeyView(0), fullPage->GetDataRid(0), insertedRid) != OK) {
 			std::cerr << "Moving records failed on insert while splitting leaf node num=" << fullPage->PageNo() << std::endl;
 			UNPIN(newPageID, DIRTY);
 			return FAIL;
@@ -230,14 +567,15 @@ Status BTreeFile::SplitLeafNode(const char *key, const RecordID rid, BTLeafPage
 	// If we run across the insert point for our new value while this is occuring, insert it. This will
 	// be taken care of later if it is not done during this step.
 	bool didInsert = false;
-	KeyType curKey;
-	RecordID curRid, curVal, insertedRid;
-	newLeafPage->GetFirst(curRid, curKey, curVal);
+	RecordID curRid, insertedRid;
+	curRid.pageNo = newPageID;
+	curRid.slotNo = 0;
 	while (fullPage->AvailableSpace() > newLeafPage->AvailableSpace()) {
+		KeyView curKey = newLeafPage->GetKeyView(0);
 
-		// Check if the key we are currently on is bigger than the one we are trying to insert
+		// Check if the entry we are currently on is bigger than the one we are trying to insert
 		// If so, this is our insert oppertunity so insert the new value into the old (first) page
-		if(!didInsert && KeyCmp(curKey,key) > 0){
+		if(!didInsert && KeyCmp(curKey, newLeafPage->GetDataRid(0), key, rid) > 0){
 			if (fullPage->Insert(key, rid, insertedRid) != OK){
 				UNPIN(newPageID, DIRTY);
 				return FAIL;
@@ -245,7 +583,7 @@ Status BTreeFile::SplitLeafNode(const char *key, const RecordID rid, BTLeafPage
 			didInsert = true;
 		}
 		else {
-			if (fullPage->Insert(curKey,curVal,insertedRid) != OK){
+			if (fullPage->Insert(curKey,newLeafPage->GetDataRid(0),insertedRid) != OK){
 				UNPIN(newPageID, DIRTY);
 				return FAIL;
 			}
@@ -253,8 +591,6 @@ Status BTreeFile::SplitLeafNode(const char *key, const RecordID rid, BTLeafPage
 				UNPIN(newPageID, DIRTY);
 				return FAIL;
 			}
-
-			newLeafPage->GetCurrent(curRid, curKey, curVal);
 		}
 	}
 
@@ -266,9 +602,122 @@ Status BTreeFile::SplitLeafNode(const char *key, const RecordID rid, BTLeafPage
 		}
 	}
 
-	// Set the output which is the first key of the new (second) page
-	KeyType newKey;
-	newLeafPage->GetFirst(curRid, newPageFirstKey, curVal);
+	// Copies of the same (key, rid) pair cannot be told apart by a separator, so they must all
+	// end up on one page. Move any that straddle the split onto the new page.
+	while (fullPage->GetNumOfRecords() > 1) {
+		RecordID lastRid;
+		lastRid.pageNo = fullPage->PageNo();
+		lastRid.slotNo = fullPage->GetNumOfRecords() - 1;
+
+		KeyView lastKey = fullPage->GetKeyView(lastRid.slotNo);
+		RecordID lastDataRid = fullPage->GetDataRid(lastRid.slotNo);
+		if (KeyCmp(lastKey, lastDataRid, newLeafPage->GetKeyView(0), newLeafPage->GetDataRid(0)) != 0)
+			break;
+
+		if (newLeafPage->AvailableSpace() < GetKeyDataLength(lastKey, LEAF_NODE) ||
+			newLeafPage->Insert(lastKey, lastDataRid, insertedRid) != OK ||
+			fullPage->DeleteRecord(lastRid) != OK) {
+			UNPIN(newPageID, DIRTY);
+			return FAIL;
+		}
+	}
+
+	// Set the output to the shortest prefix of the first key of the new (second) page that is
+	// still greater than the last key of the old (first) page. Any such prefix routes searches
+	// exactly like the full key would, but takes less space in the index nodes above.
+	// If a key runs on from one page to the other, the separator is that key together with
+	// the record id of the first entry on the new page.
+	KeyView leftLastKey = fullPage->GetKeyView(fullPage->GetNumOfRecords() - 1);
+	KeyView rightFirstKey = newLeafPage->GetKeyView(0);
+	separatorLen = MakeSeparatorKey(separatorKey, leftLastKey, rightFirstKey);
+	separatorRid = (KeyCmp(leftLastKey, rightFirstKey) == 0) ? newLeafPage->GetDataRid(0) : LOWEST_RID;
+
+	UNPIN(newPageID, DIRTY);
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::SplitPostingNode
+//
+// Input   : key - the value of the key to be inserted.
+//           rid - RecordID of the record to be inserted.
+//			 fullPage - pointer to the posting page that needs to be split
+// Output  : newPageID - ID of the newly created page
+//			 separatorKey - shortest key that separates the last key on the old page
+//							from the first key on the new page
+//			 separatorLen - length of separatorKey
+//			 separatorRid - always LOWEST_RID
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Split a posting node into two nodes.  Entries are moved whole, from the
+//			 end of the old page, until the pages are about equally full, and the new
+//			 rid is then added to whichever page its key belongs on.  Each key has a
+//			 single entry, so no key ever ends up on both pages.
+//-------------------------------------------------------------------
+Status BTreeFile::SplitPostingNode(const KeyView &key, const RecordID rid, BTPostingPage *fullPage, PageID &newPageID, KeyType &separatorKey, int &separatorLen, RecordID &separatorRid) {
+
+	// Create and initialize the page for the new posting node, as close after the full one as there is room
+	Page *newPage;
+	if (NewLeafPage(newPageID, newPage, fullPage->PageNo() + 1) != OK)
+		return FAIL;
+	BTPostingPage *newPostingPage = (BTPostingPage *) newPage;
+	newPostingPage->Init(newPageID);
+	newPostingPage->SetType(POSTING_NODE);
+
+	// Link the new page in after the full one
+	PageID nextPageID = fullPage->GetNextPage();
+	if (nextPageID != INVALID_PAGE) {
+		Page *nextPage;
+		PIN(nextPageID, nextPage);
+		((SortedPage *) nextPage)->SetPrevPage(newPageID);
+		UNPIN(nextPageID, DIRTY);
+	}
+	newPostingPage->SetNextPage(nextPageID);
+	newPostingPage->SetPrevPage(fullPage->PageNo());
+	fullPage->SetNextPage(newPageID);
+
+	// Move the last entry of the old page to the new one until the new page is at least as full
+	while (fullPage->GetNumOfRecords() > 1 && newPostingPage->AvailableSpace() > fullPage->AvailableSpace()) {
+		RecordID lastRid, insertedRid;
+		char *entry;
+		int entryLen;
+
+		lastRid.pageNo = fullPage->PageNo();
+		lastRid.slotNo = fullPage->GetNumOfRecords() - 1;
+		fullPage->ReturnRecord(lastRid, entry, entryLen);
+		if (newPostingPage->InsertRecord(entry, entryLen, insertedRid) != OK ||
+			fullPage->DeleteRecord(lastRid) != OK) {
+			std::cerr << "Moving records failed while splitting posting node num=" << fullPage->PageNo() << std::endl;
+			UNPIN(newPageID, DIRTY);
+			return FAIL;
+		}
+	}
+
+	// Add the new rid to the page that covers its key.  If the old page held a single entry,
+	// nothing was moved, and the new page takes the key only if it sorts after that entry.
+	BTPostingPage *target = fullPage;
+	if (newPostingPage->GetNumOfRecords() > 0) {
+		if (KeyCmp(key, newPostingPage->GetKeyView(0)) >= 0)
+			target = newPostingPage;
+	}
+	else if (KeyCmp(key, fullPage->GetKeyView(fullPage->GetNumOfRecords() - 1)) > 0)
+		target = newPostingPage;
+
+	if (target->AvailableSpace() < target->GetInsertLength(key, rid) || target->Insert(key, rid) != OK) {
+		UNPIN(newPageID, DIRTY);
+		return FAIL;
+	}
+
+	// Both pages need an entry for there to be a separator between them
+	if (newPostingPage->GetNumOfRecords() == 0) {
+		UNPIN(newPageID, DIRTY);
+		return FAIL;
+	}
+
+	KeyView leftLastKey = fullPage->GetKeyView(fullPage->GetNumOfRecords() - 1);
+	KeyView rightFirstKey = newPostingPage->GetKeyView(0);
+	separatorLen = MakeSeparatorKey(separatorKey, leftLastKey, rightFirstKey);
+	separatorRid = LOWEST_RID;
+
 	UNPIN(newPageID, DIRTY);
 	return OK;
 }
@@ -276,15 +725,18 @@ Status BTreeFile::SplitLeafNode(const char *key, const RecordID rid, BTLeafPage
 //-------------------------------------------------------------------
 // BTreeFile::SplitIndexNode
 //
-// Input   : key - pointer to the value of the key to be inserted.
+// Input   : key - the value of the key to be inserted.
+//           keyRid - record id half of the key to be inserted.
 //           rid - PageID of the record to be inserted.
 //			 fullPage - pointer to the page that needs to be split
 // Output  : newPageID - ID of the newly created page
-//			 newPageFirstKey - pointer to the value of the extra key to be added to the indexnode one level up
+//			 newPageFirstKey - the value of the extra key to be added to the indexnode one level up
+//			 newPageFirstKeyLen - length of newPageFirstKey
+//			 newPageFirstRid - record id half of newPageFirstKey
 // Return  : OK if successful, FAIL otherwise.
 // Purpose : Split an indexnode into two nodes 
 //-------------------------------------------------------------------
-Status BTreeFile::SplitIndexNode(const char *key, const PageID pid, BTIndexPage *fullPage, PageID &newPageID, KeyType &newPageFirstKey) {
+Status BTreeFile::SplitIndexNode(const KeyView &key, const RecordID &keyRid, const PageID pid, BTIndexPage *fullPage, PageID &newPageID, KeyType &newPageFirstKey, int &newPageFirstKeyLen, RecordID &newPageFirstRid) {
 	
 	// Create and initialize the page for the new index node
 	Page *newPage;
@@ -294,14 +746,13 @@ Status BTreeFile::SplitIndexNode(const char *key, const PageID pid, BTIndexPage
 	newIndexPage->SetType(INDEX_NODE);
 
 
-	// Move all the records from the old page to the new page
+	// Move all the records from the old page to the new page, inserting the keys in place
 	while (true) {
-		KeyType movedKey;
 		RecordID firstRid, insertedRid;
 		PageID movedVal;
-		Status s = fullPage->GetFirst(firstRid, movedKey, movedVal);
+		Status s = fullPage->GetFirst(firstRid, NULL, movedVal);
 		if (s == DONE) break;
-		if (newIndexPage->Insert(movedKey, movedVal, insertedRid) != OK) {
+		if (newIndexPage->Insert(fullPage->GetKeyView(0), fullPage->GetKeyRid(0), movedVal, insertedRid) != OK) {
 			std::cerr << "Moving records failed on insert while splitting index node num=" << fullPage->PageNo() << std::endl;
 			UNPIN(newPageID, DIRTY);
 			return FAIL;
@@ -317,22 +768,23 @@ Status BTreeFile::SplitIndexNode(const char *key, const PageID pid, BTIndexPage
 	// If we run across the insert point for our new value while this is occuring, insert it. This will
 	// be taken care of later if it is not done during this step.
 	bool didInsert = false;
-	KeyType curKey;
 	RecordID curRid, insertedRid;
 	PageID curVal;
-	newIndexPage->GetFirst(curRid, curKey, curVal);
+	newIndexPage->GetFirst(curRid, NULL, curVal);
 	while (fullPage->AvailableSpace() > newIndexPage->AvailableSpace()) {
+		KeyView curKey = newIndexPage->GetKeyView(0);
+
 		// Check if the key we are currently on is bigger than the one we are trying to insert
 		// If so, this is our insert oppertunity so insert the new value into the old (first) page
-		if(!didInsert && KeyCmp(curKey,key) > 0){
-			if (fullPage->Insert(key, pid, insertedRid) != OK){
+		if(!didInsert && KeyCmp(curKey, newIndexPage->GetKeyRid(0), key, keyRid) > 0){
+			if (fullPage->Insert(key, keyRid, pid, insertedRid) != OK){
 				UNPIN(newPageID, DIRTY);
 				return FAIL;
 			}
 			didInsert = true;
 		}
 		else {
-			if (fullPage->Insert(curKey,curVal,insertedRid) != OK) {
+			if (fullPage->Insert(curKey, newIndexPage->GetKeyRid(0), curVal, insertedRid) != OK) {
 				UNPIN(newPageID, DIRTY);
 				return FAIL;
 			}
@@ -340,20 +792,24 @@ Status BTreeFile::SplitIndexNode(const char *key, const PageID pid, BTIndexPage
 				UNPIN(newPageID, DIRTY);
 				return FAIL;
 			}
-			newIndexPage->GetFirst(curRid, curKey, curVal);
+			newIndexPage->GetFirst(curRid, NULL, curVal);
 		}
 	}
 
 	// If we were unable to insert our new value in the previous step, do so now. However now it is inserted into the new (second) page.
 	if (!didInsert) {
-		if (newIndexPage->Insert(key, pid, insertedRid) != OK){
+		if (newIndexPage->Insert(key, keyRid, pid, insertedRid) != OK){
 			UNPIN(newPageID, DIRTY);
 			return FAIL;
 		}
 	}
 
 	// Set the output which is the first key of the new (second) page
-	newIndexPage->GetFirst(curRid, newPageFirstKey, curVal);
+	KeyView firstKey = newIndexPage->GetKeyView(0);
+	memcpy(newPageFirstKey, firstKey.key, firstKey.length);
+	newPageFirstKeyLen = firstKey.length;
+	newPageFirstRid = newIndexPage->GetKeyRid(0);
+	newIndexPage->GetFirst(curRid, NULL, curVal);
 
 	// Set the left link of the new index node and delete the duplicate key
 	newIndexPage->SetLeftLink(curVal);
@@ -375,21 +831,43 @@ Status BTreeFile::SplitIndexNode(const char *key, const PageID pid, BTIndexPage
 // Note    : If the root didn't exist, create it.
 //-------------------------------------------------------------------
 Status BTreeFile::Insert (const char *key, const RecordID rid)
+{
+	return Insert(MakeKeyView(key), rid);
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::Insert
+//
+// Input   : key - the value of the key to be inserted, which may
+//                 be any sequence of bytes.
+//           rid - RecordID of the record to be inserted.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Insert an index entry with this rid and key.  
+//-------------------------------------------------------------------
+Status BTreeFile::Insert (const KeyView &key, const RecordID rid)
 {
 	RecordID newRecordID;
 
+	if (readOnly) return FAIL;
+
+	// Add the key to the Bloom filter first; if the insert then fails, it only costs a false positive
+	if (BloomAdd(key) != OK)
+		return FAIL;
+
 	if (header->GetRootPageID() == INVALID_PAGE) {
 		// There is no root page, we need to make one
 		PageID newPageID;
 		Page *newPage;
 
-		NEWPAGE(newPageID, newPage);
+		if (NewLeafPage(newPageID, newPage, INVALID_PAGE) != OK)
+			return FAIL;
 
-		BTLeafPage *newLeafPage = (BTLeafPage *) newPage;
+		SortedPage *newLeafPage = (SortedPage *) newPage;
 		newLeafPage->Init(newPageID);
-		newLeafPage->SetType(LEAF_NODE);
+		newLeafPage->SetType(header->GetLeafType());
 
-		if (newLeafPage->Insert(key, rid, newRecordID) != OK) {
+		if (LeafInsert(newLeafPage, key, rid) != OK) {
 			FREEPAGE(newPageID);
 			return FAIL;
 		}
@@ -402,29 +880,31 @@ Status BTreeFile::Insert (const char *key, const RecordID rid)
 		// A root page exists
 		PageID rootID = header->GetRootPageID();
 		SortedPage *rootPage;
-		PIN(rootID, rootPage);
+		PIN_NODE(rootID, rootPage);
 		Status s;
 
 		// The rootPage is a leaf node, this is the trivial case
-		if (rootPage->GetType() == LEAF_NODE) {
+		if (rootPage->GetType() != INDEX_NODE) {
             BTLeafPage* rootleaf = (BTLeafPage*) rootPage;
 
 			// See if there is space in the root leaf to insert the new key
-            if (rootPage->AvailableSpace() >= GetKeyDataLength(key,LEAF_NODE)) {
-                if(rootleaf->Insert(key, rid, newRecordID) != OK) {
-					UNPIN(rootID, CLEAN);
+            if (rootPage->AvailableSpace() >= LeafInsertLength(rootPage, key, rid)) {
+                if(LeafInsert(rootPage, key, rid) != OK) {
+					UNPIN_NODE(rootID, CLEAN);
 					return FAIL;
 				}
-                UNPIN(rootID, DIRTY);
+                UNPIN_NODE(rootID, DIRTY);
             }
 
 			// If not there isn't enough space, we need to split the root leaf and wrap it in an index node.
             else {
 				PageID newPageID;
 				KeyType newPageFirstKey;
+				KeyView indexKey;
+				RecordID indexRid;
 
-				if (SplitLeafNode(key, rid, rootleaf, newPageID, newPageFirstKey) != OK){
-					UNPIN (rootID, CLEAN);
+				if (SplitLeafNode(key, rid, rootleaf, newPageID, newPageFirstKey, indexKey.length, indexRid) != OK){
+					UNPIN_NODE(rootID, CLEAN);
 					return FAIL;
 				}
 
@@ -439,13 +919,14 @@ Status BTreeFile::Insert (const char *key, const RecordID rid)
 				rootindex->SetType(INDEX_NODE);
 				rootindex->SetPrevPage(rootID);
 
-				if (rootindex->Insert(newPageFirstKey, newPageID, newRecordID) != OK) {
+				indexKey.key = newPageFirstKey;
+				if (rootindex->Insert(indexKey, indexRid, newPageID, newRecordID) != OK) {
 					UNPIN(newIndexPageID, CLEAN);
-					UNPIN(rootID, DIRTY);
+					UNPIN_NODE(rootID, DIRTY);
 					return FAIL;
 				}
                 header->SetRootPageID(newIndexPageID);
-				UNPIN(rootID, DIRTY);
+				UNPIN_NODE(rootID, DIRTY);
                 UNPIN(newIndexPageID, DIRTY);
             }
         }
@@ -454,11 +935,6 @@ Status BTreeFile::Insert (const char *key, const RecordID rid)
             SortedPage* curPage = rootPage;
 			PageID curIndexID;
 			PageID nextPageID;
-			Status s;
-
-			RecordID curRecordID;
-			KeyType curKey;
-			PageID curPageID;
 
 			// Traverse through the index nodes, pushing their pageIDs onto a stack so we can easily
 			// move back up the tree in the event of a node split (and the need to insert a new index key)
@@ -470,19 +946,14 @@ Status BTreeFile::Insert (const char *key, const RecordID rid)
 				indexIDStack.push(curIndexID);
 
 				
-				// While our key to insert is greater than the key of the record we are current on,
-				// continue searching the index for the right path to take (get the next record)
-				nextPageID = curIndexPage->GetLeftLink();
-				s = curIndexPage->GetFirst(curRecordID, curKey, curPageID);
-				while(s != DONE && KeyCmp(key, curKey) >= 0) {
-					nextPageID = curPageID;
-					s = curIndexPage->GetNext(curRecordID, curKey, curPageID);
-				}
+				// Find the child whose range contains our (key, rid) to insert, comparing against
+				// the keys in place on the index page
+				curIndexPage->GetPageID(key, rid, nextPageID);
 
-				UNPIN(curIndexID, CLEAN);
+				UNPIN_NODE(curIndexID, CLEAN);
 
 				// Pin the page of the next node we will go to
-				PIN(nextPageID, curPage);
+				PIN_NODE(nextPageID, curPage);
             }
 
 			// At this point we have reached the leaf node that we wish to insert on
@@ -490,8 +961,8 @@ Status BTreeFile::Insert (const char *key, const RecordID rid)
 			PageID curLeafID = curLeafPage->PageNo();
 
 			// If there is space on the leaf node to insert the record/key do so.
-			if (curLeafPage->AvailableSpace() >= GetKeyDataLength(key, LEAF_NODE)) {
-				if(curLeafPage->Insert(key, rid, newRecordID) != OK) {
+			if (curLeafPage->AvailableSpace() >= LeafInsertLength(curLeafPage, key, rid)) {
+				if(LeafInsert(curLeafPage, key, rid) != OK) {
 					UNPIN(curLeafID, CLEAN);
 					return FAIL;
 				}
@@ -501,8 +972,10 @@ Status BTreeFile::Insert (const char *key, const RecordID rid)
 				// Since there is not enough space to insert in the leaf node. We need to split it and update the index nodes
 				PageID newPageID;
                 KeyType newPageFirstKey;
+				KeyView indexKey;
+				RecordID indexRid;
 
-				if (SplitLeafNode(key, rid, curLeafPage, newPageID, newPageFirstKey) != OK){
+				if (SplitLeafNode(key, rid, curLeafPage, newPageID, newPageFirstKey, indexKey.length, indexRid) != OK){
 					UNPIN (curLeafID, CLEAN);
 					return FAIL;
 				}
@@ -516,34 +989,38 @@ Status BTreeFile::Insert (const char *key, const RecordID rid)
 				// Try to insert the key of the leftmost record of the new page created by the split
 				// If necessary, split the index node and loop, now attempting to add the duplicate key
 				// from the index split into the index node one level above
-				char *indexKey = newPageFirstKey;
+				indexKey.key = newPageFirstKey;
+				KeyType promotedKey;
                 while (continuesplit) {
 					// Peek at the top of the stack and pin the index page
 					tmpIndexID = indexIDStack.top();
-					PIN(tmpIndexID, tmpIndexPage);
+					PIN_NODE(tmpIndexID, tmpIndexPage);
 
 					// If there is enough space in this node to insert our key, do so and terminate the loop.
-					if (tmpIndexPage->AvailableSpace() >= GetKeyDataLength(indexKey, INDEX_NODE)) {
+					if (tmpIndexPage->AvailableSpace() >= GetKeyDataLength(indexKey, indexRid)) {
 						
-						if (tmpIndexPage->Insert(indexKey, newPageID, newRecordID) != OK){
-							UNPIN(tmpIndexID, CLEAN);
+						if (tmpIndexPage->Insert(indexKey, indexRid, newPageID, newRecordID) != OK){
+							UNPIN_NODE(tmpIndexID, CLEAN);
 							return FAIL;
 						}
 						continuesplit = false;
-						UNPIN(tmpIndexID, DIRTY);
+						UNPIN_NODE(tmpIndexID, DIRTY);
 					}
 					// If there is not enough space, split the index node and loop with the desired insertion key set to
 					// the (now deleted) leftmost entry that was returned from splitIndexNode()
 					else {
 						PageID newPageID2;
-						KeyType newPageFirstKey2;
-						if (SplitIndexNode(newPageFirstKey, newPageID, tmpIndexPage, newPageID2, newPageFirstKey2) != OK){
-							UNPIN(tmpIndexID, CLEAN);
+						int promotedLen;
+						RecordID promotedRid;
+						if (SplitIndexNode(indexKey, indexRid, newPageID, tmpIndexPage, newPageID2, promotedKey, promotedLen, promotedRid) != OK){
+							UNPIN_NODE(tmpIndexID, CLEAN);
 							return FAIL;
 						}
 						newPageID = newPageID2;
-						indexKey = newPageFirstKey2;
-						UNPIN(tmpIndexID, DIRTY);
+						memcpy(newPageFirstKey, promotedKey, promotedLen);
+						indexKey.length = promotedLen;
+						indexRid = promotedRid;
+						UNPIN_NODE(tmpIndexID, DIRTY);
 
 						// Remove the processed indexNodePageID from the stack
 						indexIDStack.pop();
@@ -561,7 +1038,7 @@ Status BTreeFile::Insert (const char *key, const RecordID rid)
 							newIndexPage->SetType(INDEX_NODE);
 							newIndexPage->SetPrevPage(tmpIndexID);
 
-							if (newIndexPage->Insert(indexKey, newPageID, newRecordID) != OK) {
+							if (newIndexPage->Insert(indexKey, indexRid, newPageID, newRecordID) != OK) {
 								UNPIN(newIndexPageID, CLEAN);
 								return FAIL;
 							}
@@ -576,6 +1053,9 @@ Status BTreeFile::Insert (const char *key, const RecordID rid)
 		}
 	}
 
+	if (BloomRebuildStep() != OK)
+		cerr << "Unable to continue rebuilding the Bloom filter" << endl;
+
 	return OK;
 }
 
@@ -594,28 +1074,48 @@ Status BTreeFile::Insert (const char *key, const RecordID rid)
 
 Status BTreeFile::Delete (const char *key, const RecordID rid)
 {
-	if (header->GetRootPageID() == INVALID_PAGE) return FAIL;
+	return Delete(MakeKeyView(key), rid);
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::Delete
+//
+// Input   : key - the value of the key to be deleted.
+//           rid - RecordID of the record to be deleted.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise. 
+// Purpose : Delete an entry with this rid and key.  
+//-------------------------------------------------------------------
+
+Status BTreeFile::Delete (const KeyView &key, const RecordID rid)
+{
+	if (readOnly || header->GetRootPageID() == INVALID_PAGE) return FAIL;
+
+	hints.Forget(GetKeyHash(key));
 		
 	// A root page exists
 	PageID rootID = header->GetRootPageID();
 	SortedPage *rootPage;
-	PIN(rootID, rootPage);
+	PIN_NODE(rootID, rootPage);
 
 	// Check if the root is a leaf node (trivial case)
-	if (rootPage->GetType() == LEAF_NODE) {
-		BTLeafPage *curPage = (BTLeafPage *) rootPage;
-		if (curPage->Delete(key,rid) != OK) {
-			UNPIN(rootID, CLEAN);
+	if (rootPage->GetType() != INDEX_NODE) {
+		SortedPage *curPage = rootPage;
+		if (LeafDelete(curPage, key, rid) != OK) {
+			UNPIN_NODE(rootID, CLEAN);
 			return FAIL;
 		}
 
 		// If the root page is now empty we need to delete it
 		if (curPage->IsEmpty()){
+			hints.ForgetAll();
+			if (bloomRebuild.nextLeafID == rootID)
+				bloomRebuild.nextLeafID = INVALID_PAGE;
 			FREEPAGE(rootID);
 			header->SetRootPageID(INVALID_PAGE);
 		}
 		else {
-			UNPIN (rootID, DIRTY);
+			UNPIN_NODE(rootID, DIRTY);
 		}
 	}
 	else{
@@ -623,11 +1123,6 @@ Status BTreeFile::Delete (const char *key, const RecordID rid)
         SortedPage* curPage = rootPage;
 		PageID curIndexID;
 		PageID nextPageID;
-		Status s;
-
-		RecordID curRecordID;
-		KeyType curKey;
-		PageID curPageID;
 
 		// For each visited index node, push it onto the stack (required from redistribution/merge extra credit - Not yet implemented)
 		stack<PageID> indexIDStack;
@@ -637,115 +1132,1391 @@ Status BTreeFile::Delete (const char *key, const RecordID rid)
 
 			indexIDStack.push(curIndexID);
 
-			nextPageID = curIndexPage->GetLeftLink();
-			s = curIndexPage->GetFirst(curRecordID, curKey, curPageID);
-
-			// While our key is greater than the key of the current record, continue searching the index for the right path to take
-			// by getting the next record on the page
-			while(s != DONE && KeyCmp(key, curKey) >= 0) {
-				nextPageID = curPageID;
-				s = curIndexPage->GetNext(curRecordID, curKey, curPageID);
-			}
+			// Find the child whose range contains our (key, rid), comparing against the keys in place
+			// on the index page. Since separators carry record ids, this is the one leaf that can
+			// hold the entry, however many other entries share its key.
+			curIndexPage->GetPageID(key, rid, nextPageID);
 			
-			UNPIN(curIndexID, CLEAN);
+			UNPIN_NODE(curIndexID, CLEAN);
 
 			// Pin the page of the next node to visit
-			PIN(nextPageID, curPage);
+			PIN_NODE(nextPageID, curPage);
         }
 
-		BTLeafPage *curLeafPage = (BTLeafPage *) curPage;
-		PageID curLeafID = curLeafPage->PageNo();
+		PageID curLeafID = curPage->PageNo();
 
-		// Check if this is the first key on the page. NOT NEEDEED ANYMORE, SEE PIAZZA POST @202
-		RecordID curVal;
-		if (curLeafPage->GetFirst(curRecordID, curKey, curVal) != OK) {
-			std::cout << "GetFirst failed for pageNo" << curLeafPage->PageNo() << std::endl;
+		// Simply delete the entry from the leaf page (leaves are not merged, see PIAZZA POST @202)
+		if (LeafDelete(curPage, key, rid) != OK) {
+			std::cout << "Delete failed for thing with key= ";
+			std::cout.write(key.key, key.length) << std::endl;
 			UNPIN(curLeafID, CLEAN);
 			return FAIL;
 		}
+		UNPIN (curLeafID, DIRTY);
+	}
 
-		// THIS HAS BEEN REMOVED DUE TO PIAZZA POST @202
-		if (false && KeyCmp(curKey, key) == 0 && curVal == rid) {
-			// It is the first one
-			// TODO: IMPLEMENT
+	// Deleted keys stay in the Bloom filter, so start building a new one once more than
+	// half of the entries it was built with or has had added are gone.  The entry is
+	// deleted whatever becomes of the rebuild, which only costs false positives.
+	if (header->GetBloomPageID() != INVALID_PAGE) {
+		header->SetBloomCounts(header->GetBloomNumEntries(), header->GetBloomNumDeletes() + 1);
+		if (header->GetBloomNumDeletes() > header->GetBloomNumEntries() / 2 &&
+			header->GetBloomRebuildPageID() == INVALID_PAGE &&
+			StartBloomRebuild() != OK)
+			cerr << "Unable to start rebuilding the Bloom filter" << endl;
+	}
 
-			if (curLeafPage->Delete(key,rid) != OK) {
+	if (BloomRebuildStep() != OK)
+		cerr << "Unable to continue rebuilding the Bloom filter" << endl;
 
-				UNPIN(curLeafID, CLEAN);
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTreeFile::LeafInsertLength
+//
+// Input   : leaf - a leaf page of either format.
+//           key, rid - the entry to be inserted.
+// Output  : None
+// Return  : The space on leaf the entry would use.
+//-------------------------------------------------------------------
+
+int BTreeFile::LeafInsertLength (SortedPage *leaf, const KeyView &key, const RecordID rid)
+{
+	if (leaf->GetType() == POSTING_NODE)
+		return ((BTPostingPage *) leaf)->GetInsertLength(key, rid);
+	return GetKeyDataLength(key, LEAF_NODE);
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::LeafInsert
+//
+// Input   : leaf - a leaf page of either format.
+//           key, rid - the entry to be inserted.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Insert an entry into a leaf that has room for it.
+//-------------------------------------------------------------------
+
+Status BTreeFile::LeafInsert (SortedPage *leaf, const KeyView &key, const RecordID rid)
+{
+	RecordID newRecordID;
+
+	if (leaf->GetType() == POSTING_NODE)
+		return ((BTPostingPage *) leaf)->Insert(key, rid);
+	return ((BTLeafPage *) leaf)->Insert(key, rid, newRecordID);
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::LeafDelete
+//
+// Input   : leaf - a leaf page of either format.
+//           key, rid - the entry to be deleted.
+// Output  : None
+// Return  : OK if successful, FAIL if the entry is not on leaf.
+//-------------------------------------------------------------------
+
+Status BTreeFile::LeafDelete (SortedPage *leaf, const KeyView &key, const RecordID rid)
+{
+	if (leaf->GetType() == POSTING_NODE)
+		return ((BTPostingPage *) leaf)->Delete(key, rid);
+	return ((BTLeafPage *) leaf)->Delete(key, rid);
+}
+
+
+//-------------------------------------------------------------------
+// BTreeFile::OpenScan
+//
+// Input   : lowKey, highKey - pointer to keys, indicate the range
+//                             to scan.
+// Output  : None
+// Return  : A pointer to IndexFileScan class.
+// Purpose : Initialize a scan.  
+// Note    : Usage of lowKey and highKey :
+//
+//           lowKey   highKey   range
+//			 value	  value	
+//           --------------------------------------------------
+//           NULL     NULL      whole index
+//           NULL     !NULL     minimum to highKey
+//           !NULL    NULL      lowKey to maximum
+//           !NULL    =lowKey   exact match (may not be unique)
+//           !NULL    >lowKey   lowKey to highKey
+//-------------------------------------------------------------------
+
+IndexFileScan *BTreeFile::OpenScan (const char *lowKey, const char *highKey)
+{
+	KeyView low, high;
+
+	low.key = NULL;
+	low.length = 0;
+	high = low;
+
+	if (lowKey != NULL)
+		low = MakeKeyView(lowKey);
+	if (highKey != NULL)
+		high = MakeKeyView(highKey);
+
+	return OpenScan(low, high);
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::OpenScan
+//
+// Input   : lowKey, highKey - the keys that bound the range to scan.
+//                             A view whose key is NULL leaves that
+//                             end of the range open.
+// Output  : None
+// Return  : A pointer to IndexFileScan class.
+// Purpose : Initialize a scan over keys of any bytes.  See above for
+//           the ranges that can be scanned.
+//-------------------------------------------------------------------
+
+IndexFileScan *BTreeFile::OpenScan (const KeyView &lowKey, const KeyView &highKey)
+{
+	
+	BTreeFileScan *newScan = new BTreeFileScan();
+
+	// The empty key sorts below every other key
+	KeyView searchKey = lowKey;
+	if (searchKey.key == NULL) {
+		searchKey.key = "";
+		searchKey.length = 0;
+	}
+
+	PageID leftmostPageID;
+	bool mayContain = true;
+
+	// An exact match on a key the Bloom filter does not hold finds nothing
+	if (lowKey.key != NULL && highKey.key != NULL && KeyCmp(lowKey, highKey) == 0 &&
+		BloomMayContain(lowKey, mayContain) != OK) {
+		mayContain = true;
+	}
+
+	if (!mayContain || Search(searchKey,leftmostPageID) != OK) {
+		leftmostPageID = INVALID_PAGE;
+	}
+
+	newScan->Init(lowKey.key != NULL ? &lowKey : NULL,
+		highKey.key != NULL ? &highKey : NULL, leftmostPageID);
+
+	return newScan;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::OpenPrefixScan
+//
+// Input   : prefix - the leading bytes of the keys to scan, such as
+//                    the leading columns of a CompositeKey.
+// Output  : None
+// Return  : A pointer to IndexFileScan class, NULL if the prefix is
+//           longer than a key can be.
+// Purpose : Initialize a scan over all keys that begin with prefix.
+// Note    : The high end of the range is prefix padded with 0xFF to
+//           the longest key there can be, which no key beginning with
+//           prefix sorts above.
+//-------------------------------------------------------------------
+
+IndexFileScan *BTreeFile::OpenPrefixScan (const KeyView &prefix)
+{
+	KeyType high;
+	KeyView highKey;
+
+	if (prefix.length < 0 || prefix.length > MAX_KEY_SIZE - 1)
+		return NULL;
+
+	memcpy(high, prefix.key, prefix.length);
+	memset(high + prefix.length, 0xFF, MAX_KEY_SIZE - 1 - prefix.length);
+	highKey.key = high;
+	highKey.length = MAX_KEY_SIZE - 1;
+
+	return OpenScan(prefix, highKey);
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::Lookup
+//
+// Input   : key - pointer to the key to look up.
+//           rids - buffer for the record ids found.
+//           maxRids - number of record ids rids can hold.
+// Output  : numRids - number of record ids written to rids.
+// Return  : OK if every entry with key was returned, DONE if rids
+//           filled up first, FAIL on error.
+// Purpose : Find all entries with key, without opening a scan.
+//-------------------------------------------------------------------
+
+Status BTreeFile::Lookup (const char *key, RecordID *rids, int maxRids, int &numRids)
+{
+	return Lookup(MakeKeyView(key), rids, maxRids, numRids);
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::Lookup
+//
+// Input   : key - the key to look up, which may be any sequence of
+//                 bytes.
+//           rids, maxRids - as above.
+// Output  : numRids - as above.
+// Return  : As above.
+// Purpose : Find all entries with key, without opening a scan.  A key
+//           with a hint in the adaptive hash index goes straight to
+//           its leaf.  Other keys descend from the root, and a key
+//           looked up often enough leaves a hint for the next lookup.
+//-------------------------------------------------------------------
+
+Status BTreeFile::Lookup (const KeyView &key, RecordID *rids, int maxRids, int &numRids)
+{
+	unsigned long long hash = GetKeyHash(key);
+	PageID leafID;
+	SortedPage *leaf;
+	int slot;
+	bool mayContain;
+	Status s;
+
+	if (hints.Find(hash, leafID, slot)) {
+		PIN(leafID, leaf);
+		if (IsHintValid(leaf, slot, key)) {
+			s = CollectRids(leaf, slot, key, rids, maxRids, numRids);
+			UNPIN(leafID, CLEAN);
+			return s;
+		}
+		UNPIN(leafID, CLEAN);
+		hints.Forget(hash);
+	}
+
+	if (!hints.Touch(hash))
+		return MultiGet(&key, 1, rids, maxRids, &numRids);
+
+	// A hot key: find its leaf, and leave a hint to its first entry
+	numRids = 0;
+	if (header->GetRootPageID() == INVALID_PAGE)
+		return OK;
+	if (BloomMayContain(key, mayContain) != OK)
+		return FAIL;
+	if (!mayContain)
+		return OK;
+	if (Search(key, leafID) != OK)
+		return FAIL;
+
+	PIN(leafID, leaf);
+	slot = leaf->LowerBound(key);
+	if (IsHintValid(leaf, slot, key))
+		hints.Record(hash, leafID, slot);
+	s = CollectRids(leaf, slot, key, rids, maxRids, numRids);
+	UNPIN(leafID, CLEAN);
+	return s;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::MultiGet
+//
+// Input   : keys - the keys to look up, in ascending order.
+//           numKeys - number of keys.
+//           rids - buffer for the record ids found.
+//           maxRids - number of record ids rids can hold.
+// Output  : numRids - numRids[i] is the number of record ids found for
+//                     keys[i].  They are stored in rids one key after
+//                     another, in the order of the keys.
+// Return  : OK if every entry was returned, DONE if rids filled up
+//           first (the keys after that get no record ids), FAIL on
+//           error.
+// Purpose : Look up a batch of keys.  The pages from the root to the
+//           leaf of the last key stay pinned, and each key descends
+//           only from the lowest of them whose range still covers it,
+//           so neighbouring keys share most of their path.  Nothing
+//           is allocated on the heap.  Keys the Bloom filter does not
+//           hold are skipped without a search.
+// Note    : Keys out of order are still found, but descend from the
+//           root.
+//-------------------------------------------------------------------
+
+Status BTreeFile::MultiGet (const KeyView *keys, int numKeys, RecordID *rids, int maxRids, int *numRids)
+{
+	PageID pathIDs[MAX_TREE_HEIGHT];        // pinned pages, from the root to a leaf
+	SortedPage *pathPages[MAX_TREE_HEIGHT];
+	int pathSlots[MAX_TREE_HEIGHT];         // slot of the child followed from each index page
+	int height = 0;                         // number of pages on the path
+	const KeyView *pathKey = NULL;          // the key that led down the path
+	int totalRids = 0;
+	Status s = OK;
+
+	for (int i = 0; i < numKeys; i++)
+		numRids[i] = 0;
+
+	if (header->GetRootPageID() == INVALID_PAGE)
+		return OK;
+
+	for (int i = 0; i < numKeys && s == OK; i++) {
+		bool mayContain;
+
+		if (BloomMayContain(keys[i], mayContain) != OK) {
+			s = FAIL;
+			break;
+		}
+		if (!mayContain)
+			continue;
+
+		// Find the lowest page on the path that covers keys[i]. pathKey led to each page,
+		// so a page covers every key from that one up to, but not including, the next
+		// separator in its parent. The root covers every key.
+		int level = 0;
+		if (height > 0 && KeyCmp(keys[i], *pathKey) >= 0) {
+			for (level = height - 1; level > 0; level--) {
+				BTIndexPage *parent = (BTIndexPage *) pathPages[level - 1];
+				int next = pathSlots[level - 1] + 1;
+				if (next < parent->GetNumOfRecords() &&
+					KeyCmp(keys[i], LOWEST_RID, parent->GetKeyView(next), parent->GetKeyRid(next)) < 0)
+					break;
+			}
+		}
+
+		// Unpin the pages below it and descend from there to the leaf.  On an
+		// error the pages still on the path are unpinned below the loop.
+		while (height > level + 1) {
+			height--;
+			if (UnpinNode(pathIDs[height], CLEAN) != OK)
+				s = FAIL;
+		}
+		if (s != OK)
+			break;
+		if (height == 0) {
+			pathIDs[0] = header->GetRootPageID();
+			if (PinNode(pathIDs[0], pathPages[0]) != OK) {
+				s = FAIL;
+				break;
+			}
+			height = 1;
+		}
+		while (pathPages[height - 1]->GetType() == INDEX_NODE) {
+			BTIndexPage *index = (BTIndexPage *) pathPages[height - 1];
+
+			if (height == MAX_TREE_HEIGHT) {
+				cerr << "Tree is too high in BTreeFile::MultiGet" << endl;
+				s = FAIL;
+				break;
+			}
+			pathSlots[height - 1] = index->UpperBound(keys[i]) - 1;
+			pathIDs[height] = index->GetChild(pathSlots[height - 1]);
+			if (PinNode(pathIDs[height], pathPages[height]) != OK) {
+				s = FAIL;
+				break;
+			}
+			height++;
+		}
+		pathKey = &keys[i];
+
+		if (s == OK) {
+			s = CollectRids(pathPages[height - 1], pathPages[height - 1]->LowerBound(keys[i]), keys[i], rids + totalRids, maxRids - totalRids, numRids[i]);
+			totalRids += numRids[i];
+		}
+	}
+
+	while (height > 0) {
+		height--;
+		if (UnpinNode(pathIDs[height], CLEAN) != OK)
+			s = FAIL;
+	}
+
+	return s;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::MultiGetInterleaved
+//
+// Input   : keys - the keys to look up, in any order.
+//           numKeys - number of keys.
+//           rids - buffer for the record ids found.
+//           maxRids - number of record ids rids can hold.
+// Output  : numRids - as for MultiGet.
+// Return  : As for MultiGet.
+// Purpose : Look up a batch of keys that are not sorted, such as the
+//           probes of a hash join.  Lookups go LOOKUP_GROUP_SIZE at a
+//           time, and a group descends the tree together, one level
+//           per round.  Each lookup pins its next page and prefetches
+//           it, then leaves it until the rest of the group has taken
+//           its step, so that the cache misses of the group overlap
+//           instead of following one another.  Keys the Bloom filter
+//           does not hold never join a group.
+//-------------------------------------------------------------------
+
+Status BTreeFile::MultiGetInterleaved (const KeyView *keys, int numKeys, RecordID *rids, int maxRids, int *numRids)
+{
+	int group[LOOKUP_GROUP_SIZE];           // the keys being looked up together
+	PageID pageIDs[LOOKUP_GROUP_SIZE];
+	SortedPage *pages[LOOKUP_GROUP_SIZE];
+	int totalRids = 0;
+	int next = 0;
+	Status s = OK;
+
+	for (int i = 0; i < numKeys; i++)
+		numRids[i] = 0;
+
+	if (header->GetRootPageID() == INVALID_PAGE)
+		return OK;
+
+	while (next < numKeys && s == OK) {
+		int groupSize = 0;
+		bool moved;
+
+		while (next < numKeys && groupSize < LOOKUP_GROUP_SIZE) {
+			bool mayContain;
+
+			if (BloomMayContain(keys[next], mayContain) != OK)
+				return FAIL;
+			if (mayContain)
+				group[groupSize++] = next;
+			next++;
+		}
+
+		// Every lookup below numPinned holds exactly one pinned page, which
+		// the last loop unpins whether or not an error stopped the descent.
+		int numPinned = 0;
+		for (; numPinned < groupSize; numPinned++) {
+			pageIDs[numPinned] = header->GetRootPageID();
+			if (PinNode(pageIDs[numPinned], pages[numPinned]) != OK) {
+				s = FAIL;
+				break;
+			}
+		}
+
+		// Take every lookup of the group down one level per round, until all are on leaves
+		do {
+			moved = false;
+			for (int j = 0; j < groupSize && s == OK; j++) {
+				if (pages[j]->GetType() != INDEX_NODE)
+					continue;
+
+				BTIndexPage *index = (BTIndexPage *) pages[j];
+				PageID childID = index->GetChild(index->UpperBound(keys[group[j]]) - 1);
+				SortedPage *child;
+
+				if (PinNode(childID, child) != OK) {
+					s = FAIL;
+					break;
+				}
+				if (UnpinNode(pageIDs[j], CLEAN) != OK)
+					s = FAIL;
+				pageIDs[j] = childID;
+				pages[j] = child;
+				pages[j]->Prefetch();
+				moved = true;
+			}
+		} while (moved && s == OK);
+
+		for (int j = 0; j < numPinned; j++) {
+			if (s == OK) {
+				s = CollectRids(pages[j], pages[j]->LowerBound(keys[group[j]]), keys[group[j]], rids + totalRids, maxRids - totalRids, numRids[group[j]]);
+				totalRids += numRids[group[j]];
+			}
+			if (UnpinNode(pageIDs[j], CLEAN) != OK)
+				s = FAIL;
+		}
+	}
+
+	return s;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::CollectRids
+//
+// Input   : leaf - the pinned leaf a search for key led to.
+//           slotNo - the first slot of leaf not below key.
+//           key - the key to look up.
+//           rids - buffer for the record ids found.
+//           maxRids - number of record ids rids can hold.
+// Output  : numRids - number of record ids written to rids.
+// Return  : OK if every entry with key was returned, DONE if rids
+//           filled up first, FAIL on error.
+// Purpose : Copy out the record ids of the entries with key, starting
+//           at slotNo and following the leaf chain while they continue.
+//           leaf is left pinned; the pages after it are unpinned.
+//-------------------------------------------------------------------
+
+Status BTreeFile::CollectRids (SortedPage *leaf, int slotNo, const KeyView &key, RecordID *rids, int maxRids, int &numRids)
+{
+	SortedPage *page = leaf;
+	PageID pageID = INVALID_PAGE;   // set once we have moved past leaf
+	int slot = slotNo;
+	Status s = OK;
+	bool done = false;
+
+	numRids = 0;
+
+	while (!done) {
+		for (; slot < page->GetNumOfRecords(); slot++) {
+			if (KeyCmp(key, page->GetKeyView(slot)) != 0) {
+				done = true;
+				break;
+			}
+
+			if (page->GetType() == POSTING_NODE) {
+				BTPostingPage *posting = (BTPostingPage *) page;
+				PostingCursor cursor;
+				RecordID rid;
+
+				posting->InitCursor(slot, cursor);
+				while (numRids < maxRids && posting->NextRid(slot, cursor, rid) == OK)
+					rids[numRids++] = rid;
+				if (numRids == maxRids && posting->NextRid(slot, cursor, rid) == OK)
+					s = DONE;
+			}
+			else if (numRids < maxRids) {
+				rids[numRids++] = ((BTLeafPage *) page)->GetDataRid(slot);
+			}
+			else {
+				s = DONE;
+			}
+
+			if (s != OK) {
+				done = true;
+				break;
+			}
+		}
+
+		// Entries with key may continue on the next leaf
+		if (!done) {
+			PageID nextPageID = page->GetNextPage();
+
+			if (pageID != INVALID_PAGE)
+				UNPIN(pageID, CLEAN);
+			pageID = INVALID_PAGE;
+
+			if (nextPageID == INVALID_PAGE)
+				return s;
+
+			pageID = nextPageID;
+			PIN(pageID, page);
+			slot = 0;
+		}
+	}
+
+	if (pageID != INVALID_PAGE)
+		UNPIN(pageID, CLEAN);
+	return s;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::IsHintValid
+//
+// Input   : leaf - the pinned page a hint for key points to.
+//           slotNo - the slot the hint points to.
+//           key - the key being looked up.
+// Output  : None
+// Return  : true if slotNo holds the first entry of the tree with key.
+// Purpose : Check a hint of the adaptive hash index (see bthint.h).  A
+//           hint may be stale, or even belong to another key with the
+//           same hash.  It is good if the entry at slotNo has key and
+//           the one before it on the same leaf has a smaller key, so
+//           that no earlier leaf can hold key either.  A first entry
+//           at slot 0 cannot be told apart from a later one this way,
+//           so such hints are never recorded.
+//-------------------------------------------------------------------
+
+bool BTreeFile::IsHintValid (SortedPage *leaf, int slotNo, const KeyView &key)
+{
+	return leaf->GetType() == header->GetLeafType() &&
+		slotNo > 0 && slotNo < leaf->GetNumOfRecords() &&
+		KeyCmp(key, leaf->GetKeyView(slotNo)) == 0 &&
+		KeyCmp(leaf->GetKeyView(slotNo - 1), key) < 0;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::CreateBloomFilter
+//
+// Input   : expectedKeys - number of entries the filter should be
+//                          sized for.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Give the tree a Bloom filter of its keys (see btbloom.h),
+//           replacing any it had, and fill it from the leaves.  From
+//           then on Insert keeps it up to date, and lookups and exact
+//           scans consult it before searching.
+//-------------------------------------------------------------------
+
+Status BTreeFile::CreateBloomFilter (int expectedKeys)
+{
+	PageID firstPageID;
+	Page *firstPage;
+	int numPages = (int)(((long long)expectedKeys * BLOOM_BITS_PER_KEY + BLOOM_PAGE_BITS - 1) / BLOOM_PAGE_BITS);
+
+	if (readOnly)
+		return FAIL;
+
+	if (numPages < 1)
+		numPages = 1;
+
+	if (DestroyBloomFilter() != OK)
+		return FAIL;
+
+	if (MINIBASE_BM->NewPage(firstPageID, firstPage, numPages) != OK) {
+		cerr << "Unable to allocate " << numPages << " Bloom filter pages" << endl;
+		return FAIL;
+	}
+	UNPIN(firstPageID, DIRTY);
+
+	header->SetBloomFilter(firstPageID, numPages);
+	return RebuildBloomFilter();
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::RebuildBloomFilter
+//
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Clear the Bloom filter and add the keys of all entries on
+//           the leaves, dropping the keys that have been deleted.
+//           This does the whole rebuild at once; the one Delete starts
+//           once enough entries are gone is spread over the inserts
+//           and deletes after it (see BloomRebuildStep), and is given
+//           up here.
+//-------------------------------------------------------------------
+
+Status BTreeFile::RebuildBloomFilter ()
+{
+	PageID firstPageID = header->GetBloomPageID();
+	int numPages = header->GetBloomNumPages();
+	int numEntries = 0;
+	KeyView emptyKey;
+	PageID leafID;
+
+	if (readOnly)
+		return FAIL;
+
+	if (firstPageID == INVALID_PAGE)
+		return OK;
+
+	if (FreeBloomPages(header->GetBloomRebuildPageID(), numPages) != OK)
+		return FAIL;
+	header->SetBloomRebuild(INVALID_PAGE, 0);
+
+	for (int i = 0; i < numPages; i++) {
+		BTBloomPage *bloomPage;
+
+		if (MINIBASE_BM->PinPage(firstPageID + i, (Page *&)bloomPage, true) != OK) {
+			cerr << "Unable to pin page " << firstPageID + i << endl;
+			return FAIL;
+		}
+		bloomPage->Clear();
+		UNPIN(firstPageID + i, DIRTY);
+	}
+
+	// Walk the leaf chain from the leftmost leaf
+	emptyKey.key = "";
+	emptyKey.length = 0;
+	if (Search(emptyKey, leafID) == FAIL)
+		return FAIL;
+
+	while (leafID != INVALID_PAGE) {
+		SortedPage *leaf;
+
+		PIN(leafID, leaf);
+		for (int slot = 0; slot < leaf->GetNumOfRecords(); slot++) {
+			if (BloomAdd(leaf->GetKeyView(slot)) != OK) {
+				UNPIN(leafID, CLEAN);
+				return FAIL;
+			}
+			if (leaf->GetType() == POSTING_NODE)
+				numEntries += ((BTPostingPage *) leaf)->GetNumOfRids(slot);
+			else
+				numEntries++;
+		}
+
+		PageID nextID = leaf->GetNextPage();
+		UNPIN(leafID, CLEAN);
+		leafID = nextID;
+	}
+
+	header->SetBloomCounts(numEntries, 0);
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::DestroyBloomFilter
+//
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Free the pages of the Bloom filter, if there is one, and
+//           of any filter being built to replace it.
+//-------------------------------------------------------------------
+
+Status BTreeFile::DestroyBloomFilter ()
+{
+	PageID firstPageID = header->GetBloomPageID();
+
+	if (readOnly)
+		return FAIL;
+
+	if (firstPageID == INVALID_PAGE)
+		return OK;
+
+	if (FreeBloomPages(header->GetBloomRebuildPageID(), header->GetBloomNumPages()) != OK ||
+		FreeBloomPages(firstPageID, header->GetBloomNumPages()) != OK)
+		return FAIL;
+
+	header->SetBloomRebuild(INVALID_PAGE, 0);
+	header->SetBloomFilter(INVALID_PAGE, 0);
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::ReclusterLeaves
+//
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Lay the leaves out on disk in key order.  Splits take new
+//           leaves from the current extent in whatever order the
+//           inserts call for, so after random inserts the leaf chain
+//           jumps about, and a range scan reads its pages out of order.
+//           If it does, every leaf is copied, in key order, into one
+//           new run of pages, and the old pages are freed.  No scan
+//           may be open on the index while this runs.
+//-------------------------------------------------------------------
+
+Status BTreeFile::ReclusterLeaves ()
+{
+	PageID leafID, lastLeafID = INVALID_PAGE;
+	KeyView emptyKey;
+	int numLeaves = 0;
+	bool inOrder = true;
+
+	if (readOnly)
+		return FAIL;
+
+	if (header->GetRootPageID() == INVALID_PAGE)
+		return OK;
+
+	// Count the leaves, and see if they are in order already
+	emptyKey.key = "";
+	emptyKey.length = 0;
+	if (Search(emptyKey, leafID) == FAIL)
+		return FAIL;
+
+	while (leafID != INVALID_PAGE) {
+		SortedPage *leaf;
+
+		if (lastLeafID != INVALID_PAGE && leafID != lastLeafID + 1)
+			inOrder = false;
+		numLeaves++;
+
+		PIN(leafID, leaf);
+		lastLeafID = leafID;
+		leafID = leaf->GetNextPage();
+		UNPIN(lastLeafID, CLEAN);
+	}
+
+	if (inOrder)
+		return OK;
+
+	// Make room for all of the leaves in one extent, or failing that,
+	// in as few of the usual size as it takes
+	if (NewLeafExtent(numLeaves) != OK && NewLeafExtent(LEAF_EXTENT_PAGES) != OK) {
+		cerr << "Unable to allocate an extent of " << LEAF_EXTENT_PAGES << " leaf pages" << endl;
+		return FAIL;
+	}
+
+	// A lone leaf is always in order, so the root is an index node
+	return _ReclusterLeaves(header->GetRootPageID());
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::_ReclusterLeaves
+//
+// Input   : indexID - an index page.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Move the leaves under indexID, from left to right, to the
+//           next pages of the leaf extent.
+//-------------------------------------------------------------------
+
+Status BTreeFile::_ReclusterLeaves (PageID indexID)
+{
+	BTIndexPage *index;
+	bool dirty = CLEAN;
+
+	PIN_NODE(indexID, index);
+
+	for (int slot = -1; slot < index->GetNumOfRecords(); slot++) {
+		PageID childID = index->GetChild(slot);
+		SortedPage *child;
+
+		if (PinNode(childID, child) != OK) {
+			UnpinNode(indexID, dirty);
+			return FAIL;
+		}
+		if (child->GetType() == INDEX_NODE) {
+			if (UnpinNode(childID, CLEAN) != OK || _ReclusterLeaves(childID) != OK) {
+				UNPIN_NODE(indexID, dirty);
 				return FAIL;
 			}
+		}
+		else {
+			PageID newChildID;
 
-			// If the page is now empty we need to delete it (and its entry) as long as it is not the leftmost link of an index node
-			if (curPage->IsEmpty()){
-				if (curLeafPage->GetPrevPage() != INVALID_PAGE){
-				
-				}
-				else{
-					// This is the leftmost page in the B+ tree, there is nothing to delete from the index
-				}
-				FREEPAGE(curLeafID);
+			if (MoveLeaf(childID, child, newChildID) != OK) {
+				UNPIN_NODE(indexID, dirty);
+				return FAIL;
 			}
-			else {
-				UNPIN (rootID, DIRTY);
+			index->SetChild(slot, newChildID);
+			dirty = DIRTY;
+		}
+	}
+
+	UNPIN_NODE(indexID, dirty);
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::MoveLeaf
+//
+// Input   : pageID, page - a pinned leaf.
+// Output  : newPageID - the page the leaf now lives on.
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Copy a leaf to a new page from the leaf extent, link its
+//           neighbours to the copy and put the old page with the free
+//           leaf pages.  The caller
+//           points the parent of the leaf at newPageID.
+// Note    : page is unpinned whether or not the leaf could be moved.
+//           On failure nothing has changed, and the new page, if
+//           there was one, goes back with the free leaf pages.  Once
+//           the copy is linked in, a page that cannot be unpinned is
+//           only reported, as the move has been made.
+//-------------------------------------------------------------------
+
+Status BTreeFile::MoveLeaf (PageID pageID, SortedPage *page, PageID &newPageID)
+{
+	PageID prevID = page->GetPrevPage();
+	PageID nextID = page->GetNextPage();
+	SortedPage *newPage;
+	SortedPage *prev = NULL;
+	SortedPage *next = NULL;
+
+	// Moved leaves go to the extent in the order they are moved in
+	if (NewLeafPage(newPageID, (Page *&) newPage, INVALID_PAGE) != OK) {
+		UNPIN(pageID, CLEAN);
+		return FAIL;
+	}
+
+	// Pin both neighbours before changing anything
+	if ((prevID != INVALID_PAGE && MINIBASE_BM->PinPage(prevID, (Page *&) prev) != OK) ||
+		(nextID != INVALID_PAGE && MINIBASE_BM->PinPage(nextID, (Page *&) next) != OK)) {
+		cerr << "Unable to pin the neighbours of leaf " << pageID << endl;
+		if (prev != NULL)
+			MINIBASE_BM->UnpinPage(prevID, CLEAN);
+		MINIBASE_BM->UnpinPage(newPageID, CLEAN);
+		MINIBASE_BM->UnpinPage(pageID, CLEAN);
+		AddFreeLeaves(newPageID, 1);
+		return FAIL;
+	}
+
+	memcpy(newPage, page, MINIBASE_PAGESIZE);
+	newPage->SetPageNo(newPageID);
+	if (prev != NULL)
+		prev->SetNextPage(newPageID);
+	if (next != NULL)
+		next->SetPrevPage(newPageID);
+
+	// Clear the old copy, so that hints into it no longer check out
+	page->Init(pageID);
+	if (bloomRebuild.nextLeafID == pageID)
+		bloomRebuild.nextLeafID = newPageID;
+
+	if ((prev != NULL && MINIBASE_BM->UnpinPage(prevID, DIRTY) != OK) ||
+		(next != NULL && MINIBASE_BM->UnpinPage(nextID, DIRTY) != OK) ||
+		MINIBASE_BM->UnpinPage(newPageID, DIRTY) != OK ||
+		MINIBASE_BM->UnpinPage(pageID, DIRTY) != OK)
+		cerr << "Unable to unpin the pages around leaf " << newPageID << endl;
+	if (AddFreeLeaves(pageID, 1) != OK)
+		cerr << "Unable to free page " << pageID << endl;
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::DefragmentLeaves
+//
+// Input   : maxLeaves - number of leaves to visit in this call.
+// Output  : passDone - true if this call finished a pass over the
+//           leaves; the next call starts another one.
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Do a bounded step of online maintenance of the leaves, so
+//           that it can be run a little at a time while the index is
+//           in use.  A pass visits the leaves from left to right, over
+//           as many calls as it takes, and merges each one into the
+//           leaf before it, when both have the same parent and the
+//           two fit on one page with a 1/DEFRAG_MIN_FREE of it to
+//           spare; the separator of the merged leaf goes from the
+//           parent.  Where it stopped is kept as a separator key, so
+//           inserts and deletes between calls do not lose the place.
+//
+//           A pass also counts the leaves that are not on the page
+//           after the leaf before them.  If the last pass found more of
+//           those than the leaf extents explain, the next one moves
+//           every leaf it keeps to a new extent, in key order, as
+//           ReclusterLeaves does.
+// Note    : A step frees the leaves it merges away and moves the ones
+//           it rewrites, and an open scan holds on to the page of the
+//           leaf it is on.  Any scan open on the index is therefore no
+//           longer valid once a step has run, even one opened between
+//           two steps of the same pass: close scans before a step, and
+//           open them again after it.
+//-------------------------------------------------------------------
+
+Status BTreeFile::DefragmentLeaves (int maxLeaves, bool &passDone)
+{
+	passDone = false;
+
+	if (readOnly)
+		return FAIL;
+
+	if (!defrag.active) {
+		defrag.active = true;
+		defrag.atStart = true;
+		defrag.rewrite = defrag.lastNumLeaves >= 0 &&
+			defrag.lastNumJumps > defrag.lastNumLeaves / LEAF_EXTENT_PAGES + 1;
+		defrag.lastLeafID = INVALID_PAGE;
+		defrag.numLeaves = 0;
+		defrag.numJumps = 0;
+
+		// Room for all of the leaves in one run, or failing that, in extents of the
+		// usual size.  With neither, the leaves stay where they are this pass.
+		if (defrag.rewrite && NewLeafExtent(defrag.lastNumLeaves) != OK &&
+			NewLeafExtent(LEAF_EXTENT_PAGES) != OK) {
+			cerr << "Unable to allocate an extent of " << LEAF_EXTENT_PAGES << " leaf pages" << endl;
+			defrag.rewrite = false;
+		}
+	}
+
+	while (maxLeaves > 0 && defrag.active) {
+		if (DefragmentParent(maxLeaves) != OK)
+			return FAIL;
+	}
+
+	passDone = !defrag.active;
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::DefragmentParent
+//
+// Input   : maxLeaves - number of leaves left to visit.
+// Output  : maxLeaves - less the leaves visited.
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Carry the current pass of DefragmentLeaves on through the
+//           children of one parent of leaves, from the one it is up
+//           to, and move the place on past them.
+//-------------------------------------------------------------------
+
+Status BTreeFile::DefragmentParent (int &maxLeaves)
+{
+	PageID indexID = header->GetRootPageID();
+	BTIndexPage *index;
+	PageID childID;
+	SortedPage *child;
+	KeyView cursorKey;
+	int slot;
+	KeyType nextKey;                        // separator of the subtree after this parent
+	KeyView nextKeyView;
+	RecordID nextRid;
+	bool hasNext = false;
+
+	if (indexID == INVALID_PAGE) {
+		defrag.active = false;
+		return OK;
+	}
+
+	PIN_NODE(indexID, index);
+	if (index->GetType() != INDEX_NODE) {
+		// A lone leaf has nothing to merge with
+		UNPIN_NODE(indexID, CLEAN);
+		defrag.active = false;
+		return OK;
+	}
+
+	// Descend to the parent of the leaf the pass is up to, keeping the lowest
+	// separator on the way that is to the right of the path
+	cursorKey.key = defrag.key;
+	cursorKey.length = defrag.atStart ? 0 : defrag.keyLen;
+	for (;;) {
+		slot = defrag.atStart ? -1 : index->UpperBound(cursorKey, defrag.rid) - 1;
+		childID = index->GetChild(slot);
+		if (PinNode(childID, child) != OK) {
+			UnpinNode(indexID, CLEAN);
+			return FAIL;
+		}
+		if (child->GetType() != INDEX_NODE)
+			break;
+
+		if (slot + 1 < index->GetNumOfRecords()) {
+			nextKeyView = index->GetKeyView(slot + 1);
+			memcpy(nextKey, nextKeyView.key, nextKeyView.length);
+			nextKeyView.key = nextKey;
+			nextRid = index->GetKeyRid(slot + 1);
+			hasNext = true;
+		}
+
+		if (UnpinNode(indexID, CLEAN) != OK) {
+			UnpinNode(childID, CLEAN);
+			return FAIL;
+		}
+		indexID = childID;
+		index = (BTIndexPage *) child;
+	}
+
+	// Visit the leaves, keeping the last one that was not merged away pinned as left.
+	// On an error, the pages still pinned are unpinned and the place stays where it
+	// was, so the next call visits these leaves again.
+	PageID leftID = INVALID_PAGE;
+	SortedPage *left = NULL;
+	bool leftDirty = CLEAN;
+	bool dirty = CLEAN;
+
+	for (;;) {
+		maxLeaves--;
+
+		int used = HEAPPAGE_DATA_SIZE - child->AvailableSpace();
+		if (left != NULL && used <= left->AvailableSpace() - HEAPPAGE_DATA_SIZE / DEFRAG_MIN_FREE) {
+			RecordID separatorRid;
+
+			if (MergeLeaves(leftID, left, childID, child) != OK) {
+				MINIBASE_BM->UnpinPage(leftID, leftDirty);
+				UnpinNode(indexID, dirty);
+				return FAIL;
+			}
+			leftDirty = DIRTY;
+
+			separatorRid.pageNo = indexID;
+			separatorRid.slotNo = slot;
+			if (index->DeleteRecord(separatorRid) != OK) {
+				cerr << "Unable to remove the separator of merged leaf " << childID << endl;
+				MINIBASE_BM->UnpinPage(leftID, DIRTY);
+				UnpinNode(indexID, dirty);
+				return FAIL;
 			}
+			dirty = DIRTY;
+			slot--;
 		}
 		else {
-			// Simply delete the entry from the leaf page
-			if (curLeafPage->Delete(key,rid) != OK) {
-				std::cout << "Delete failed for thing with key= " << key << std::endl;
-				UNPIN(curLeafID, CLEAN);
+			if (left != NULL && MINIBASE_BM->UnpinPage(leftID, leftDirty) != OK) {
+				cerr << "Unable to unpin page " << leftID << endl;
+				MINIBASE_BM->UnpinPage(childID, CLEAN);
+				UnpinNode(indexID, dirty);
 				return FAIL;
 			}
-			UNPIN (curLeafID, DIRTY);
+
+			if (defrag.rewrite && childID != defrag.lastLeafID + 1) {
+				PageID newChildID;
+
+				if (MoveLeaf(childID, child, newChildID) != OK) {
+					UnpinNode(indexID, dirty);
+					return FAIL;
+				}
+				index->SetChild(slot, newChildID);
+				dirty = DIRTY;
+
+				childID = newChildID;
+				if (MINIBASE_BM->PinPage(childID, (Page *&) child) != OK) {
+					cerr << "Unable to pin page " << childID << endl;
+					UnpinNode(indexID, dirty);
+					return FAIL;
+				}
+			}
+
+			if (defrag.lastLeafID != INVALID_PAGE && childID != defrag.lastLeafID + 1)
+				defrag.numJumps++;
+			defrag.numLeaves++;
+			defrag.lastLeafID = childID;
+
+			leftID = childID;
+			left = child;
+			leftDirty = CLEAN;
+		}
+
+		if (maxLeaves == 0 || slot + 1 >= index->GetNumOfRecords())
+			break;
+
+		slot++;
+		childID = index->GetChild(slot);
+		if (MINIBASE_BM->PinPage(childID, (Page *&) child) != OK) {
+			cerr << "Unable to pin page " << childID << endl;
+			MINIBASE_BM->UnpinPage(leftID, leftDirty);
+			UnpinNode(indexID, dirty);
+			return FAIL;
+		}
+	}
+
+	if (MINIBASE_BM->UnpinPage(leftID, leftDirty) != OK) {
+		cerr << "Unable to unpin page " << leftID << endl;
+		UnpinNode(indexID, dirty);
+		return FAIL;
+	}
+
+	// Move the place on to the next leaf, which is either under this parent or
+	// starts the next subtree
+	defrag.atStart = false;
+	if (slot + 1 < index->GetNumOfRecords()) {
+		nextKeyView = index->GetKeyView(slot + 1);
+		memcpy(defrag.key, nextKeyView.key, nextKeyView.length);
+		defrag.keyLen = nextKeyView.length;
+		defrag.rid = index->GetKeyRid(slot + 1);
+	}
+	else if (hasNext) {
+		memcpy(defrag.key, nextKey, nextKeyView.length);
+		defrag.keyLen = nextKeyView.length;
+		defrag.rid = nextRid;
+	}
+	else {
+		defrag.active = false;
+		defrag.lastNumLeaves = defrag.numLeaves;
+		defrag.lastNumJumps = defrag.numJumps;
+	}
+
+	UNPIN_NODE(indexID, dirty);
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::MergeLeaves
+//
+// Input   : leftID, left - a pinned leaf, which stays pinned.
+//           pageID, page - the pinned leaf after it, which has room
+//                          on left for all of its entries.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Move the entries of page onto left, unlink page from the
+//           leaf chain and put it with the free leaf pages.  The caller
+//           removes the separator of page from its parent.
+// Note    : page is unpinned whether or not the leaves could be
+//           merged.  On failure both are as they were.  Once page is
+//           unlinked, a page that cannot be unpinned is only reported,
+//           as the merge has been made.
+//-------------------------------------------------------------------
+
+Status BTreeFile::MergeLeaves (PageID leftID, SortedPage *left, PageID pageID, SortedPage *page)
+{
+	char saved[MINIBASE_PAGESIZE];   // left as it was, should an entry not fit after all
+	PageID nextID = page->GetNextPage();
+	SortedPage *next = NULL;
+
+	if (nextID != INVALID_PAGE && MINIBASE_BM->PinPage(nextID, (Page *&) next) != OK) {
+		cerr << "Unable to pin page " << nextID << endl;
+		MINIBASE_BM->UnpinPage(pageID, CLEAN);
+		return FAIL;
+	}
+
+	// Every entry of page is above those of left, so each one goes at the end
+	memcpy(saved, left, MINIBASE_PAGESIZE);
+	for (int slot = 0; slot < page->GetNumOfRecords(); slot++) {
+		RecordID curRid, insertedRid;
+		char *entry;
+		int len;
+
+		curRid.pageNo = pageID;
+		curRid.slotNo = slot;
+		if (page->ReturnRecord(curRid, entry, len) != OK ||
+			left->InsertRecord(entry, len, insertedRid) != OK) {
+			cerr << "Unable to move the entries of leaf " << pageID << " to leaf " << leftID << endl;
+			memcpy(left, saved, MINIBASE_PAGESIZE);
+			if (next != NULL)
+				MINIBASE_BM->UnpinPage(nextID, CLEAN);
+			MINIBASE_BM->UnpinPage(pageID, CLEAN);
+			return FAIL;
 		}
 	}
 
+	left->SetNextPage(nextID);
+	if (next != NULL)
+		next->SetPrevPage(leftID);
+
+	// Clear page, so that hints into it no longer check out
+	page->Init(pageID);
+	if (bloomRebuild.nextLeafID == pageID)
+		bloomRebuild.nextLeafID = leftID;
+
+	if ((next != NULL && MINIBASE_BM->UnpinPage(nextID, DIRTY) != OK) ||
+		MINIBASE_BM->UnpinPage(pageID, DIRTY) != OK)
+		cerr << "Unable to unpin the pages after leaf " << leftID << endl;
+	if (AddFreeLeaves(pageID, 1) != OK)
+		cerr << "Unable to free page " << pageID << endl;
 	return OK;
 }
 
+//-------------------------------------------------------------------
+// BTreeFile::BloomAdd
+//
+// Input   : key - a key being inserted.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Add key to the Bloom filter, if there is one, and to the
+//           filter being built to replace it.
+//-------------------------------------------------------------------
+
+Status BTreeFile::BloomAdd (const KeyView &key)
+{
+	PageID firstPageID = header->GetBloomPageID();
+	PageID newPageID = header->GetBloomRebuildPageID();
+	int numPages = header->GetBloomNumPages();
+
+	if (firstPageID == INVALID_PAGE)
+		return OK;
+
+	if (BloomPageAdd(firstPageID, numPages, key) != OK)
+		return FAIL;
+	header->SetBloomCounts(header->GetBloomNumEntries() + 1, header->GetBloomNumDeletes());
+
+	// A filter being rebuilt takes the key too, unless its pages are still
+	// being cleared, in which case the walk of the leaves will find it
+	if (newPageID != INVALID_PAGE && bloomRebuild.numCleared == numPages) {
+		if (BloomPageAdd(newPageID, numPages, key) != OK)
+			return FAIL;
+		header->SetBloomRebuild(newPageID, header->GetBloomRebuildNumEntries() + 1);
+	}
+	return OK;
+}
 
 //-------------------------------------------------------------------
-// BTreeFile::OpenScan
+// BTreeFile::BloomMayContain
 //
-// Input   : lowKey, highKey - pointer to keys, indicate the range
-//                             to scan.
+// Input   : key - a key being looked up.
+// Output  : mayContain - false if the key is certainly not in the
+//                        tree, true if it may be or there is no
+//                        Bloom filter.
+// Return  : OK if successful, FAIL otherwise.
+//-------------------------------------------------------------------
+
+Status BTreeFile::BloomMayContain (const KeyView &key, bool &mayContain)
+{
+	PageID firstPageID = header->GetBloomPageID();
+	BTBloomPage *bloomPage;
+	PageID pageID;
+
+	mayContain = true;
+	if (firstPageID == INVALID_PAGE)
+		return OK;
+
+	pageID = firstPageID + BTBloomPage::GetPageIndex(key, header->GetBloomNumPages());
+	PIN(pageID, bloomPage);
+	mayContain = bloomPage->MayContain(key);
+	UNPIN(pageID, CLEAN);
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::StartBloomRebuild
+//
+// Input   : None
 // Output  : None
-// Return  : A pointer to IndexFileScan class.
-// Purpose : Initialize a scan.  
-// Note    : Usage of lowKey and highKey :
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Allocate a new Bloom filter the size of the current one,
+//           for BloomRebuildStep to fill from the leaves.  Lookups
+//           keep using the current filter until the new one is done.
+//-------------------------------------------------------------------
+
+Status BTreeFile::StartBloomRebuild ()
+{
+	PageID newPageID;
+	Page *newPage;
+	int numPages = header->GetBloomNumPages();
+
+	if (MINIBASE_BM->NewPage(newPageID, newPage, numPages) != OK) {
+		cerr << "Unable to allocate " << numPages << " Bloom filter pages" << endl;
+		return FAIL;
+	}
+	UNPIN(newPageID, CLEAN);
+
+	header->SetBloomRebuild(newPageID, 0);
+	bloomRebuild.numCleared = 0;
+	bloomRebuild.atStart = true;
+	bloomRebuild.nextLeafID = INVALID_PAGE;
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::BloomRebuildStep
 //
-//           lowKey   highKey   range
-//			 value	  value	
-//           --------------------------------------------------
-//           NULL     NULL      whole index
-//           NULL     !NULL     minimum to highKey
-//           !NULL    NULL      lowKey to maximum
-//           !NULL    =lowKey   exact match (may not be unique)
-//           !NULL    >lowKey   lowKey to highKey
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Take the Bloom filter being rebuilt, if there is one,
+//           BLOOM_REBUILD_STEP pages further: first clear its pages,
+//           then add the keys of the leaves from left to right.  After
+//           the last leaf, it replaces the current filter.  Insert and
+//           Delete call this, so that no one of them pays for the whole
+//           rebuild.  Keys inserted once the pages are clear go into
+//           both filters, so none is missed whichever side of the walk
+//           they land on; MoveLeaf and MergeLeaves keep nextLeafID on
+//           the leaf chain.
 //-------------------------------------------------------------------
 
-IndexFileScan *BTreeFile::OpenScan (const char *lowKey, const char *highKey)
+Status BTreeFile::BloomRebuildStep ()
 {
-	
-	BTreeFileScan *newScan = new BTreeFileScan();
+	PageID newPageID = header->GetBloomRebuildPageID();
+	int numPages = header->GetBloomNumPages();
+	int work = BLOOM_REBUILD_STEP;
+
+	if (readOnly || newPageID == INVALID_PAGE)
+		return OK;
+
+	while (bloomRebuild.numCleared < numPages && work > 0) {
+		PageID pageID = newPageID + bloomRebuild.numCleared;
+		BTBloomPage *bloomPage;
 
-	const char *searchKey;
-	if (lowKey == NULL) {
-		searchKey = "";
+		if (MINIBASE_BM->PinPage(pageID, (Page *&)bloomPage, true) != OK) {
+			cerr << "Unable to pin page " << pageID << endl;
+			return FAIL;
+		}
+		bloomPage->Clear();
+		UNPIN(pageID, DIRTY);
+		bloomRebuild.numCleared++;
+		work--;
 	}
-	else {
-		searchKey = lowKey;
+	if (work == 0)
+		return OK;
+
+	if (bloomRebuild.atStart) {
+		KeyView emptyKey;
+
+		emptyKey.key = "";
+		emptyKey.length = 0;
+		if (Search(emptyKey, bloomRebuild.nextLeafID) == FAIL)
+			return FAIL;
+		bloomRebuild.atStart = false;
 	}
 
-	PageID leftmostPageID;
+	for (; bloomRebuild.nextLeafID != INVALID_PAGE && work > 0; work--) {
+		PageID leafID = bloomRebuild.nextLeafID;
+		int numEntries = header->GetBloomRebuildNumEntries();
+		SortedPage *leaf;
 
-	if (Search(searchKey,leftmostPageID) != OK) {
-		leftmostPageID = INVALID_PAGE;
+		PIN(leafID, leaf);
+		for (int slot = 0; slot < leaf->GetNumOfRecords(); slot++) {
+			if (BloomPageAdd(newPageID, numPages, leaf->GetKeyView(slot)) != OK) {
+				UNPIN(leafID, CLEAN);
+				return FAIL;
+			}
+			if (leaf->GetType() == POSTING_NODE)
+				numEntries += ((BTPostingPage *) leaf)->GetNumOfRids(slot);
+			else
+				numEntries++;
+		}
+		header->SetBloomRebuild(newPageID, numEntries);
+		bloomRebuild.nextLeafID = leaf->GetNextPage();
+		UNPIN(leafID, CLEAN);
 	}
+	if (bloomRebuild.nextLeafID != INVALID_PAGE)
+		return OK;
 
-	newScan->Init(lowKey, highKey, leftmostPageID);
+	// Every leaf is in: swap the new filter in and free the old one
+	PageID oldPageID = header->GetBloomPageID();
+	int numEntries = header->GetBloomRebuildNumEntries();
 
-	return newScan;
+	header->SetBloomFilter(newPageID, numPages);
+	header->SetBloomCounts(numEntries, 0);
+	header->SetBloomRebuild(INVALID_PAGE, 0);
+	bloomRebuild.atStart = true;
+	return FreeBloomPages(oldPageID, numPages);
 }
 
 
@@ -803,7 +2574,6 @@ Status BTreeFile::_DumpStatistics(PageID pageID) {
 	PageID curPageID;
 
 	RecordID curRid;
-	KeyType key;
 
 	PIN (pageID, page);
 	NodeType type = page->GetType ();
@@ -813,19 +2583,20 @@ Status BTreeFile::_DumpStatistics(PageID pageID) {
 		index = (BTIndexPage *)page;
 		curPageID = index->GetLeftLink();
 		_DumpStatistics(curPageID);
-		s=index->GetFirst(curRid, key, curPageID);
+		s=index->GetFirst(curRid, NULL, curPageID);
 		if ( s == OK) {	
 			_DumpStatistics(curPageID);
-			s = index->GetNext(curRid, key, curPageID);
+			s = index->GetNext(curRid, NULL, curPageID);
 			while ( s != DONE) {	
 				_DumpStatistics(curPageID);
-				s = index->GetNext(curRid, key, curPageID);
+				s = index->GetNext(curRid, NULL, curPageID);
 			}
 		}
 		UNPIN(pageID, CLEAN);
 		break;
 
 	case LEAF_NODE:
+	case POSTING_NODE:
 		UNPIN(pageID, CLEAN);
 		break;
 	default:		
@@ -839,18 +2610,11 @@ Status BTreeFile::__DumpStatistics (PageID pageID) {
 	SortedPage *page;
 	BTIndexPage *index;
 	BTLeafPage *leaf;
-	int i;
-	Status s;
-	PageID curPageID;
+	BTPostingPage *posting;
 	float	curFillFactor;
-	RecordID curRid;
-
-	KeyType  key;
-	RecordID dataRid;
 
 	PIN (pageID, page);
 	NodeType type = page->GetType ();
-	i = 0;
 	switch (type) {
 	case INDEX_NODE:
 		// add totalIndexPages
@@ -858,17 +2622,7 @@ Status BTreeFile::__DumpStatistics (PageID pageID) {
 		if ( hight <= 0) // still not reach the bottom
 			hight--;
 		index = (BTIndexPage *)page;
-		curPageID = index->GetLeftLink();
-		s=index->GetFirst (curRid , key, curPageID); 
-		if ( s == OK) {	
-			i++;
-			s = index->GetNext(curRid, key, curPageID);
-			while (s != DONE) {	
-				i++;
-				s = index->GetNext(curRid, key, curPageID);
-			}
-		}
-		totalNumIndex  += i;
+		totalNumIndex  += index->GetNumOfRecords();
 		curFillFactor = (float)(1.0 - 1.0*(index->AvailableSpace())/MAX_SPACE);
 		if ( maxIndexFillFactor < curFillFactor)
 			maxIndexFillFactor = curFillFactor;
@@ -885,16 +2639,7 @@ Status BTreeFile::__DumpStatistics (PageID pageID) {
 		totalDataPages++;
 
 		leaf = (BTLeafPage *)page;
-		s = leaf->GetFirst (curRid, key, dataRid);
-		if (s == OK) {	
-			s = leaf->GetNext(curRid, key, dataRid);
-			i++;
-			while ( s != DONE) {	
-				i++;	
-				s = leaf->GetNext(curRid, key, dataRid);
-			}
-		}
-		totalNumData += i;
+		totalNumData += leaf->GetNumOfRecords();
 		curFillFactor = (float)(1.0 - 1.0*leaf->AvailableSpace()/MAX_SPACE);
 		if ( maxDataFillFactor < curFillFactor)
 			maxDataFillFactor = curFillFactor;
@@ -903,6 +2648,24 @@ Status BTreeFile::__DumpStatistics (PageID pageID) {
 		totalFillData += curFillFactor;
 		UNPIN(pageID, CLEAN);
 		break;
+
+	case POSTING_NODE:
+		// same as a leaf, but every entry of a posting page holds a list of data entries
+		if ( hight < 0)
+			hight = -hight;
+		totalDataPages++;
+
+		posting = (BTPostingPage *)page;
+		for (int i = 0; i < posting->GetNumOfRecords(); i++)
+			totalNumData += posting->GetNumOfRids(i);
+		curFillFactor = (float)(1.0 - 1.0*posting->AvailableSpace()/MAX_SPACE);
+		if ( maxDataFillFactor < curFillFactor)
+			maxDataFillFactor = curFillFactor;
+		if ( minDataFillFactor > curFillFactor)
+			minDataFillFactor = curFillFactor;
+		totalFillData += curFillFactor;
+		UNPIN(pageID, CLEAN);
+		break;
 	default:		
 		assert (0);
 	}
@@ -916,17 +2679,17 @@ Status BTreeFile::__DumpStatistics (PageID pageID) {
 //			: currIndexID, 
 //			: curIndex, pointer to current BTIndexPage
 // OUTPUT	: found PageID
-Status BTreeFile::_SearchIndex (const char *key,  PageID currIndexID, BTIndexPage *currIndex, PageID& foundID)
+Status BTreeFile::_SearchIndex (const KeyView &key,  PageID currIndexID, BTIndexPage *currIndex, PageID& foundID)
 {
 	PageID nextPageID;
 	
-	Status s = currIndex->GetPageID (key, nextPageID);
+	Status s = currIndex->GetPageID (key, LOWEST_RID, nextPageID);
 	if (s != OK)
 		return FAIL;
 	
 	// Now unpin the page, recurse and then pin it again
 	
-	UNPIN (currIndexID, CLEAN);
+	UNPIN_NODE(currIndexID, CLEAN);
 	s = _Search (key, nextPageID, foundID);
 	if (s != OK)
 		return FAIL;
@@ -937,13 +2700,13 @@ Status BTreeFile::_SearchIndex (const char *key,  PageID currIndexID, BTIndexPag
 // Input	: key, rid
 // Output	: found Pid, where Key >= key
 // Purpose	: find the leftmost leaf page contain the key, or bigger than the key
-Status BTreeFile::_Search( const char *key,  PageID currID, PageID& foundID)
+Status BTreeFile::_Search( const KeyView &key,  PageID currID, PageID& foundID)
 {
 	
     SortedPage *page;
 	Status s;
 	
-    PIN (currID, page);
+    PIN_NODE(currID, page);
     NodeType type = page->GetType ();
 	
     // TWO CASES:
@@ -959,8 +2722,9 @@ Status BTreeFile::_Search( const char *key,  PageID currID, PageID& foundID)
 		break;
 		
 	case LEAF_NODE:
+	case POSTING_NODE:
 		foundID =  page->PageNo();
-		UNPIN(currID,CLEAN);
+		UNPIN_NODE(currID,CLEAN);
 		break;
 	default:		
 		assert (0);
@@ -976,6 +2740,11 @@ Status BTreeFile::_Search( const char *key,  PageID currID, PageID& foundID)
 // OUTPUT	: foundPid
 
 Status BTreeFile:: Search(const char *key,  PageID& foundPid)
+{
+	return Search(MakeKeyView(key), foundPid);
+}
+
+Status BTreeFile:: Search(const KeyView &key,  PageID& foundPid)
 {
 	if (header->GetRootPageID() == INVALID_PAGE)
 	{
@@ -1001,6 +2770,7 @@ Status BTreeFile::_PrintTree ( PageID pageID)
 	SortedPage *page;
 	BTIndexPage *index;
 	BTLeafPage *leaf;
+	BTPostingPage *posting;
 	int i;
 	Status s;
 	PageID curPageID;
@@ -1061,6 +2831,26 @@ Status BTreeFile::_PrintTree ( PageID pageID)
 			os << "\n This page contains  " << i <<"  entries!" << endl;
 			UNPIN(pageID, CLEAN);
 			break;
+
+	case POSTING_NODE:
+		posting = (BTPostingPage *)page;
+		os << "\n Content of Posting_Node"  << pageID << endl;
+		for (i = 0; i < posting->GetNumOfRecords(); i++)
+		{
+			KeyView curKey = posting->GetKeyView(i);
+			PostingCursor cursor;
+
+			os << "Key: ";
+			os.write(curKey.key, curKey.length);
+			os << "	DataRecordIDs:";
+			posting->InitCursor(i, cursor);
+			while (posting->NextRid(i, cursor, dataRid) == OK)
+				os << " " << dataRid;
+			os << endl;
+		}
+		os << "\n This page contains  " << i <<"  entries!" << endl;
+		UNPIN(pageID, CLEAN);
+		break;
 	default:		
 		assert (0);
 	}
@@ -1106,6 +2896,7 @@ Status BTreeFile::PrintTree ( PageID pageID, PrintOption option)
 		break;
 
 	case LEAF_NODE:
+	case POSTING_NODE:
 		UNPIN(pageID, CLEAN);
 		break;
 	default:		
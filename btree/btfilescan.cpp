@@ -29,13 +29,28 @@ BTreeFileScan::~BTreeFileScan ()
 // Purpose : Initialize a B+ tree scan.
 //-------------------------------------------------------------------
 
-void BTreeFileScan::Init(const char *low, const char *high, PageID leftmostLeafPageID){
-	lowKey = low;
-	highKey = high;
+void BTreeFileScan::Init(const KeyView *low, const KeyView *high, PageID leftmostLeafPageID){
+	lowKey = NULL;
+	highKey = NULL;
+	if (low != NULL) {
+		memcpy(lowKeyData, low->key, low->length);
+		lowKeyView.key = lowKeyData;
+		lowKeyView.length = low->length;
+		lowKey = &lowKeyView;
+	}
+	if (high != NULL) {
+		memcpy(highKeyData, high->key, high->length);
+		highKeyView.key = highKeyData;
+		highKeyView.length = high->length;
+		highKey = &highKeyView;
+	}
 	leftmostLeafID = leftmostLeafPageID;
-	curPageID = NULL;
+	curPageID = leftmostLeafPageID;
+	curRid.pageNo = leftmostLeafPageID;
+	curRid.slotNo = -1;
 	scanStarted = false;
 	scanFinished = false;
+	inPostingList = false;
 
 	if (leftmostLeafPageID == INVALID_PAGE) scanFinished = true;
 }
@@ -46,126 +61,107 @@ void BTreeFileScan::Init(const char *low, const char *high, PageID leftmostLeafP
 //
 // Input   : None
 // Output  : rid  - record id of the scanned record.
-//           keyPtr - and a pointer to it's key value.
+//           keyPtr - and a pointer to it's key value, null-terminated.
 // Purpose : Return the next record from the B+-tree index.
 // Return  : OK if successful, DONE if no more records to read.
 //-------------------------------------------------------------------
 Status BTreeFileScan::GetNext (RecordID & rid, char* keyPtr)
+{
+	int keyLen;
+	Status s = GetNext(rid, keyPtr, keyLen);
+
+	if (s == OK)
+		keyPtr[keyLen] = '\0';
+	return s;
+}
+
+
+//-------------------------------------------------------------------
+// BTreeFileScan::GetNext
+//
+// Input   : None
+// Output  : rid  - record id of the scanned record.
+//           keyPtr - the bytes of its key.
+//           keyLen - the length of the key.
+// Purpose : Return the next record from the B+-tree index.
+// Return  : OK if successful, DONE if no more records to read.
+// Note    : Keys are compared in place on the pinned leaf page; only
+//           the key that is actually returned is copied into keyPtr.
+//-------------------------------------------------------------------
+Status BTreeFileScan::GetNext (RecordID & rid, char* keyPtr, int &keyLen)
 {
 
 	if (scanFinished) return DONE;
 
-	RecordID dataRid;
 	BTLeafPage *curPage;
+	KeyView curKey;
 
-	if(!scanStarted) {
-		// Find the record on the leftmost leaf page where we are supposed to start
-		curPageID = leftmostLeafID;
+	PIN(curPageID, curPage);
 
-		PIN(curPageID, curPage);
-		
-		// Find the first non-empty page
-		while (curPage->GetFirst(curRid,keyPtr,dataRid) != OK) {
-			PageID nextPageID = curPage->GetNextPage();
+	// If we are part way through a posting list, return its next record
+	if (inPostingList) {
+		BTPostingPage *postingPage = (BTPostingPage *) curPage;
+		if (postingPage->NextRid(curRid.slotNo, postingCursor, rid) == OK) {
+			curKey = curPage->GetKeyView(curRid.slotNo);
+			memcpy(keyPtr, curKey.key, curKey.length);
+			keyLen = curKey.length;
 			UNPIN(curPageID, CLEAN);
-
-			if (nextPageID == INVALID_PAGE) {
-				scanFinished = true;
-				return DONE;
-			}
-			
-			curPageID = nextPageID;
-			PIN(curPageID, curPage);
-		}
-		
-
-		// Case where the lowKey is NULL (We want to start at the first spot)
-		if (lowKey == NULL) {
-			if (highKey == NULL || KeyCmp(keyPtr,highKey) <= 0) {
-				rid = dataRid;
-				scanStarted = true;
-				UNPIN(curPageID, CLEAN);
-				return OK;
-			}
-			else {
-				scanFinished = true;
-				UNPIN(curPageID, CLEAN);
-				return DONE;
-			}
-		}
-		// lowKey is not NULL
-		else {
-			if (KeyCmp(lowKey,keyPtr) <= 0) {
-				if (highKey == NULL || KeyCmp(keyPtr,highKey) <= 0) {
-					rid = dataRid;
-					scanStarted = true;
-					UNPIN(curPageID, CLEAN);
-					return OK;
-				}
-				else {
-					scanFinished = true;
-					UNPIN(curPageID, CLEAN);
-					return DONE;
-				}
-			}
-			else{
-				// Get the next record and try again
-				while (curPage->GetNext(curRid,keyPtr,dataRid) != DONE){
-					if (KeyCmp(lowKey,keyPtr) <= 0) {
-						if (highKey == NULL || KeyCmp(keyPtr,highKey) <= 0) {
-							rid = dataRid;
-							scanStarted = true;
-							UNPIN(curPageID, CLEAN);
-							return OK;
-						}
-						else {
-							scanFinished = true;
-							UNPIN(curPageID, CLEAN);
-							return DONE;
-						}
-					}
-				}
-				scanFinished = true;
-				UNPIN(curPageID, CLEAN);
-				return DONE;
-			}	
+			return OK;
 		}
+		inPostingList = false;
 	}
-	// The scan has allready been initialized
-	else {
-		// PIN our current page
-		PIN(curPageID, curPage);
-		Status s = curPage->GetNext(curRid, keyPtr, dataRid);
 
-		// See if we have more records on that page, if not we need to get the next page
-		while (s == DONE && curPage->GetNextPage() != INVALID_PAGE) {
-			PageID nextPageID = curPage->GetNextPage();
-			UNPIN(curPageID, CLEAN);
-			curPageID = nextPageID;
+	// On the first call, binary search the starting leaf for lowKey
+	if (!scanStarted && lowKey != NULL && curRid.slotNo == -1 && curPageID == leftmostLeafID)
+		curRid.slotNo = curPage->LowerBound(*lowKey) - 1;
 
-			PIN(curPageID, curPage);
-			s = curPage->GetFirst(curRid, keyPtr, dataRid);
-		}
+	// Advance to the next record, following the leaf chain past empty or exhausted pages.
+	// Until the first record is returned, skip the records that are below lowKey. The leaf
+	// we start on is the one lowKey would be inserted on, so those may run onto the next leaf.
+	while (true) {
+		curRid.slotNo++;
 
-		// Check if we are done the scan
-		if (s == DONE && curPage->GetNextPage() == INVALID_PAGE) {
-				UNPIN(curPageID, CLEAN);
-				scanFinished = true;
-				return DONE;
+		if (curRid.slotNo < curPage->GetNumOfRecords()) {
+			curKey = curPage->GetKeyView(curRid.slotNo);
+			if (scanStarted || lowKey == NULL || KeyCmp(*lowKey, curKey) <= 0) break;
+			continue;
 		}
-		// If we are not done, curRid, keyPtr, and dataRid are all propperly set
-		else{
-			if (highKey == NULL || KeyCmp(keyPtr,highKey) <= 0) {
-				rid = dataRid;
-				UNPIN(curPageID, CLEAN);
-				return OK;
-			}
-			else {
-				scanFinished = true;
-				UNPIN(curPageID, CLEAN);
-				return DONE;
-			}
+
+		PageID nextPageID = curPage->GetNextPage();
+		UNPIN(curPageID, CLEAN);
+
+		if (nextPageID == INVALID_PAGE) {
+			scanFinished = true;
+			return DONE;
 		}
 
+		curPageID = nextPageID;
+		curRid.pageNo = nextPageID;
+		curRid.slotNo = -1;
+		PIN(curPageID, curPage);
+	}
+
+	// Check if we have gone past the end of the range
+	if (highKey != NULL && KeyCmp(curKey, *highKey) > 0) {
+		scanFinished = true;
+		UNPIN(curPageID, CLEAN);
+		return DONE;
+	}
+
+	memcpy(keyPtr, curKey.key, curKey.length);
+	keyLen = curKey.length;
+	if (curPage->GetType() == POSTING_NODE) {
+		// Every entry has at least one record, so the list cannot be empty
+		BTPostingPage *postingPage = (BTPostingPage *) curPage;
+		postingPage->InitCursor(curRid.slotNo, postingCursor);
+		postingPage->NextRid(curRid.slotNo, postingCursor, rid);
+		inPostingList = true;
+	}
+	else {
+		rid = curPage->GetDataRid(curRid.slotNo);
 	}
+	scanStarted = true;
+
+	UNPIN(curPageID, CLEAN);
+	return OK;
 }
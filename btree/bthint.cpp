@@ -0,0 +1,238 @@
+#include <string.h>
+#include "bthint.h"
+
+
+//-------------------------------------------------------------------
+// BTHintTable::BTHintTable
+//
+// Input   : None
+// Output  : None
+// Purpose : Create an empty table of the smallest size.
+//-------------------------------------------------------------------
+
+BTHintTable::BTHintTable ()
+{
+	hints = NULL;
+	counts = NULL;
+	numEntries = 0;
+	generation = 0;
+	Resize(HINT_MIN_ENTRIES);
+}
+
+
+//-------------------------------------------------------------------
+// BTHintTable::~BTHintTable
+//-------------------------------------------------------------------
+
+BTHintTable::~BTHintTable ()
+{
+	delete [] hints;
+	delete [] counts;
+}
+
+
+//-------------------------------------------------------------------
+// BTHintTable::Find
+//
+// Input   : hash - the hash of a key (see GetKeyHash).
+// Output  : pageID, slotNo - the leaf and slot of the first entry with
+//                            the key, when the last lookup saw it.
+// Purpose : Look up the hint of a key.
+// Return  : true if the key has a hint.
+//-------------------------------------------------------------------
+
+bool BTHintTable::Find (unsigned long long hash, PageID &pageID, int &slotNo)
+{
+	Hint *hint = &hints[hash & (numEntries - 1)];
+
+	if (!InUse(hint) || hint->hash != hash)
+		return false;
+
+	pageID = hint->pageID;
+	slotNo = hint->slotNo;
+	return true;
+}
+
+
+//-------------------------------------------------------------------
+// BTHintTable::Touch
+//
+// Input   : hash - the hash of a key being looked up without a hint.
+// Output  : None
+// Purpose : Count a lookup of the key, and now and then age the counts
+//           and fit the size of the table to the number of hot keys.
+// Return  : true if the key is hot enough to be given a hint.
+//-------------------------------------------------------------------
+
+bool BTHintTable::Touch (unsigned long long hash)
+{
+	unsigned char *count = &counts[(hash >> 32) & (numEntries - 1)];
+	bool hot;
+
+	if (*count < 255)
+		(*count)++;
+	hot = (*count >= HINT_HOT_PROBES);
+
+	if (++numProbes >= numEntries * HINT_AGING_PROBES)
+		Age();
+	return hot;
+}
+
+
+//-------------------------------------------------------------------
+// BTHintTable::Record
+//
+// Input   : hash - the hash of a key.
+//           pageID, slotNo - the leaf and slot of its first entry.
+// Output  : None
+// Purpose : Give the key a hint, in place of whatever hint had its
+//           entry of the table.
+//-------------------------------------------------------------------
+
+void BTHintTable::Record (unsigned long long hash, PageID pageID, int slotNo)
+{
+	Hint *hint = &hints[hash & (numEntries - 1)];
+
+	if (!InUse(hint))
+		numHints++;
+	else if (hint->hash != hash)
+		numEvictions++;
+
+	hint->hash = hash;
+	hint->pageID = pageID;
+	hint->slotNo = slotNo;
+	hint->generation = generation;
+}
+
+
+//-------------------------------------------------------------------
+// BTHintTable::Forget
+//
+// Input   : hash - the hash of a key.
+// Output  : None
+// Purpose : Drop the hint of the key, if it has one.
+//-------------------------------------------------------------------
+
+void BTHintTable::Forget (unsigned long long hash)
+{
+	Hint *hint = &hints[hash & (numEntries - 1)];
+
+	if (InUse(hint) && hint->hash == hash) {
+		hint->pageID = INVALID_PAGE;
+		numHints--;
+	}
+}
+
+
+//-------------------------------------------------------------------
+// BTHintTable::ForgetAll
+//
+// Input   : None
+// Output  : None
+// Purpose : Drop all hints, but not the counts, in constant time: the
+//           hints left in the table belong to an older generation.
+//-------------------------------------------------------------------
+
+void BTHintTable::ForgetAll ()
+{
+	// Only after billions of generations can an old one come back
+	if (++generation == 0) {
+		for (int i = 0; i < numEntries; i++)
+			hints[i].pageID = INVALID_PAGE;
+	}
+	numHints = 0;
+}
+
+
+//-------------------------------------------------------------------
+// BTHintTable::Clear
+//
+// Input   : None
+// Output  : None
+// Purpose : Drop all hints and counts.
+//-------------------------------------------------------------------
+
+void BTHintTable::Clear ()
+{
+	for (int i = 0; i < numEntries; i++)
+		hints[i].pageID = INVALID_PAGE;
+	memset(counts, 0, numEntries);
+	numHints = 0;
+	numProbes = 0;
+	numEvictions = 0;
+}
+
+
+//-------------------------------------------------------------------
+// BTHintTable::Age
+//
+// Input   : None
+// Output  : None
+// Purpose : Halve the counts.  Double the table if hot keys evicted
+//           one another often since the last aging, or halve it if
+//           few of its hints are in use.
+//-------------------------------------------------------------------
+
+void BTHintTable::Age ()
+{
+	for (int i = 0; i < numEntries; i++)
+		counts[i] >>= 1;
+
+	if (numEvictions > numEntries / 8 && numEntries < HINT_MAX_ENTRIES)
+		Resize(numEntries * 2);
+	else if (numHints < numEntries / 8 && numEntries > HINT_MIN_ENTRIES)
+		Resize(numEntries / 2);
+
+	numProbes = 0;
+	numEvictions = 0;
+}
+
+
+//-------------------------------------------------------------------
+// BTHintTable::Resize
+//
+// Input   : newNumEntries - the new size of the table, a power of two.
+// Output  : None
+// Purpose : Move the hints and counts into tables of the new size.
+//           When the table shrinks, hints that collide are dropped and
+//           counts that collide keep the larger one.
+//-------------------------------------------------------------------
+
+void BTHintTable::Resize (int newNumEntries)
+{
+	Hint *newHints = new Hint[newNumEntries];
+	unsigned char *newCounts = new unsigned char[newNumEntries];
+
+	for (int i = 0; i < newNumEntries; i++)
+		newHints[i].pageID = INVALID_PAGE;
+	memset(newCounts, 0, newNumEntries);
+
+	numHints = 0;
+	for (int i = 0; i < numEntries; i++) {
+		unsigned char *count = &newCounts[i & (newNumEntries - 1)];
+
+		if (*count < counts[i])
+			*count = counts[i];
+		if (InUse(&hints[i])) {
+			Hint *hint = &newHints[hints[i].hash & (newNumEntries - 1)];
+
+			if (hint->pageID == INVALID_PAGE)
+				numHints++;
+			*hint = hints[i];
+		}
+	}
+
+	// A grown table spreads each old count over the entries it covers
+	if (numEntries > 0) {
+		for (int i = numEntries; i < newNumEntries; i++)
+			newCounts[i] = newCounts[i & (numEntries - 1)];
+	}
+
+	delete [] hints;
+	delete [] counts;
+	hints = newHints;
+	counts = newCounts;
+	numEntries = newNumEntries;
+	numProbes = 0;
+	numEvictions = 0;
+}
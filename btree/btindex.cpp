@@ -5,22 +5,22 @@
 //-------------------------------------------------------------------
 // BTIndexPage::InsertKey
 //
-// Input   : key  - pointer to the key value to be inserted.
+// Input   : key  - the key value to be inserted.
+//           keyRid - record id half of the separator; LOWEST_RID
+//                    unless the separator falls between equal keys.
 //           pid - page id associated to that key.
 // Output  : rid - record id of the (key, pid) record inserted.
 // Purpose : Insert the pair (key, pid) into this index node.
 //-------------------------------------------------------------------
 
-Status BTIndexPage::Insert (const char *key,
+Status BTIndexPage::Insert (const KeyView &key, const RecordID &keyRid,
 							PageID pid, RecordID& rid)
 {
 	KeyDataEntry entry;
-	DataType dataType;
 	Status s;
 	int len;
 	
-	dataType.pid = pid;
-	MakeEntry(&entry, key, INDEX_NODE, dataType, &len);
+	MakeEntry(&entry, key, keyRid, pid, &len);
 
 	s = SortedPage::InsertRecord((char *)&entry, len, rid);
 	if (s != OK)
@@ -36,28 +36,20 @@ Status BTIndexPage::Insert (const char *key,
 //-------------------------------------------------------------------
 // BTIndexPage::DeleteKey
 //
-// Input   : key  - pointer to the key value to be inserted.
+// Input   : key  - the key value to be deleted.
 // Output  : rid - record id of the (key, pid) record deleted.
 // Purpose : Delete the entry associated with key from this index node.
 //-------------------------------------------------------------------
 
-Status BTIndexPage::Delete (const char *key, RecordID& rid)
+Status BTIndexPage::Delete (const KeyView &key, RecordID& rid)
 {
-	PageID pageNo;
-	KeyType currKey;
-	Status s;
-	
-	s = GetFirst (rid, currKey, pageNo);
-	assert(s == OK);
+	Status s = OK;
 	
-	while (KeyCmp(key, currKey) > 0)
-	{
-		s = GetNext (rid, currKey, pageNo);
-		if (s != OK)
-			break;
-	}
+	assert(numOfSlots > 0);
+	rid.pageNo = pid;
+	rid.slotNo = LowerBound(key);
 	
-	if (KeyCmp(key, currKey) != 0)
+	if (rid.slotNo == numOfSlots || KeyCmp(key, GetKeyView(rid.slotNo)) != 0)
 		rid.slotNo --;
 	if (rid.slotNo < 0)
 		cout << "Error slotNo!"<< endl;
@@ -72,7 +64,9 @@ Status BTIndexPage::Delete (const char *key, RecordID& rid)
 //-------------------------------------------------------------------
 // BTIndexPage::GetPageID
 //
-// Input   : key  - pointer to the key value to be inserted.
+// Input   : key  - the key value to search for.
+//           keyRid - the record id to search for, or LOWEST_RID to
+//                    find the first entry with key.
 // Output  : pid - page id associated with the key.
 // Purpose : Search the index page, look for the pid which points to
 //           the appropiate child page to search.  This can be used
@@ -80,38 +74,73 @@ Status BTIndexPage::Delete (const char *key, RecordID& rid)
 // Return  : Always OK.
 //-------------------------------------------------------------------
 
-Status BTIndexPage::GetPageID (const char *key, PageID& pid)
+Status BTIndexPage::GetPageID (const KeyView &key, const RecordID &keyRid, PageID& pid)
 {
-	KeyDataEntry *currKey;
-	int len;
+	// Binary search for the last entry whose (key, rid) is <= (key, keyRid).
 	
-	// A sequential search is implemented here.  You can modify it
-	// to a binary search if you like.
-	
-	for (int i = numOfSlots - 1; i >= 0; i--)
-	{
-		currKey = (KeyDataEntry *)(data + slots[i].offset);
-		
-		if (KeyCmp(key, currKey->key) >= 0)
-		{
-			len = slots[i].length;
-			GetKeyData(NULL, (DataType *)&pid, currKey, len, INDEX_NODE);
-			return OK;
-		}
-	}
+	pid = GetChild(UpperBound(key, keyRid) - 1);
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTIndexPage::GetChild
+//
+// Input   : slotNo - slot number of an entry, or -1.
+// Output  : None
+// Purpose : Find the child page an entry points to.  The children
+//           below the first entry are under the left link, which is
+//           what slot -1 stands for.
+// Return  : The page id of the child.
+//-------------------------------------------------------------------
+
+PageID BTIndexPage::GetChild (int slotNo)
+{
+	PageID pageNo;
 	
-	// If we reach this point, then the page we should follow in our 
-	// B+tree search must be the leftmost child of this page.
+	if (slotNo < 0)
+		return GetLeftLink();
 	
-	pid = GetLeftLink();
-	return OK;
+	GetKeyData(NULL, (DataType *)&pageNo, 
+		(KeyDataEntry *)(data + slots[slotNo].offset), 
+		slots[slotNo].length, INDEX_NODE);
+	return pageNo;
+}
+
+
+//-------------------------------------------------------------------
+// BTIndexPage::SetChild
+//
+// Input   : slotNo - slot number of an entry, or -1 for the left link.
+//           pageNo - the new child page.
+// Output  : None
+// Purpose : Point an entry at another page, for a child that has been
+//           moved.  The key and record id of the entry are left as
+//           they are.
+// Return  : None
+//-------------------------------------------------------------------
+
+void BTIndexPage::SetChild (int slotNo, PageID pageNo)
+{
+	char *stored;
+	PageID oldPageNo;
+
+	if (slotNo < 0) {
+		SetLeftLink(pageNo);
+		return;
+	}
+
+	stored = data + slots[slotNo].offset + slots[slotNo].length - sizeof(PageID);
+	memcpy(&oldPageNo, stored, sizeof(PageID));
+	pageNo |= oldPageNo & INDEX_RID_FLAG;
+	memcpy(stored, &pageNo, sizeof(PageID));
 }
 
 
 //-------------------------------------------------------------------
 // BTIndexPage::GetSibling
 //
-// Input   : key  - pointer to the key value to be inserted.
+// Input   : key  - the key value to search for.
 // Output  : pid - page id associated with a sibling of that key.
 //           left - set to 1 if the sibling is not the leftmost 
 //                  entry.
@@ -126,38 +155,28 @@ Status BTIndexPage::GetPageID (const char *key, PageID& pid)
 // Return  : Always OK.
 //-------------------------------------------------------------------
 
-Status BTIndexPage::GetSibling (const char *key,
+Status BTIndexPage::GetSibling (const KeyView &key,
 								PageID &pageNo, int &left)
 {
-	int i;
+	int i = UpperBound(key) - 1;
 	
-	for (i = numOfSlots - 1; i >= 0; i--)
+	if (i >= 0)
 	{
-		GetKeyData(
-			NULL, 
-			(DataType *)&pageNo,
-			(KeyDataEntry *)(data + slots[i].offset),
-			slots[i].length,
-			(NodeType)type);
-		
-		if (KeyCmp(key, (char *)(data+slots[i].offset)) >= 0)
+		left = 1;
+		if (i != 0)
 		{
-			left = 1;
-			if (i != 0)
-			{
-				GetKeyData(
-					NULL, 
-					(DataType *)&pageNo,
-					(KeyDataEntry *)(data + slots[i-1].offset),
-					slots[i-1].length,
-					(NodeType)type);
-				return OK;
-			}
-			else
-			{
-				pageNo = GetLeftLink();
-				return OK;
-			}
+			GetKeyData(
+				NULL, 
+				(DataType *)&pageNo,
+				(KeyDataEntry *)(data + slots[i-1].offset),
+				slots[i-1].length,
+				(NodeType)type);
+			return OK;
+		}
+		else
+		{
+			pageNo = GetLeftLink();
+			return OK;
 		}
 	}
 	
@@ -240,24 +259,21 @@ Status BTIndexPage::GetNext (RecordID& rid, char *key, PageID & pageNo)
 //-------------------------------------------------------------------
 // BTIndexPage::FindKey
 //
-// Input   : key - pointer to the key to find
-//           entry - pointer to mem location to copy result.
-// Output  : None
+// Input   : key - the key to find
+// Output  : entry - a view of k1 in place on this page.
 // Purpose : Look for (k1, p1) (k2, p2) such that k1 <= key < k2, 
-//           and copy k1 into entry.
-// Precond : entry has enough space to hold k1.
+//           and return k1 in entry.
 // Return  : OK if successful, FAIL if cannot find such k1.
 //-------------------------------------------------------------------
 
-Status BTIndexPage::FindKey(char *key, char *entry)
+Status BTIndexPage::FindKey(const KeyView &key, KeyView &entry)
 {
-	for (int i = numOfSlots - 1; i >= 0; i--)
+	int i = UpperBound(key) - 1;
+	
+	if (i >= 0)
 	{
-		if (KeyCmp(key, (char *)(data+slots[i].offset)) >= 0)
-		{
-			memcpy(entry, data+slots[i].offset, GetKeyLength(key));
-			return OK;
-		}
+		entry = GetKeyView(i);
+		return OK;
 	}
 	return FAIL;
 }
@@ -293,13 +309,54 @@ void BTIndexPage::SetLeftLink (PageID pid)
 }
 
 
-Status BTIndexPage::AdjustKey (const char *newKey, const char *oldKey)
+//-------------------------------------------------------------------
+// BTIndexPage::AdjustKey
+//
+// Input   : newKey - the key to replace it with.
+//           oldKey - the key of the entry to change.
+// Output  : None
+// Purpose : Replace the key of the entry that covers oldKey with
+//           newKey.  A key of the same length is overwritten in
+//           place; otherwise the entry is deleted and re-inserted.
+// Precond : newKey keeps the entry in the same position.
+// Return  : OK if successful, FAIL if there is no such entry or the
+//           page has no room for the longer key.
+//-------------------------------------------------------------------
+
+Status BTIndexPage::AdjustKey (const KeyView &newKey, const KeyView &oldKey)
 {
-    for (int i = numOfSlots -1; i >= 0; i--) {
-        if (KeyCmp(oldKey, (char*)(data+slots[i].offset)) >= 0) {
-			memcpy(data+slots[i].offset, newKey, GetKeyLength(newKey)); 
-			return OK;
-        }
+    int i = UpperBound(oldKey) - 1;
+    PageID pageNo;
+    RecordID rid, keyRid;
+    KeyType keyBuf;
+    KeyView key;
+    
+    if (i < 0)
+		return FAIL;
+    
+    if (GetKeyView(i).length == newKey.length) {
+		memcpy(data+slots[i].offset, newKey.key, newKey.length); 
+		return OK;
     }
-    return FAIL;
+    
+    keyRid = GetKeyRid(i);
+    if (AvailableSpace() + slots[i].length < GetKeyDataLength(newKey, keyRid))
+		return FAIL;
+    
+    // newKey may point into this page, so copy it out before the
+    // old entry goes away.
+    
+    memcpy(keyBuf, newKey.key, newKey.length);
+    key.key = keyBuf;
+    key.length = newKey.length;
+    
+    GetKeyData(NULL, (DataType *)&pageNo,
+		(KeyDataEntry *)(data + slots[i].offset),
+		slots[i].length, INDEX_NODE);
+    
+    rid.pageNo = pid;
+    rid.slotNo = i;
+    if (SortedPage::DeleteRecord(rid) != OK)
+		return FAIL;
+    return Insert(key, keyRid, pageNo, rid);
 }
@@ -4,13 +4,13 @@
 //-------------------------------------------------------------------
 // BTLeafPage::InsertRecord
 //
-// Input   : key  - pointer to the key value to be inserted.
+// Input   : key  - the key value to be inserted.
 //           dataRid - record id to be associated with key
 // Output  : rid - record id of the inserted pair (key, dataRid)
 // Purpose : Insert the pair (key, dataRid) into this leaf node.
 //-------------------------------------------------------------------
 
-Status BTLeafPage::Insert(const char *key, 
+Status BTLeafPage::Insert(const KeyView &key, 
 						  RecordID dataRid, RecordID& rid)
 {
 	KeyDataEntry entry;
@@ -131,42 +131,55 @@ Status BTLeafPage::GetCurrent (RecordID rid, char* key, RecordID & dataRid)
 }
 
 
+//-------------------------------------------------------------------
+// BTLeafPage::GetDataRid
+//
+// Input   : slotNo - slot number of the entry
+// Output  : None
+// Purpose : get the record id stored in an entry without copying
+//           its key.
+// Return  : The record id of the entry.
+//-------------------------------------------------------------------
+
+RecordID BTLeafPage::GetDataRid (int slotNo)
+{
+	RecordID dataRid;
+	
+	GetKeyData(NULL, 
+		(DataType *)&dataRid, 
+		(KeyDataEntry *)(data + slots[slotNo].offset),
+		slots[slotNo].length,
+		(NodeType)type);
+	
+	return dataRid;
+}
+
+
 //-------------------------------------------------------------------
 // BTLeafPage::Delete
 //
-// Input   : key - pointer to the key
+// Input   : key - the key
 //           dataRid - record id
 // Output  : None
-// Purpose : Find the pair (key, dataRid) and delete it.
+// Purpose : Find the pair (key, dataRid) and delete it.  Entries are
+//           ordered by (key, record id), so it is found with a single
+//           binary search however many entries share its key.
 // Return  : OK if successful, FAIL otherwise.
 //-------------------------------------------------------------------
 
-Status BTLeafPage::Delete (const char* key, const RecordID& dataRid)
+Status BTLeafPage::Delete (const KeyView &key, const RecordID& dataRid)
 {
-	int i;
+	RecordID delRid;
+	Status s;
 	
-	for (i = numOfSlots - 1; i >= 0; i--)
-	{
-		KeyType tmpKey;
-		RecordID tmpRid;
-		GetKeyData(
-			tmpKey,
-			(DataType *)&tmpRid,
-			(KeyDataEntry *)(data + slots[i].offset),
-			slots[i].length,
-			(NodeType)type);
-		if (tmpRid == dataRid && KeyCmp(key, tmpKey) == 0)
-		{
-			RecordID delRid;
-			Status s;
-			
-			delRid.pageNo = PageNo();
-			delRid.slotNo = i;
-			s = SortedPage::DeleteRecord(delRid);
-			assert(s == OK);
-			return OK;
-		}
-	}
+	delRid.pageNo = PageNo();
+	delRid.slotNo = LowerBound(key, dataRid);
 	
-	return FAIL;
-}
+	if (delRid.slotNo == numOfSlots || KeyCmp(key, GetKeyView(delRid.slotNo)) != 0 ||
+		GetDataRid(delRid.slotNo) != dataRid)
+		return FAIL;
+	
+	s = SortedPage::DeleteRecord(delRid);
+	assert(s == OK);
+	return OK;
+}
\ No newline at end of file
@@ -0,0 +1,785 @@
+#include <string.h>
+#include "bufmgr.h"
+#include "btposting.h"
+
+// A rid takes at most two variable-length integers of five bytes each.
+const int MAX_RID_BYTES = 10;
+
+// Every rid takes at least two bytes, so no run is longer than this.
+const int MAX_RUN_RIDS = HEAPPAGE_DATA_SIZE / 2 + 2;
+
+
+//-------------------------------------------------------------------
+// Variable-length integers: seven bits per byte, low bits first, with
+// the high bit set on every byte but the last.
+//-------------------------------------------------------------------
+
+static unsigned char *PutVarint(unsigned char *p, unsigned int v)
+{
+	while (v >= 0x80)
+	{
+		*p++ = (unsigned char)(v | 0x80);
+		v >>= 7;
+	}
+	*p++ = (unsigned char)v;
+	return p;
+}
+
+static const unsigned char *GetVarint(const unsigned char *p, unsigned int &v)
+{
+	int shift = 0;
+
+	v = 0;
+	while (*p & 0x80)
+	{
+		v |= (unsigned int)(*p++ & 0x7F) << shift;
+		shift += 7;
+	}
+	v |= (unsigned int)*p++ << shift;
+	return p;
+}
+
+
+//-------------------------------------------------------------------
+// EncodeRids
+//
+// Input   : rids - sorted record ids.
+//           numRids - number of rids.
+// Output  : target - the compressed run, at most MAX_RID_BYTES per rid.
+// Purpose : Delta-compress a run of rids.  Differences are taken modulo
+//           2^32, so any rid values round-trip.
+// Return  : The length of the run in bytes.
+//-------------------------------------------------------------------
+
+static int EncodeRids(const RecordID *rids, int numRids, unsigned char *target)
+{
+	unsigned char *p = target;
+	RecordID prev;
+
+	prev.pageNo = 0;
+	prev.slotNo = 0;
+	for (int i = 0; i < numRids; i++)
+	{
+		unsigned int pageDelta = (unsigned int)rids[i].pageNo - (unsigned int)prev.pageNo;
+
+		p = PutVarint(p, pageDelta);
+		if (pageDelta == 0)
+			p = PutVarint(p, (unsigned int)rids[i].slotNo - (unsigned int)prev.slotNo);
+		else
+			p = PutVarint(p, (unsigned int)rids[i].slotNo);
+		prev = rids[i];
+	}
+	return p - target;
+}
+
+
+//-------------------------------------------------------------------
+// DecodeRid
+//
+// Input   : p - the next rid of a compressed run.
+//           prev - the rid before it (0, 0 at the start of a run).
+// Output  : prev - the decoded rid.
+// Purpose : Decode one rid of a run.
+// Return  : Pointer to the rid after it.
+//-------------------------------------------------------------------
+
+static const unsigned char *DecodeRid(const unsigned char *p, RecordID &prev)
+{
+	unsigned int pageDelta, slot;
+
+	p = GetVarint(p, pageDelta);
+	p = GetVarint(p, slot);
+	if (pageDelta == 0)
+		slot += (unsigned int)prev.slotNo;
+	prev.pageNo = (int)((unsigned int)prev.pageNo + pageDelta);
+	prev.slotNo = (int)slot;
+	return p;
+}
+
+static void DecodeRids(const unsigned char *p, int numRids, RecordID *rids)
+{
+	RecordID prev;
+
+	prev.pageNo = 0;
+	prev.slotNo = 0;
+	for (int i = 0; i < numRids; i++)
+	{
+		p = DecodeRid(p, prev);
+		rids[i] = prev;
+	}
+}
+
+
+//-------------------------------------------------------------------
+// InsertRid / FindRid
+//
+// Insert a rid into a sorted array after any equal rids, returning the
+// new number of rids; find the position of a rid, or -1.
+//-------------------------------------------------------------------
+
+static int InsertRid(RecordID *rids, int numRids, RecordID rid)
+{
+	int i = numRids;
+
+	while (i > 0 && rid < rids[i - 1])
+	{
+		rids[i] = rids[i - 1];
+		i--;
+	}
+	rids[i] = rid;
+	return numRids + 1;
+}
+
+static int FindRid(const RecordID *rids, int numRids, RecordID rid)
+{
+	int low = 0, high = numRids;
+
+	while (low < high)
+	{
+		int mid = (low + high) / 2;
+
+		if (rids[mid] < rid)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return (low < numRids && rids[low] == rid) ? low : -1;
+}
+
+
+//-------------------------------------------------------------------
+// Posting-list entries
+//-------------------------------------------------------------------
+
+struct PostingEntry
+{
+	KeyView              key;
+	PageID               overflow;  // first overflow page, or INVALID_PAGE
+	int                  numRids;   // rids in the list, inline or not
+	const unsigned char *rids;      // inline run, if not overflowed
+	int                  ridLength; // bytes in the inline run
+};
+
+static int PostingHeaderLength(int keyLength)
+{
+	return 1 + keyLength + sizeof(PageID) + sizeof(int);
+}
+
+static void ReadPostingEntry(const char *entry, int len, PostingEntry &e)
+{
+	int headerLength;
+
+	e.key = GetEntryKey(entry, len, POSTING_NODE);
+	memcpy(&e.overflow, e.key.key + e.key.length, sizeof(PageID));
+	memcpy(&e.numRids, e.key.key + e.key.length + sizeof(PageID), sizeof(int));
+	headerLength = PostingHeaderLength(e.key.length);
+	e.rids = (const unsigned char *)entry + headerLength;
+	e.ridLength = len - headerLength;
+}
+
+//-------------------------------------------------------------------
+// MakePostingEntry
+//
+// Input   : key - the key of the entry.
+//           overflow - first overflow page, or INVALID_PAGE.
+//           numRids - total number of rids in the list.
+//           rids, numInline - the rids to store in the entry itself.
+// Output  : target - the entry.
+// Return  : The length of the entry.
+//-------------------------------------------------------------------
+
+static int MakePostingEntry(char *target, const KeyView &key, PageID overflow,
+							int numRids, const RecordID *rids, int numInline)
+{
+	target[0] = (char)key.length;
+	memcpy(target + 1, key.key, key.length);
+	memcpy(target + 1 + key.length, &overflow, sizeof(PageID));
+	memcpy(target + 1 + key.length + sizeof(PageID), &numRids, sizeof(int));
+
+	int headerLength = PostingHeaderLength(key.length);
+	return headerLength +
+		EncodeRids(rids, numInline, (unsigned char *)target + headerLength);
+}
+
+
+//-------------------------------------------------------------------
+// BTOverflowPage::Init
+//
+// Input   : pageNo - page id of this page.
+// Output  : None
+// Purpose : Initialize an empty overflow page.
+//-------------------------------------------------------------------
+
+void BTOverflowPage::Init (PageID pageNo)
+{
+	HeapPage::Init(pageNo);
+	Header()->numRids = 0;
+	Header()->length = 0;
+}
+
+
+//-------------------------------------------------------------------
+// BTOverflowPage::GetRids
+//
+// Input   : None
+// Output  : rids - all the rids on this page, in order.  Must have room
+//                  for MAX_RUN_RIDS.
+// Return  : The number of rids.
+//-------------------------------------------------------------------
+
+int BTOverflowPage::GetRids (RecordID *rids)
+{
+	DecodeRids(GetRidData(), Header()->numRids, rids);
+	return Header()->numRids;
+}
+
+
+//-------------------------------------------------------------------
+// BTOverflowPage::SetRids
+//
+// Input   : rids - sorted rids to store on this page.
+//           numRids - the number of rids.
+// Output  : None
+// Purpose : Replace the contents of this page.
+// Return  : OK if successful, FAIL if the rids do not fit.
+//-------------------------------------------------------------------
+
+Status BTOverflowPage::SetRids (const RecordID *rids, int numRids)
+{
+	unsigned char run[MAX_RUN_RIDS * MAX_RID_BYTES];
+	int length = EncodeRids(rids, numRids, run);
+
+	if (length > HEAPPAGE_DATA_SIZE - (int)sizeof(OverflowHeader))
+		return FAIL;
+
+	memcpy(HeapPage::data + sizeof(OverflowHeader), run, length);
+	Header()->numRids = numRids;
+	Header()->length = length;
+	if (numRids > 0)
+		Header()->firstRid = rids[0];
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// MakeOverflowChain
+//
+// Input   : rids - sorted rids, few enough to fit on one page.
+//           numRids - the number of rids.
+// Output  : head - the page id of the new chain.
+// Purpose : Move a rid list out to an overflow page.
+// Return  : OK if successful, FAIL otherwise.
+//-------------------------------------------------------------------
+
+static Status MakeOverflowChain(const RecordID *rids, int numRids, PageID &head)
+{
+	BTOverflowPage *page;
+
+	NEWPAGE(head, page);
+	page->Init(head);
+	if (page->SetRids(rids, numRids) != OK)
+	{
+		FREEPAGE(head);
+		return FAIL;
+	}
+	UNPIN(head, DIRTY);
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// FindOverflowPage
+//
+// Input   : head - first page of a chain.
+//           rid - the rid being looked for.
+// Output  : pageID, page - the last page of the chain whose first rid
+//                          is not above rid (or the first page), left
+//                          pinned.
+// Return  : OK if successful, FAIL otherwise.
+//-------------------------------------------------------------------
+
+static Status FindOverflowPage(PageID head, RecordID rid, PageID &pageID, BTOverflowPage *&page)
+{
+	pageID = head;
+	PIN(pageID, page);
+
+	while (page->GetNextPage() != INVALID_PAGE)
+	{
+		PageID nextID = page->GetNextPage();
+		BTOverflowPage *nextPage;
+
+		PIN(nextID, nextPage);
+		if (rid < nextPage->GetFirstRid())
+		{
+			UNPIN(nextID, CLEAN);
+			break;
+		}
+		UNPIN(pageID, CLEAN);
+		pageID = nextID;
+		page = nextPage;
+	}
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// OverflowInsert
+//
+// Input   : head - first page of a chain.
+//           rid - the rid to insert.
+// Output  : None
+// Purpose : Insert a rid into its place in an overflow chain.  A page
+//           that overflows is split, and its upper half goes to a new
+//           page linked in after it.
+// Return  : OK if successful, FAIL otherwise.
+//-------------------------------------------------------------------
+
+static Status OverflowInsert(PageID head, RecordID rid)
+{
+	RecordID rids[MAX_RUN_RIDS];
+	PageID pageID, newPageID, nextPageID;
+	BTOverflowPage *page, *newPage, *nextPage;
+	int numRids, half;
+
+	if (FindOverflowPage(head, rid, pageID, page) != OK)
+		return FAIL;
+
+	numRids = InsertRid(rids, page->GetRids(rids), rid);
+	if (page->SetRids(rids, numRids) == OK)
+	{
+		UNPIN(pageID, DIRTY);
+		return OK;
+	}
+
+	if (MINIBASE_BM->NewPage(newPageID, (Page *&)newPage) != OK)
+	{
+		MINIBASE_BM->UnpinPage(pageID, CLEAN);
+		return FAIL;
+	}
+	newPage->Init(newPageID);
+
+	// Pin every page the split changes, and fill both halves, before
+	// changing any page of the chain, so that a failure leaves the chain
+	// as it was.  SetRids does not touch a page it fails on.
+
+	nextPageID = page->GetNextPage();
+	if (nextPageID != INVALID_PAGE &&
+		MINIBASE_BM->PinPage(nextPageID, (Page *&)nextPage) != OK)
+	{
+		MINIBASE_BM->FreePage(newPageID);
+		MINIBASE_BM->UnpinPage(pageID, CLEAN);
+		return FAIL;
+	}
+
+	half = numRids / 2;
+	if (newPage->SetRids(rids + half, numRids - half) != OK ||
+		page->SetRids(rids, half) != OK)
+	{
+		if (nextPageID != INVALID_PAGE)
+			MINIBASE_BM->UnpinPage(nextPageID, CLEAN);
+		MINIBASE_BM->FreePage(newPageID);
+		MINIBASE_BM->UnpinPage(pageID, CLEAN);
+		return FAIL;
+	}
+
+	if (nextPageID != INVALID_PAGE)
+	{
+		nextPage->SetPrevPage(newPageID);
+		UNPIN(nextPageID, DIRTY);
+	}
+	newPage->SetNextPage(nextPageID);
+	newPage->SetPrevPage(pageID);
+	page->SetNextPage(newPageID);
+
+	UNPIN(newPageID, DIRTY);
+	UNPIN(pageID, DIRTY);
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// OverflowDelete
+//
+// Input   : head - first page of a chain.
+//           rid - the rid to delete.
+// Output  : head - first page of the chain, INVALID_PAGE if the chain
+//                  is now empty.
+// Purpose : Delete a rid from an overflow chain, freeing its page if
+//           the page becomes empty.
+// Return  : OK if successful, FAIL if the rid is not in the chain.
+//-------------------------------------------------------------------
+
+static Status OverflowDelete(PageID &head, RecordID rid)
+{
+	RecordID rids[MAX_RUN_RIDS];
+	PageID pageID, prevPageID, nextPageID;
+	BTOverflowPage *page, *linkPage;
+	int numRids, i;
+
+	if (FindOverflowPage(head, rid, pageID, page) != OK)
+		return FAIL;
+
+	numRids = page->GetRids(rids);
+	i = FindRid(rids, numRids, rid);
+	if (i < 0)
+	{
+		UNPIN(pageID, CLEAN);
+		return FAIL;
+	}
+
+	if (numRids > 1)
+	{
+		memmove(&rids[i], &rids[i + 1], (numRids - 1 - i) * sizeof(RecordID));
+		page->SetRids(rids, numRids - 1);
+		UNPIN(pageID, DIRTY);
+		return OK;
+	}
+
+	// The page is now empty, so unlink it from the chain
+
+	prevPageID = page->GetPrevPage();
+	nextPageID = page->GetNextPage();
+	if (prevPageID != INVALID_PAGE)
+	{
+		PIN(prevPageID, linkPage);
+		linkPage->SetNextPage(nextPageID);
+		UNPIN(prevPageID, DIRTY);
+	}
+	if (nextPageID != INVALID_PAGE)
+	{
+		PIN(nextPageID, linkPage);
+		linkPage->SetPrevPage(prevPageID);
+		UNPIN(nextPageID, DIRTY);
+	}
+	if (pageID == head)
+		head = nextPageID;
+
+	FREEPAGE(pageID);
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTPostingPage::GetEntry
+//
+// Input   : slotNo - slot of the entry.
+// Output  : e - the fields of the entry, in place on this page.
+// Purpose : Read a posting-list entry.
+//-------------------------------------------------------------------
+
+void BTPostingPage::GetEntry (int slotNo, PostingEntry &e)
+{
+	ReadPostingEntry(data + slots[slotNo].offset, slots[slotNo].length, e);
+}
+
+
+//-------------------------------------------------------------------
+// BTPostingPage::ReplaceEntry
+//
+// Input   : slotNo - slot of the entry to replace.
+//           entry, len - the new entry, with the same key.
+// Output  : None
+// Purpose : Replace an entry, in place if its length is unchanged.
+// Precond : The page has room for the new entry once the old one is
+//           gone, and entry does not point into this page.
+// Return  : OK if successful, FAIL otherwise.
+//-------------------------------------------------------------------
+
+Status BTPostingPage::ReplaceEntry (int slotNo, char *entry, int len)
+{
+	RecordID rid;
+
+	if (slots[slotNo].length == len)
+	{
+		memcpy(data + slots[slotNo].offset, entry, len);
+		return OK;
+	}
+
+	rid.pageNo = pid;
+	rid.slotNo = slotNo;
+	if (SortedPage::DeleteRecord(rid) != OK)
+		return FAIL;
+	return SortedPage::InsertRecord(entry, len, rid);
+}
+
+
+//-------------------------------------------------------------------
+// BTPostingPage::GetInsertLength
+//
+// Input   : key - the key to be inserted.
+//           dataRid - record id to be associated with key.
+// Output  : None
+// Purpose : Work out how much more of this page Insert would use.
+// Return  : The number of bytes, which is 0 if the list of key is
+//           already in overflow pages.
+//-------------------------------------------------------------------
+
+int BTPostingPage::GetInsertLength (const KeyView &key, RecordID dataRid)
+{
+	char entry[MAX_SPACE];
+	RecordID rids[POSTING_INLINE_MAX + 1];
+	PostingEntry e;
+	int i = LowerBound(key);
+	int numRids, len;
+
+	if (i == numOfSlots || KeyCmp(key, GetKeyView(i)) != 0)
+		return MakePostingEntry(entry, key, INVALID_PAGE, 1, &dataRid, 1);
+
+	GetEntry(i, e);
+	if (e.overflow != INVALID_PAGE)
+		return 0;
+
+	DecodeRids(e.rids, e.numRids, rids);
+	numRids = InsertRid(rids, e.numRids, dataRid);
+	len = MakePostingEntry(entry, e.key, INVALID_PAGE, numRids, rids, numRids);
+	if (len - PostingHeaderLength(key.length) > POSTING_INLINE_MAX)
+		return 0;
+	return len - slots[i].length;
+}
+
+
+//-------------------------------------------------------------------
+// BTPostingPage::Insert
+//
+// Input   : key - the key to be inserted.
+//           dataRid - record id to be associated with key.
+// Output  : None
+// Purpose : Add dataRid to the posting list of key, starting a new list
+//           if there is none, and moving the list out to an overflow
+//           page once it no longer fits in the entry.
+// Precond : AvailableSpace() is at least GetInsertLength(key, dataRid).
+// Return  : OK if successful, FAIL otherwise.
+//-------------------------------------------------------------------
+
+Status BTPostingPage::Insert (const KeyView &key, RecordID dataRid)
+{
+	char entry[MAX_SPACE];
+	RecordID rids[POSTING_INLINE_MAX + 1];
+	PostingEntry e;
+	RecordID rid;
+	int i = LowerBound(key);
+	int numRids, len;
+
+	if (i == numOfSlots || KeyCmp(key, GetKeyView(i)) != 0)
+	{
+		len = MakePostingEntry(entry, key, INVALID_PAGE, 1, &dataRid, 1);
+		return SortedPage::InsertRecord(entry, len, rid);
+	}
+
+	GetEntry(i, e);
+	if (e.overflow != INVALID_PAGE)
+	{
+		// The entry only keeps a count of the rids in the chain, so it can
+		// be rewritten in place.  Make sure of that before the rid goes
+		// into the chain, so that the count never falls out of step.
+		len = MakePostingEntry(entry, e.key, e.overflow, e.numRids + 1, NULL, 0);
+		if (len != slots[i].length)
+			return FAIL;
+		if (OverflowInsert(e.overflow, dataRid) != OK)
+			return FAIL;
+		return ReplaceEntry(i, entry, len);
+	}
+
+	DecodeRids(e.rids, e.numRids, rids);
+	numRids = InsertRid(rids, e.numRids, dataRid);
+	len = MakePostingEntry(entry, e.key, INVALID_PAGE, numRids, rids, numRids);
+
+	if (len - PostingHeaderLength(e.key.length) > POSTING_INLINE_MAX)
+	{
+		PageID head;
+
+		if (MakeOverflowChain(rids, numRids, head) != OK)
+			return FAIL;
+		len = MakePostingEntry(entry, e.key, head, numRids, NULL, 0);
+	}
+
+	return ReplaceEntry(i, entry, len);
+}
+
+
+//-------------------------------------------------------------------
+// BTPostingPage::Delete
+//
+// Input   : key - the key.
+//           dataRid - record id to remove from the list of key.
+// Output  : None
+// Purpose : Remove dataRid from the posting list of key, and the entry
+//           with it if that was the last rid.
+// Return  : OK if successful, FAIL otherwise.
+//-------------------------------------------------------------------
+
+Status BTPostingPage::Delete (const KeyView &key, const RecordID &dataRid)
+{
+	char entry[MAX_SPACE];
+	RecordID rids[POSTING_INLINE_MAX + 1];
+	PostingEntry e;
+	RecordID rid;
+	int i = LowerBound(key);
+	int numRids, j, len;
+
+	if (i == numOfSlots || KeyCmp(key, GetKeyView(i)) != 0)
+		return FAIL;
+
+	rid.pageNo = pid;
+	rid.slotNo = i;
+
+	GetEntry(i, e);
+	if (e.overflow != INVALID_PAGE)
+	{
+		PageID head = e.overflow;
+
+		if (OverflowDelete(head, dataRid) != OK)
+			return FAIL;
+		if (e.numRids == 1)
+			return SortedPage::DeleteRecord(rid);
+		len = MakePostingEntry(entry, e.key, head, e.numRids - 1, NULL, 0);
+		return ReplaceEntry(i, entry, len);
+	}
+
+	DecodeRids(e.rids, e.numRids, rids);
+	j = FindRid(rids, e.numRids, dataRid);
+	if (j < 0)
+		return FAIL;
+	if (e.numRids == 1)
+		return SortedPage::DeleteRecord(rid);
+
+	numRids = e.numRids - 1;
+	memmove(&rids[j], &rids[j + 1], (numRids - j) * sizeof(RecordID));
+	len = MakePostingEntry(entry, e.key, INVALID_PAGE, numRids, rids, numRids);
+	return ReplaceEntry(i, entry, len);
+}
+
+
+//-------------------------------------------------------------------
+// BTPostingPage::GetNumOfRids
+//
+// Input   : slotNo - slot of the entry.
+// Output  : None
+// Return  : The number of rids in the posting list of the entry.
+//-------------------------------------------------------------------
+
+int BTPostingPage::GetNumOfRids (int slotNo)
+{
+	PostingEntry e;
+
+	GetEntry(slotNo, e);
+	return e.numRids;
+}
+
+
+//-------------------------------------------------------------------
+// BTPostingPage::FreeOverflowPages
+//
+// Input   : None
+// Output  : None
+// Purpose : Free the overflow pages of every entry on this page, when
+//           the page itself is about to be freed.
+// Return  : OK if successful, FAIL otherwise.
+//-------------------------------------------------------------------
+
+Status BTPostingPage::FreeOverflowPages ()
+{
+	for (int i = 0; i < numOfSlots; i++)
+	{
+		PostingEntry e;
+		PageID pageID;
+
+		GetEntry(i, e);
+		pageID = e.overflow;
+		while (pageID != INVALID_PAGE)
+		{
+			BTOverflowPage *page;
+			PageID nextPageID;
+
+			PIN(pageID, page);
+			nextPageID = page->GetNextPage();
+			FREEPAGE(pageID);
+			pageID = nextPageID;
+		}
+	}
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTPostingPage::InitCursor
+//
+// Input   : slotNo - slot of the entry to read.
+// Output  : cursor - positioned before the first rid of the entry.
+// Purpose : Start reading the posting list of an entry.
+//-------------------------------------------------------------------
+
+void BTPostingPage::InitCursor (int slotNo, PostingCursor &cursor)
+{
+	PostingEntry e;
+
+	GetEntry(slotNo, e);
+	cursor.page = e.overflow;
+	cursor.index = 0;
+	cursor.offset = 0;
+	cursor.prev.pageNo = 0;
+	cursor.prev.slotNo = 0;
+}
+
+
+//-------------------------------------------------------------------
+// BTPostingPage::NextRid
+//
+// Input   : slotNo - slot of the entry being read.
+//           cursor - position in its posting list.
+// Output  : dataRid - the next rid in the list.
+//           cursor - advanced past it.
+// Purpose : Read the posting list of an entry one rid at a time,
+//           following its overflow chain.  Only the overflow page
+//           being read is pinned, and only during the call.
+// Return  : OK if successful, DONE if there are no more rids.
+//-------------------------------------------------------------------
+
+Status BTPostingPage::NextRid (int slotNo, PostingCursor &cursor, RecordID &dataRid)
+{
+	const unsigned char *p;
+	BTOverflowPage *page;
+
+	if (cursor.page == INVALID_PAGE)
+	{
+		PostingEntry e;
+
+		GetEntry(slotNo, e);
+		if (cursor.index >= e.numRids)
+			return DONE;
+
+		p = DecodeRid(e.rids + cursor.offset, cursor.prev);
+		cursor.offset = p - e.rids;
+		cursor.index++;
+		dataRid = cursor.prev;
+		return OK;
+	}
+
+	PIN(cursor.page, page);
+	while (cursor.index >= page->GetNumOfRids())
+	{
+		PageID nextPageID = page->GetNextPage();
+
+		if (nextPageID == INVALID_PAGE)
+		{
+			UNPIN(cursor.page, CLEAN);
+			return DONE;
+		}
+
+		UNPIN(cursor.page, CLEAN);
+		cursor.page = nextPageID;
+		cursor.index = 0;
+		cursor.offset = 0;
+		cursor.prev.pageNo = 0;
+		cursor.prev.slotNo = 0;
+		PIN(cursor.page, page);
+	}
+
+	p = DecodeRid(page->GetRidData() + cursor.offset, cursor.prev);
+	cursor.offset = p - page->GetRidData();
+	cursor.index++;
+	dataRid = cursor.prev;
+
+	UNPIN(cursor.page, CLEAN);
+	return OK;
+}
@@ -5,7 +5,9 @@
 #include <cassert>
 #include <ctime>
 #include <vector>
+#include <set>
 #include <algorithm>
+#include <string>
 
 using namespace std;
 
@@ -14,6 +16,10 @@ using namespace std;
 #include "db.h"
 #include "btfile.h"
 #include "btreeDriver.h"
+#include "btfilescan.h"
+#include "hashindex.h"
+#include "memindex.h"
+#include "compositekey.h"
 
 
 void TestScanCount(int actualCount, int expectedCount) {
@@ -31,11 +37,11 @@ Status BTreeDriver::runTests() {
 	char *inputTxt = new char[inTxtLen];
 
 	cout << "Input a space separated test sequence (ie. a list of numbers " << endl <<
-		" in the range 0-7: 0 3 2 1) or hit ENTER to run all tests: ";
+		" in the range 0-9, or a-q for tests 10-26: 0 3 2 1) or hit ENTER to run all tests: ";
 
 	cin.getline (inputTxt, inTxtLen);
 	if (strlen(inputTxt) == 0) {
-		inputTxt = "01234567";
+		inputTxt = "0123456789abcdefghijklmnopq";
 	}
 	
 	minibase_globals = new SystemDefs(status, "BTREEDRIVER", "btlog", 1000, 500, 200, "Clock");
@@ -75,6 +81,63 @@ Status BTreeDriver::runTests() {
 		case '7':
 			result = Test7();
 			break;
+		case '8':
+			result = Test8();
+			break;
+		case '9':
+			result = Test9();
+			break;
+		case 'a':
+			result = Test10();
+			break;
+		case 'b':
+			result = Test11();
+			break;
+		case 'c':
+			result = Test12();
+			break;
+		case 'd':
+			result = Test13();
+			break;
+		case 'e':
+			result = Test14();
+			break;
+		case 'f':
+			result = Test15();
+			break;
+		case 'g':
+			result = Test16();
+			break;
+		case 'h':
+			result = Test17();
+			break;
+		case 'i':
+			result = Test18();
+			break;
+		case 'j':
+			result = Test19();
+			break;
+		case 'k':
+			result = Test20();
+			break;
+		case 'l':
+			result = Test21();
+			break;
+		case 'm':
+			result = Test22();
+			break;
+		case 'n':
+			result = Test23();
+			break;
+		case 'o':
+			result = Test24();
+			break;
+		case 'p':
+			result = Test25();
+			break;
+		case 'q':
+			result = Test26();
+			break;
 		}
 
 		if (!result || minibase_errors.error()) {
@@ -280,9 +343,9 @@ bool BTreeDriver::Test3() {
 		exit(1);
 	}
 
-	//	Insert 31 long keys.
-	if (!InsertRange(btf, 1, 31, 1, 20)) {
-		std::cerr << "InsertRange(1, 31) failed" << std::endl;
+	//	Insert 32 long keys, one more than fits on a leaf.
+	if (!InsertRange(btf, 1, 32, 1, 20)) {
+		std::cerr << "InsertRange(1, 32) failed" << std::endl;
 		res = false;
 	}
 
@@ -292,7 +355,7 @@ bool BTreeDriver::Test3() {
 	} 
 
 	std::vector<int> expectedKeys;
-	for (int i = 1; i <= 31; i++) {
+	for (int i = 1; i <= 32; i++) {
 		expectedKeys.push_back(i);
 	}
 
@@ -332,9 +395,9 @@ bool BTreeDriver::Test4() {
 		exit(1);
 	}
 
-	//	Similary, insert keys in [1, 31], but this time insert in a different ordering.
-	if (!InsertRange(btf, 17, 31, 1, 20)) {
-		std::cerr << "InsertRange(17, 31) failed" << std::endl;
+	//	Similary, insert keys in [1, 32], but this time insert in a different ordering.
+	if (!InsertRange(btf, 17, 32, 1, 20)) {
+		std::cerr << "InsertRange(17, 32) failed" << std::endl;
 		res = false;
 	}
 	if (!InsertRange(btf, 1, 15, 1, 20)) {
@@ -362,7 +425,7 @@ bool BTreeDriver::Test4() {
 	}
 
 	std::vector<int> expectedKeys;
-	for (int i = 1; i <= 31; i++) {
+	for (int i = 1; i <= 32; i++) {
 		if (i % 5 != 0) 
 			expectedKeys.push_back(i);
 	}
@@ -712,198 +775,2721 @@ bool BTreeDriver::Test7() {
 	return res;
 }
 
-//	Test Helper functions
+//	Test composite keys and prefix scans
+bool BTreeDriver::Test8() {
+	Status status = OK;
+	BTreeFile *btf = NULL;
+	bool res = true;
 
-//-------------------------------------------------------------------
-// BTreeDriver::InsertRange
-//
-// Input   : btf,  The BTree to insert into.
-//           low,  The beginning of the range (inclusive).
-//           high, The end of the range (inclusive).
-//           ridOffset, The offset used to compute the rid.
-//           pad,  The amount of padding to use for the keys.
-//           reverse, Whether to insert in reverse order.
-// Output  : None
-// Return  : True if this operation completed succesfully.
-// Purpose : Inserts a range of keys into the B-Tree.
-//-------------------------------------------------------------------
-bool BTreeDriver::InsertRange(BTreeFile *btf, int low, int high,
-							  int ridOffset, int pad, bool reverse) {
-	int numKeys = high - low + 1;
-	int keyNum;
+	btf = new BTreeFile(status, "TestCompositeKeys");
 
-	char skey[MAX_KEY_SIZE];
+	if (status != OK) {
+		std::cerr << "ERROR: Couldn't create a BTreeFile" << std::endl;
+		minibase_errors.show_errors();
 
-	int i;
-	if (reverse) {
-		i = numKeys - 1;
-	} else {
-		i = 0;
+		std::cerr << "Hit [enter] to continue..." << std::endl;
+		std::cin.get();
+		exit(1);
 	}
 
-	while (reverse && i >= 0 || !reverse && i < numKeys) {
-		RecordID rid;
-		keyNum = i+low;
-		rid.pageNo=keyNum + ridOffset;
-		rid.slotNo=keyNum + ridOffset + 1;
-		BTreeDriver::toString(keyNum, skey, pad);
+	KeySchema schema;
+	if (schema.AddColumn(attrInteger, 4) != OK || schema.AddColumn(attrString, 10) != OK) {
+		std::cerr << "KeySchema::AddColumn failed" << std::endl;
+		res = false;
+	}
 
-		if (btf->Insert(skey, rid) != OK) {
-			std::cerr << "Insertion of range failed at key=" << skey
-					  << " rid=" << rid << std::endl;
-			minibase_errors.show_errors();
-			return false;
+	//	Insert (i, "s<j>") for i in [-5, 5] and j in [0, 9], out of order.
+	//	The record id numbers the entries in key order.
+	char str[MAX_KEY_SIZE];
+	for (int n = 0; n < 110; n++) {
+		int pos = (n * 37) % 110;
+		CompositeKey key(schema);
+		sprintf_s(str, MAX_KEY_SIZE, "s%d", pos % 10);
+		if (key.AppendInt(pos / 10 - 5) != OK || key.AppendString(str) != OK) {
+			std::cerr << "Encoding composite key " << pos << " failed" << std::endl;
+			res = false;
+			break;
 		}
 
-		if (reverse) {
-			i--;
-		} else {
-			i++;
+		RecordID rid;
+		rid.pageNo = pos;
+		rid.slotNo = 0;
+		if (btf->Insert(key.GetKeyView(), rid) != OK) {
+			std::cerr << "Inserting composite key " << pos << " failed" << std::endl;
+			res = false;
+			break;
 		}
 	}
 
-	return true;
-}
-
-//	Delete from BTree with a certain stride
-bool BTreeDriver::DeleteStride(BTreeFile *btf, int low, int high,
-							  int stride, int pad) {
-	char lowKey[MAX_KEY_SIZE];
-	char highKey[MAX_KEY_SIZE];
-    BTreeDriver::toString(low, lowKey, pad);
-    BTreeDriver::toString(high, highKey, pad);
-
-	IndexFileScan* scan = btf->OpenScan(lowKey, highKey);
+	//	Negative integers must sort before positive ones.
+	BTreeFileScan *scan = (BTreeFileScan *)btf->OpenScan(NULL, NULL);
 	RecordID rid;
 	char curKey[MAX_KEY_SIZE];
-	int count = 0;
+	int curLen;
+	int numEntries = 0;
+	while (scan->GetNext(rid, curKey, curLen) != DONE) {
+		if (rid.pageNo != numEntries) {
+			std::cerr << "Composite key " << rid.pageNo << " scanned at " << numEntries << std::endl;
+			res = false;
+			break;
+		}
+		numEntries++;
+	}
+	delete scan;
 
-	std::vector<std::pair<char*, RecordID>*> deleteVec;
+	if (numEntries != 110) {
+		std::cerr << "Scanned " << numEntries << " composite keys, expected 110" << std::endl;
+		res = false;
+	}
 
-	while(scan->GetNext(rid, curKey) != DONE) {
-		char* tempKey = new char[MAX_KEY_SIZE];
-		memcpy(tempKey, curKey, strlen(curKey) + 1);
+	//	A prefix scan on the first column sees exactly the ten keys with it.
+	for (int i = -6; i <= 6; i++) {
+		CompositeKey prefix(schema);
+		prefix.AppendInt(i);
 
-		if(count == 0) {
-			deleteVec.push_back(new std::pair<char*, RecordID>(tempKey, rid));
+		int expected = (i < -5 || i > 5) ? 0 : 10;
+		scan = (BTreeFileScan *)btf->OpenPrefixScan(prefix.GetKeyView());
+		numEntries = 0;
+		while (scan->GetNext(rid, curKey, curLen) != DONE) {
+			if (rid.pageNo != (i + 5) * 10 + numEntries) {
+				res = false;
+			}
+			numEntries++;
+		}
+		delete scan;
+
+		if (numEntries != expected) {
+			std::cerr << "OpenPrefixScan(" << i << ") returned " << numEntries
+					  << " keys, expected " << expected << std::endl;
+			res = false;
+		}
+	}
+
+	//	Delete the keys whose first column is 0.
+	for (int j = 0; j < 10; j++) {
+		CompositeKey key(schema);
+		sprintf_s(str, MAX_KEY_SIZE, "s%d", j);
+		key.AppendInt(0);
+		key.AppendString(str);
+
+		rid.pageNo = 50 + j;
+		rid.slotNo = 0;
+		if (btf->Delete(key.GetKeyView(), rid) != OK) {
+			std::cerr << "Deleting composite key " << 50 + j << " failed" << std::endl;
+			res = false;
 		}
-		count = (count + 1)	% stride;
 	}
 
+	CompositeKey zero(schema);
+	zero.AppendInt(0);
+	scan = (BTreeFileScan *)btf->OpenPrefixScan(zero.GetKeyView());
+	if (!TestScanCount(scan, 0)) {
+		std::cerr << "OpenPrefixScan(0) still finds deleted keys" << std::endl;
+		res = false;
+	}
 	delete scan;
 
-	int numToDelete = deleteVec.size();
-	int numDeleted = 0;
+	//	A prefix longer than any key is refused.
+	char longPrefix[MAX_KEY_SIZE];
+	memset(longPrefix, 0, MAX_KEY_SIZE);
+	KeyView longView = { longPrefix, MAX_KEY_SIZE };
+	if (btf->OpenPrefixScan(longView) != NULL) {
+		std::cerr << "OpenPrefixScan accepted a prefix longer than a key" << std::endl;
+		res = false;
+	}
 
-	std::vector<std::pair<char*, RecordID>*>::iterator it;
-	for(it = deleteVec.begin(); it != deleteVec.end(); it++) {
-		std::pair<char*, RecordID>* pair = *it;
-		if(btf->Delete(pair->first, pair->second) == OK) {
-			numDeleted++;
-		}
+	if (!TestNumEntries(btf, 100)) {
+		std::cerr << "TestNumEntries(100) failed" << std::endl;
+		res = false;
 	}
 
-	for(it = deleteVec.begin(); it != deleteVec.end(); it++) {
-		delete [] (*it)->first;
-		delete *it;
+	//	Values that do not fit the schema are rejected.
+	KeySchema shortSchema;
+	shortSchema.AddColumn(attrInteger, 2);
+	CompositeKey shortKey(shortSchema);
+	if (shortKey.AppendInt(70000) != FAIL) {
+		std::cerr << "AppendInt accepted a value too large for a 2-byte column" << std::endl;
+		res = false;
+	}
+	if (shortKey.AppendInt(-32768) != OK) {
+		std::cerr << "AppendInt rejected the smallest 2-byte value" << std::endl;
+		res = false;
+	}
+	if (shortKey.AppendInt(1) != FAIL) {
+		std::cerr << "AppendInt accepted a column beyond the schema" << std::endl;
+		res = false;
 	}
 
-	if(numDeleted != numToDelete) {
-		std::cerr << "Error: Attempted to delete " << numToDelete
-         	      << "pairs. Only able to delete " << numDeleted << std::endl;
-		return false;
+	CompositeKey badType(schema);
+	if (badType.AppendString("s0") != FAIL) {
+		std::cerr << "AppendString accepted a string for an integer column" << std::endl;
+		res = false;
 	}
 
-	return true;
+	if (btf->DestroyFile() != OK) {
+		std::cerr << "Error destroying BTreeFile" << std::endl;
+		res = false;
+	}
+
+	delete btf;
 
+	if (res) {
+		std::cout << "Test 8 Passed!" << std::endl;
+	}
+	return res;
 }
 
-//-------------------------------------------------------------------
-// BTreeDriver::TestNumLeafPages
-//
-// Input   : btf,  The BTree to test
-//           expected,  The number of leaf pages you expect.
-// Output  : None
-// Return  : True if the number of leaf pages == expected.
-// Purpose : Tests the number of leaf pages in the tree.
-//-------------------------------------------------------------------
-bool BTreeDriver::TestNumLeafPages(BTreeFile *btf, int expected)
-{
-	PageID pid = GetLeftmostLeaf(btf);
+//	Test posting-list leaves against a tree with plain leaves
+bool BTreeDriver::Test9() {
+	Status status = OK;
+	BTreeFile *btf = NULL;
+	BTreeFile *ref = NULL;
+	bool res = true;
 
-	if (pid == INVALID_PAGE) {
-		std::cerr << "Unable to access left leaf" << std::endl;
-		return false;
+	btf = new BTreeFile(status, "TestPostingLists", POSTING_NODE);
+
+	if (status == OK) {
+		ref = new BTreeFile(status, "TestPostingListsRef");
 	}
 
-	int numPages = 0;
+	if (status != OK) {
+		std::cerr << "ERROR: Couldn't create a BTreeFile" << std::endl;
+		minibase_errors.show_errors();
 
-	while (pid != INVALID_PAGE) {
-		numPages++;
+		std::cerr << "Hit [enter] to continue..." << std::endl;
+		std::cin.get();
+		exit(1);
+	}
 
-		SortedPage *page;
-		if (MINIBASE_BM->PinPage(pid, (Page *&)page) == FAIL) {
-			std::cerr << "Unable to pin page" << std::endl;
-			return false;
+	//	Three keys with 600 record ids each, enough for overflow chains,
+	//	mixed with 200 unique keys.  The record ids of a key arrive out
+	//	of order, so the chains split in the middle.
+	char key[MAX_KEY_SIZE];
+	RecordID rid;
+	for (int i = 0; i < 2000; i++) {
+		if (i % 10 == 0) {
+			toString(i / 10, key, 5);
+		} else {
+			sprintf_s(key, MAX_KEY_SIZE, "dup%d", i % 3);
 		}
+		rid.pageNo = (i * 7919) % 5000;
+		rid.slotNo = i % 20;
 
-		pid = page->GetNextPage();
-
-		if (MINIBASE_BM->UnpinPage(page->PageNo(), CLEAN) == FAIL) {
-			std::cerr << "Unable to unpin page" << std::endl;
-			return false;
+		if (btf->Insert(key, rid) != OK || ref->Insert(key, rid) != OK) {
+			std::cerr << "Inserting entry " << i << " failed" << std::endl;
+			res = false;
+			break;
 		}
 	}
 
-	if (numPages != expected) {
-		std::cerr << "Unexpected number of leaf pages. Expected " << expected
-				  << ", but got " << numPages << std::endl;
-		return false;
+	if (!TestSameEntries(btf, ref)) {
+		std::cerr << "TestSameEntries() failed after inserts" << std::endl;
+		res = false;
 	}
 
-	return true;
-}
+	RecordID rids[700];
+	int numRids;
+	if (btf->Lookup("dup1", rids, 700, numRids) != OK || numRids != 600) {
+		std::cerr << "Lookup(dup1) failed" << std::endl;
+		res = false;
+	}
+	if (btf->Lookup("dup1", rids, 100, numRids) != DONE || numRids != 100) {
+		std::cerr << "Lookup(dup1) did not stop at 100 record ids" << std::endl;
+		res = false;
+	}
 
-//	Get the leftmost leaf page in this index.
-PageID BTreeDriver::GetLeftmostLeaf(BTreeFile *btf) {
-	PageID curPid = btf->header->GetRootPageID();
+	//	Delete every other entry, then an entry that is not there.
+	for (int i = 0; i < 2000; i += 2) {
+		if (i % 10 == 0) {
+			toString(i / 10, key, 5);
+		} else {
+			sprintf_s(key, MAX_KEY_SIZE, "dup%d", i % 3);
+		}
+		rid.pageNo = (i * 7919) % 5000;
+		rid.slotNo = i % 20;
 
-	while (curPid != INVALID_PAGE) {
-		SortedPage *curPage;
+		if (btf->Delete(key, rid) != OK || ref->Delete(key, rid) != OK) {
+			std::cerr << "Deleting entry " << i << " failed" << std::endl;
+			res = false;
+			break;
+		}
+	}
 
-		if (MINIBASE_BM->PinPage(curPid, (Page *&)curPage) == FAIL) {
-			std::cerr << "Unable to pin page" << std::endl;
-			return INVALID_PAGE;
+	rid.pageNo = 0;
+	rid.slotNo = 0;
+	if (btf->Delete("dup2", rid) == OK) {
+		std::cerr << "Deleting a missing record id succeeded" << std::endl;
+		res = false;
+	}
+
+	if (!TestSameEntries(btf, ref)) {
+		std::cerr << "TestSameEntries() failed after deletes" << std::endl;
+		res = false;
+	}
+
+	//	Delete the rest, emptying the overflow chains.
+	for (int i = 1; i < 2000; i += 2) {
+		if (i % 10 == 0) {
+			toString(i / 10, key, 5);
+		} else {
+			sprintf_s(key, MAX_KEY_SIZE, "dup%d", i % 3);
 		}
-	
-		NodeType nodeType = curPage->GetType();
+		rid.pageNo = (i * 7919) % 5000;
+		rid.slotNo = i % 20;
 
-		if (nodeType == LEAF_NODE) {
-			//	If we have reached a leaf page, then we are done.
+		if (btf->Delete(key, rid) != OK) {
+			std::cerr << "Deleting entry " << i << " failed" << std::endl;
+			res = false;
 			break;
-		} else {
-			//	Traverse down to the leftmost branch
-			PageID tempPid = curPage->GetPrevPage();
+		}
+	}
 
-			if (MINIBASE_BM->UnpinPage(curPid, CLEAN) == FAIL) {
-				std::cerr << "Unable to unpin page" << std::endl;
-				return INVALID_PAGE;
-			}
+	if (!TestNumEntries(btf, 0)) {
+		std::cerr << "TestNumEntries(0) failed" << std::endl;
+		res = false;
+	}
 
-			curPid = tempPid;
-		}
+	if (btf->Lookup("dup0", rids, 700, numRids) != OK || numRids != 0) {
+		std::cerr << "Lookup(dup0) found deleted entries" << std::endl;
+		res = false;
 	}
 
-	if (curPid != INVALID_PAGE) {
-		if (MINIBASE_BM->UnpinPage(curPid, CLEAN) == FAIL) {
-			std::cerr << "Unable to unpin page" << std::endl;
-			return INVALID_PAGE;
-		}
+	if (btf->DestroyFile() != OK || ref->DestroyFile() != OK) {
+		std::cerr << "Error destroying BTreeFile" << std::endl;
+		res = false;
 	}
-	return curPid;
+
+	delete btf;
+	delete ref;
+
+	if (res) {
+		std::cout << "Test 9 Passed!" << std::endl;
+	}
+	return res;
 }
 
-//-------------------------------------------------------------------
+//	Test Lookup and MultiGet
+bool BTreeDriver::Test10() {
+	Status status = OK;
+	BTreeFile *btf = NULL;
+	bool res = true;
+
+	btf = new BTreeFile(status, "TestMultiGet");
+
+	if (status != OK) {
+		std::cerr << "ERROR: Couldn't create a BTreeFile" << std::endl;
+		minibase_errors.show_errors();
+
+		std::cerr << "Hit [enter] to continue..." << std::endl;
+		std::cin.get();
+		exit(1);
+	}
+
+	//	Looking up keys in an empty tree finds nothing.
+	std::vector<int> keys;
+	std::vector<int> counts;
+	for (int i = 1; i <= 10; i++) {
+		keys.push_back(i);
+		counts.push_back(0);
+	}
+
+	if (!TestMultiGet(btf, keys, counts)) {
+		std::cerr << "TestMultiGet() failed on an empty tree" << std::endl;
+		res = false;
+	}
+
+	//	Key i gets i % 3 + 1 record ids, for i in [1, 600].
+	RecordID rid;
+	char key[MAX_KEY_SIZE];
+	for (int i = 1; i <= 600 && res; i++) {
+		toString(i, key);
+		rid.pageNo = i;
+		for (rid.slotNo = 0; rid.slotNo <= i % 3; rid.slotNo++) {
+			if (btf->Insert(key, rid) != OK) {
+				std::cerr << "Inserting key " << key << " failed" << std::endl;
+				res = false;
+				break;
+			}
+		}
+	}
+
+	//	Every key from 0 to 700 in order, so that some are missing at
+	//	both ends, then every seventh key in descending order.
+	keys.clear();
+	counts.clear();
+	for (int i = 0; i <= 700; i++) {
+		keys.push_back(i);
+		counts.push_back(i >= 1 && i <= 600 ? i % 3 + 1 : 0);
+	}
+
+	if (!TestMultiGet(btf, keys, counts)) {
+		std::cerr << "TestMultiGet() failed on sorted keys" << std::endl;
+		res = false;
+	}
+
+	std::reverse(keys.begin(), keys.end());
+	std::reverse(counts.begin(), counts.end());
+	for (unsigned int i = 0; i < keys.size(); i += 7) {
+		keys[i / 7] = keys[i];
+		counts[i / 7] = counts[i];
+	}
+	keys.resize((keys.size() + 6) / 7);
+	counts.resize(keys.size());
+
+	if (!TestMultiGet(btf, keys, counts)) {
+		std::cerr << "TestMultiGet() failed on unsorted keys" << std::endl;
+		res = false;
+	}
+
+	//	Delete the even keys; MultiGet and Lookup no longer find them.
+	for (int i = 2; i <= 600 && res; i += 2) {
+		toString(i, key);
+		rid.pageNo = i;
+		for (rid.slotNo = 0; rid.slotNo <= i % 3; rid.slotNo++) {
+			if (btf->Delete(key, rid) != OK) {
+				std::cerr << "Deleting key " << key << " failed" << std::endl;
+				res = false;
+				break;
+			}
+		}
+	}
+
+	keys.clear();
+	counts.clear();
+	for (int i = 1; i <= 600; i++) {
+		keys.push_back(i);
+		counts.push_back(i % 2 == 1 ? i % 3 + 1 : 0);
+	}
+
+	if (!TestMultiGet(btf, keys, counts)) {
+		std::cerr << "TestMultiGet() failed after deletes" << std::endl;
+		res = false;
+	}
+
+	//	A buffer too small for the batch stops it with DONE.
+	std::vector<KeyView> keyViews(keys.size());
+	std::vector<std::string> keyStrings(keys.size());
+	std::vector<int> numRids(keys.size());
+	RecordID rids[50];
+	for (unsigned int i = 0; i < keys.size(); i++) {
+		toString(keys[i], key);
+		keyStrings[i] = key;
+		keyViews[i].key = keyStrings[i].c_str();
+		keyViews[i].length = (int)keyStrings[i].size();
+	}
+
+	if (btf->MultiGet(&keyViews[0], (int)keys.size(), rids, 50, &numRids[0]) != DONE) {
+		std::cerr << "MultiGet() did not stop at 50 record ids" << std::endl;
+		res = false;
+	} else {
+		int total = 0;
+		for (unsigned int i = 0; i < keys.size(); i++) {
+			total += numRids[i];
+		}
+		if (total != 50) {
+			std::cerr << "MultiGet() returned " << total << " record ids, expected 50" << std::endl;
+			res = false;
+		}
+	}
+
+	if (btf->DestroyFile() != OK) {
+		std::cerr << "Error destroying BTreeFile" << std::endl;
+		res = false;
+	}
+
+	delete btf;
+
+	if (res) {
+		std::cout << "Test 10 Passed!" << std::endl;
+	}
+	return res;
+}
+
+//	Test MultiGetInterleaved
+bool BTreeDriver::Test11() {
+	Status status = OK;
+	BTreeFile *btf = NULL;
+	bool res = true;
+
+	btf = new BTreeFile(status, "TestMultiGetInterleaved");
+
+	if (status != OK) {
+		std::cerr << "ERROR: Couldn't create a BTreeFile" << std::endl;
+		minibase_errors.show_errors();
+
+		std::cerr << "Hit [enter] to continue..." << std::endl;
+		std::cin.get();
+		exit(1);
+	}
+
+	//	Key i gets i % 3 + 1 record ids, for i in [1, 1500].
+	RecordID rid;
+	char key[MAX_KEY_SIZE];
+	for (int i = 1; i <= 1500 && res; i++) {
+		toString(i, key);
+		rid.pageNo = i;
+		for (rid.slotNo = 0; rid.slotNo <= i % 3; rid.slotNo++) {
+			if (btf->Insert(key, rid) != OK) {
+				std::cerr << "Inserting key " << key << " failed" << std::endl;
+				res = false;
+				break;
+			}
+		}
+	}
+
+	//	Keys from 0 to 2000 in random order, so that each group mixes
+	//	keys that are there with keys that are not.
+	std::vector<int> keys;
+	std::vector<int> counts;
+	for (int i = 0; i <= 2000; i++) {
+		keys.push_back(i);
+	}
+
+	srand(7654321);
+	std::random_shuffle(keys.begin(), keys.end());
+	for (unsigned int i = 0; i < keys.size(); i++) {
+		counts.push_back(keys[i] >= 1 && keys[i] <= 1500 ? keys[i] % 3 + 1 : 0);
+	}
+
+	if (!TestMultiGet(btf, keys, counts, true)) {
+		std::cerr << "TestMultiGet() failed on shuffled keys" << std::endl;
+		res = false;
+	}
+
+	//	A batch smaller than a group, with the same key more than once.
+	keys.clear();
+	counts.clear();
+	keys.push_back(700);
+	keys.push_back(5);
+	keys.push_back(700);
+	for (unsigned int i = 0; i < keys.size(); i++) {
+		counts.push_back(keys[i] % 3 + 1);
+	}
+
+	if (!TestMultiGet(btf, keys, counts, true)) {
+		std::cerr << "TestMultiGet() failed on a short batch" << std::endl;
+		res = false;
+	}
+
+	//	Delete every key divisible by 5.
+	for (int i = 5; i <= 1500 && res; i += 5) {
+		toString(i, key);
+		rid.pageNo = i;
+		for (rid.slotNo = 0; rid.slotNo <= i % 3; rid.slotNo++) {
+			if (btf->Delete(key, rid) != OK) {
+				std::cerr << "Deleting key " << key << " failed" << std::endl;
+				res = false;
+				break;
+			}
+		}
+	}
+
+	keys.clear();
+	counts.clear();
+	for (int i = 1500; i >= 1; i -= 3) {
+		keys.push_back(i);
+		counts.push_back(i % 5 != 0 ? i % 3 + 1 : 0);
+	}
+
+	if (!TestMultiGet(btf, keys, counts, true)) {
+		std::cerr << "TestMultiGet() failed after deletes" << std::endl;
+		res = false;
+	}
+
+	//	A buffer too small for the batch stops it with DONE.
+	std::vector<KeyView> keyViews(keys.size());
+	std::vector<std::string> keyStrings(keys.size());
+	std::vector<int> numRids(keys.size());
+	RecordID rids[50];
+	for (unsigned int i = 0; i < keys.size(); i++) {
+		toString(keys[i], key);
+		keyStrings[i] = key;
+		keyViews[i].key = keyStrings[i].c_str();
+		keyViews[i].length = (int)keyStrings[i].size();
+	}
+
+	if (btf->MultiGetInterleaved(&keyViews[0], (int)keys.size(), rids, 50, &numRids[0]) != DONE) {
+		std::cerr << "MultiGetInterleaved() did not stop at 50 record ids" << std::endl;
+		res = false;
+	} else {
+		int total = 0;
+		for (unsigned int i = 0; i < keys.size(); i++) {
+			total += numRids[i];
+		}
+		if (total > 50) {
+			std::cerr << "MultiGetInterleaved() returned " << total << " record ids, expected at most 50" << std::endl;
+			res = false;
+		}
+	}
+
+	if (btf->DestroyFile() != OK) {
+		std::cerr << "Error destroying BTreeFile" << std::endl;
+		res = false;
+	}
+
+	delete btf;
+
+	if (res) {
+		std::cout << "Test 11 Passed!" << std::endl;
+	}
+	return res;
+}
+
+//	Test the Bloom filter and its rebuild
+bool BTreeDriver::Test12() {
+	Status status = OK;
+	BTreeFile *btf = NULL;
+	bool res = true;
+
+	btf = new BTreeFile(status, "TestBloomFilter");
+
+	if (status != OK) {
+		std::cerr << "ERROR: Couldn't create a BTreeFile" << std::endl;
+		minibase_errors.show_errors();
+
+		std::cerr << "Hit [enter] to continue..." << std::endl;
+		std::cin.get();
+		exit(1);
+	}
+
+	if (!InsertRange(btf, 1, 2000, 0, 5)) {
+		std::cerr << "InsertRange(1, 2000) failed" << std::endl;
+		res = false;
+	}
+
+	if (btf->CreateBloomFilter(2500) != OK || btf->header->GetBloomPageID() == INVALID_PAGE) {
+		std::cerr << "CreateBloomFilter(2500) failed" << std::endl;
+		res = false;
+	}
+
+	//	Keys inserted after the filter was made go into it too.
+	if (!InsertRange(btf, 2001, 2500, 0, 5)) {
+		std::cerr << "InsertRange(2001, 2500) failed" << std::endl;
+		res = false;
+	}
+
+	//	No key that is there may be missed; few that are not may be let
+	//	through, and those must still not be found.
+	char key[MAX_KEY_SIZE];
+	RecordID rids[2];
+	int numRids;
+	bool mayContain;
+	int numFalsePositives = 0;
+	for (int i = 1; i <= 5000; i++) {
+		toString(i, key, 5);
+		if (btf->BloomMayContain(MakeKeyView(key), mayContain) != OK) {
+			std::cerr << "BloomMayContain() failed" << std::endl;
+			res = false;
+			break;
+		}
+
+		if (i <= 2500 && !mayContain) {
+			std::cerr << "Bloom filter misses key " << key << std::endl;
+			res = false;
+			break;
+		}
+		if (i > 2500 && mayContain) {
+			numFalsePositives++;
+		}
+
+		if (btf->Lookup(key, rids, 2, numRids) != OK || numRids != (i <= 2500 ? 1 : 0)) {
+			std::cerr << "Lookup(" << key << ") found " << numRids << " record ids" << std::endl;
+			res = false;
+			break;
+		}
+	}
+
+	if (numFalsePositives > 250) {
+		std::cerr << "Bloom filter let " << numFalsePositives << " of 2500 missing keys through" << std::endl;
+		res = false;
+	}
+
+	std::vector<int> expectedKeys;
+	for (int i = 2501; i <= 2510; i++) {
+		toString(i, key, 5);
+		if (!TestScanKeys(btf, key, key, expectedKeys, 5)) {
+			std::cerr << "TestScanKeys(" << key << ", " << key << ") failed" << std::endl;
+			res = false;
+		}
+	}
+
+	//	Deleting more than half the entries starts a new filter, which is
+	//	built a few pages per insert or delete and then replaces the old.
+	PageID firstPageID = btf->header->GetBloomPageID();
+	bool rebuildStarted = false;
+	for (int i = 1; i <= 1500 && res; i++) {
+		if (!DeleteKey(btf, i, 5, false)) {
+			res = false;
+		}
+		if (btf->header->GetBloomRebuildPageID() != INVALID_PAGE) {
+			rebuildStarted = true;
+		}
+
+		if (i % 250 == 0) {
+			for (int j = i + 1; j <= 2500; j++) {
+				toString(j, key, 5);
+				if (btf->Lookup(key, rids, 2, numRids) != OK || numRids != 1) {
+					std::cerr << "Lookup(" << key << ") failed while rebuilding the Bloom filter" << std::endl;
+					res = false;
+					break;
+				}
+			}
+		}
+	}
+
+	if (!rebuildStarted || btf->header->GetBloomPageID() == firstPageID ||
+		btf->header->GetBloomRebuildPageID() != INVALID_PAGE) {
+		std::cerr << "The Bloom filter was not rebuilt after deletes" << std::endl;
+		res = false;
+	}
+
+	//	A full rebuild drops the deleted keys.
+	if (btf->RebuildBloomFilter() != OK) {
+		std::cerr << "RebuildBloomFilter() failed" << std::endl;
+		res = false;
+	}
+
+	numFalsePositives = 0;
+	for (int i = 1; i <= 2500; i++) {
+		toString(i, key, 5);
+		btf->BloomMayContain(MakeKeyView(key), mayContain);
+		if (i > 1500 && !mayContain) {
+			std::cerr << "Rebuilt Bloom filter misses key " << key << std::endl;
+			res = false;
+			break;
+		}
+		if (i <= 1500 && mayContain) {
+			numFalsePositives++;
+		}
+	}
+
+	if (numFalsePositives > 150) {
+		std::cerr << "Rebuilt Bloom filter let " << numFalsePositives << " of 1500 deleted keys through" << std::endl;
+		res = false;
+	}
+
+	if (!TestNumEntries(btf, 1000)) {
+		std::cerr << "TestNumEntries(1000) failed" << std::endl;
+		res = false;
+	}
+
+	//	Without the filter, lookups search the tree again.
+	if (btf->DestroyBloomFilter() != OK || btf->header->GetBloomPageID() != INVALID_PAGE) {
+		std::cerr << "DestroyBloomFilter() failed" << std::endl;
+		res = false;
+	}
+	if (btf->DestroyBloomFilter() != OK) {
+		std::cerr << "DestroyBloomFilter() failed without a filter" << std::endl;
+		res = false;
+	}
+
+	toString(2000, key, 5);
+	if (btf->Lookup(key, rids, 2, numRids) != OK || numRids != 1) {
+		std::cerr << "Lookup(" << key << ") failed without a Bloom filter" << std::endl;
+		res = false;
+	}
+
+	//	Destroying the file in the middle of a rebuild frees both filters.
+	if (btf->CreateBloomFilter(1000) != OK) {
+		std::cerr << "CreateBloomFilter(1000) failed" << std::endl;
+		res = false;
+	}
+	for (int i = 1501; i <= 2100 && btf->header->GetBloomRebuildPageID() == INVALID_PAGE; i++) {
+		if (!DeleteKey(btf, i, 5, false)) {
+			res = false;
+			break;
+		}
+	}
+	if (btf->header->GetBloomRebuildPageID() == INVALID_PAGE) {
+		std::cerr << "The Bloom filter rebuild did not start" << std::endl;
+		res = false;
+	}
+
+	if (btf->DestroyFile() != OK) {
+		std::cerr << "Error destroying BTreeFile" << std::endl;
+		res = false;
+	}
+
+	delete btf;
+
+	if (res) {
+		std::cout << "Test 12 Passed!" << std::endl;
+	}
+	return res;
+}
+
+//	Test the extendible hash index against a B-Tree
+bool BTreeDriver::Test13() {
+	Status status = OK;
+	IndexFile *index = NULL;
+	BTreeFile *ref = NULL;
+	bool res = true;
+
+	index = OpenIndexFile(status, "TestHashIndex", Hash);
+
+	if (status == OK) {
+		ref = new BTreeFile(status, "TestHashIndexRef");
+	}
+
+	if (status != OK) {
+		std::cerr << "ERROR: Couldn't create a HashIndexFile" << std::endl;
+		minibase_errors.show_errors();
+
+		std::cerr << "Hit [enter] to continue..." << std::endl;
+		std::cin.get();
+		exit(1);
+	}
+
+	//	3000 keys, enough to split buckets and double the directory
+	//	several times, and 400 entries with one key, which can only go
+	//	to an overflow chain.
+	std::vector<std::string> keys;
+	char key[MAX_KEY_SIZE];
+	RecordID rid;
+	for (int i = 0; i < 3400; i++) {
+		if (i < 3000) {
+			toString((i * 7919) % 3000, key, 8);
+			keys.push_back(key);
+		} else {
+			strcpy(key, "dup");
+		}
+		rid.pageNo = i;
+		rid.slotNo = i % 7;
+
+		if (index->Insert(key, rid) != OK || ref->Insert(key, rid) != OK) {
+			std::cerr << "Inserting key " << key << " failed" << std::endl;
+			res = false;
+			break;
+		}
+	}
+	keys.push_back("dup");
+	keys.push_back("missing");
+
+	if (!TestSameLookups(index, ref, keys)) {
+		std::cerr << "TestSameLookups() failed after inserts" << std::endl;
+		res = false;
+	}
+
+	RecordID rids[10];
+	int numRids;
+	if (index->Lookup("dup", rids, 10, numRids) != DONE || numRids != 10) {
+		std::cerr << "Lookup(dup) did not stop at 10 record ids" << std::endl;
+		res = false;
+	}
+
+	//	Delete two keys in three and half the overflow chain, then an
+	//	entry that is not there.
+	for (int i = 0; i < 3400; i++) {
+		if (i < 3000) {
+			if (i % 3 == 0) continue;
+			toString((i * 7919) % 3000, key, 8);
+		} else {
+			if (i % 2 == 0) continue;
+			strcpy(key, "dup");
+		}
+		rid.pageNo = i;
+		rid.slotNo = i % 7;
+
+		if (index->Delete(key, rid) != OK || ref->Delete(key, rid) != OK) {
+			std::cerr << "Deleting key " << key << " failed" << std::endl;
+			res = false;
+			break;
+		}
+	}
+
+	rid.pageNo = 3001;
+	rid.slotNo = 0;
+	if (index->Delete("dup", rid) != FAIL) {
+		std::cerr << "Deleting a missing record id succeeded" << std::endl;
+		res = false;
+	}
+
+	if (!TestSameLookups(index, ref, keys)) {
+		std::cerr << "TestSameLookups() failed after deletes" << std::endl;
+		res = false;
+	}
+
+	//	The index is found again under its name.
+	delete index;
+	index = OpenIndexFile(status, "TestHashIndex", SH_Index);
+	if (status != OK) {
+		std::cerr << "Reopening the HashIndexFile failed" << std::endl;
+		res = false;
+	} else if (!TestSameLookups(index, ref, keys)) {
+		std::cerr << "TestSameLookups() failed after reopening" << std::endl;
+		res = false;
+	}
+
+	if (index == NULL || ((HashIndexFile *)index)->DestroyFile() != OK || ref->DestroyFile() != OK) {
+		std::cerr << "Error destroying HashIndexFile" << std::endl;
+		res = false;
+	}
+
+	delete index;
+	delete ref;
+
+	if (res) {
+		std::cout << "Test 13 Passed!" << std::endl;
+	}
+	return res;
+}
+
+//	Test the hints of the adaptive hash index
+bool BTreeDriver::Test14() {
+	Status status = OK;
+	BTreeFile *btf = NULL;
+	bool res = true;
+
+	for (int pass = 0; pass < 2 && res; pass++) {
+		btf = new BTreeFile(status, "TestHints", pass == 0 ? LEAF_NODE : POSTING_NODE);
+
+		if (status != OK) {
+			std::cerr << "ERROR: Couldn't create a BTreeFile" << std::endl;
+			minibase_errors.show_errors();
+
+			std::cerr << "Hit [enter] to continue..." << std::endl;
+			std::cin.get();
+			exit(1);
+		}
+
+		if (!InsertRange(btf, 1, 2000, 0, 5)) {
+			std::cerr << "InsertRange(1, 2000) failed" << std::endl;
+			res = false;
+		}
+
+		//	A key looked up often enough leaves a hint to its leaf.
+		char key[MAX_KEY_SIZE];
+		RecordID rids[4];
+		int numRids;
+		PageID leafID;
+		int slotNo;
+		toString(1000, key, 5);
+		for (int i = 0; i <= HINT_HOT_PROBES; i++) {
+			btf->Lookup(key, rids, 4, numRids);
+		}
+
+		if (!btf->hints.Find(GetKeyHash(MakeKeyView(key)), leafID, slotNo)) {
+			std::cerr << "Lookup(" << key << ") left no hint" << std::endl;
+			res = false;
+		}
+
+		//	Make every key hot, then move the entries about: a second
+		//	record id for each key splits the leaves, and deletes empty
+		//	some of them.  The hints go stale, but lookups must not.
+		for (int round = 0; round < 4 && res; round++) {
+			for (int i = 1; i <= 2000; i++) {
+				int expected;
+				switch (round) {
+				case 0:  expected = 1; break;
+				case 1:  expected = 2; break;
+				case 2:  expected = 1; break;
+				default: expected = (i > 1000) ? 1 : 0; break;
+				}
+
+				toString(i, key, 5);
+				for (int j = 0; j <= HINT_HOT_PROBES; j++) {
+					if (btf->Lookup(key, rids, 4, numRids) != OK || numRids != expected ||
+						(expected > 0 && rids[expected - 1].pageNo != i)) {
+						std::cerr << "Round " << round << ": Lookup(" << key << ") found "
+								  << numRids << " record ids, expected " << expected << std::endl;
+						res = false;
+						break;
+					}
+				}
+				if (!res) break;
+			}
+
+			RecordID rid;
+			for (int i = 1; i <= 2000 && res; i++) {
+				toString(i, key, 5);
+				rid.pageNo = i;
+				rid.slotNo = (round == 0) ? i + 2 : i + 1;
+
+				if (round == 0) {
+					res = (btf->Insert(key, rid) == OK);
+				} else if (round == 1) {
+					res = (btf->Delete(key, rid) == OK);
+				} else if (round == 2 && i <= 1000) {
+					rid.slotNo = i + 2;
+					res = (btf->Delete(key, rid) == OK);
+				}
+
+				if (!res) {
+					std::cerr << "Round " << round << ": updating key " << key << " failed" << std::endl;
+				}
+			}
+		}
+
+		if (!TestNumEntries(btf, 1000)) {
+			std::cerr << "TestNumEntries(1000) failed" << std::endl;
+			res = false;
+		}
+
+		//	A hint for a key that is gone finds nothing.
+		toString(1, key, 5);
+		if (btf->Lookup(key, rids, 4, numRids) != OK || numRids != 0) {
+			std::cerr << "Lookup(" << key << ") found a deleted entry" << std::endl;
+			res = false;
+		}
+
+		if (btf->DestroyFile() != OK) {
+			std::cerr << "Error destroying BTreeFile" << std::endl;
+			res = false;
+		}
+
+		delete btf;
+	}
+
+	if (res) {
+		std::cout << "Test 14 Passed!" << std::endl;
+	}
+	return res;
+}
+
+//	Test the in-memory B+ tree against a B-Tree
+bool BTreeDriver::Test15() {
+	Status status = OK;
+	MemIndexFile *mem = new MemIndexFile();
+	BTreeFile *ref = NULL;
+	bool res = true;
+
+	ref = new BTreeFile(status, "TestMemIndexRef");
+
+	if (status != OK) {
+		std::cerr << "ERROR: Couldn't create a BTreeFile" << std::endl;
+		minibase_errors.show_errors();
+
+		std::cerr << "Hit [enter] to continue..." << std::endl;
+		std::cin.get();
+		exit(1);
+	}
+
+	//	3000 entries over 1000 keys, deep enough for several levels of
+	//	index nodes.
+	std::vector<std::string> keys;
+	char key[MAX_KEY_SIZE];
+	RecordID rid;
+	for (int i = 0; i < 3000; i++) {
+		toString((i * 7919) % 1000, key, 5);
+		if (i < 1000) {
+			keys.push_back(key);
+		}
+		rid.pageNo = i;
+		rid.slotNo = i % 7;
+
+		if (mem->Insert(key, rid) != OK || ref->Insert(key, rid) != OK) {
+			std::cerr << "Inserting key " << key << " failed" << std::endl;
+			res = false;
+			break;
+		}
+	}
+
+	IndexFileScan *scan = mem->OpenScan();
+	if (!TestSameEntries(scan, ref)) {
+		std::cerr << "TestSameEntries() failed after inserts" << std::endl;
+		res = false;
+	}
+	delete scan;
+
+	if (!TestSameLookups(mem, ref, keys)) {
+		std::cerr << "TestSameLookups() failed after inserts" << std::endl;
+		res = false;
+	}
+
+	//	Delete two entries in three, then one that is not there.
+	for (int i = 0; i < 3000; i++) {
+		if (i % 3 == 0) continue;
+		toString((i * 7919) % 1000, key, 5);
+		rid.pageNo = i;
+		rid.slotNo = i % 7;
+
+		if (mem->Delete(key, rid) != OK || ref->Delete(key, rid) != OK) {
+			std::cerr << "Deleting key " << key << " failed" << std::endl;
+			res = false;
+			break;
+		}
+	}
+
+	rid.pageNo = 3000;
+	rid.slotNo = 0;
+	if (mem->Delete(keys[0].c_str(), rid) != FAIL) {
+		std::cerr << "Deleting a missing entry succeeded" << std::endl;
+		res = false;
+	}
+
+	for (int i = 0; i < 10 && res; i++) {
+		char lowKey[MAX_KEY_SIZE];
+		char highKey[MAX_KEY_SIZE];
+		toString(i * 97, lowKey, 5);
+		toString(i * 97 + 150, highKey, 5);
+
+		IndexFileScan *refScan = ref->OpenScan(lowKey, highKey);
+		scan = mem->OpenScan(lowKey, highKey);
+		if (!TestSameEntries(scan, refScan)) {
+			std::cerr << "TestSameEntries(" << lowKey << ", " << highKey << ") failed after deletes" << std::endl;
+			res = false;
+		}
+		delete scan;
+		delete refScan;
+	}
+
+	if (!TestSameLookups(mem, ref, keys)) {
+		std::cerr << "TestSameLookups() failed after deletes" << std::endl;
+		res = false;
+	}
+
+	//	Checkpoint to a B-Tree and restore over other entries.
+	BTreeFile *file = new BTreeFile(status, "TestMemIndexCheckpoint");
+	if (status != OK || mem->Checkpoint(file) != OK || !TestSameEntries(file, ref)) {
+		std::cerr << "Checkpoint() failed" << std::endl;
+		res = false;
+	}
+	delete file;
+
+	MemIndexFile *restored = new MemIndexFile();
+	rid.pageNo = 1;
+	rid.slotNo = 1;
+	restored->Insert("stale", rid);
+
+	file = new BTreeFile(status, "TestMemIndexCheckpoint", LEAF_NODE, true);
+	if (status != OK || restored->Restore(file) != OK) {
+		std::cerr << "Restore() failed" << std::endl;
+		res = false;
+	}
+
+	scan = restored->OpenScan();
+	if (!TestSameEntries(scan, ref)) {
+		std::cerr << "TestSameEntries() failed after Restore()" << std::endl;
+		res = false;
+	}
+	delete scan;
+
+	//	A checkpoint cannot be written to a read-only file.
+	if (mem->Checkpoint(file) != FAIL) {
+		std::cerr << "Checkpoint() to a read-only file succeeded" << std::endl;
+		res = false;
+	}
+	delete file;
+
+	//	Empty the restored copy; it can be used again.
+	for (int i = 0; i < 3000; i += 3) {
+		toString((i * 7919) % 1000, key, 5);
+		rid.pageNo = i;
+		rid.slotNo = i % 7;
+
+		if (restored->Delete(key, rid) != OK) {
+			std::cerr << "Deleting key " << key << " failed" << std::endl;
+			res = false;
+			break;
+		}
+	}
+
+	scan = restored->OpenScan();
+	if (!TestScanCount(scan, 0)) {
+		std::cerr << "TestScanCount(0) failed" << std::endl;
+		res = false;
+	}
+	delete scan;
+
+	RecordID rids[2];
+	int numRids;
+	restored->Insert(keys[0].c_str(), rid);
+	if (restored->Lookup(keys[0].c_str(), rids, 2, numRids) != OK || numRids != 1) {
+		std::cerr << "Lookup() failed after emptying the index" << std::endl;
+		res = false;
+	}
+
+	file = new BTreeFile(status, "TestMemIndexCheckpoint");
+	if (status != OK || file->DestroyFile() != OK || ref->DestroyFile() != OK) {
+		std::cerr << "Error destroying BTreeFile" << std::endl;
+		res = false;
+	}
+
+	delete file;
+	delete ref;
+	delete restored;
+	delete mem;
+
+	if (res) {
+		std::cout << "Test 15 Passed!" << std::endl;
+	}
+	return res;
+}
+
+//	Test leaf extents and ReclusterLeaves
+bool BTreeDriver::Test16() {
+	Status status = OK;
+	BTreeFile *btf = NULL;
+	bool res = true;
+
+	btf = new BTreeFile(status, "TestLeafExtents");
+
+	if (status != OK) {
+		std::cerr << "ERROR: Couldn't create a BTreeFile" << std::endl;
+		minibase_errors.show_errors();
+
+		std::cerr << "Hit [enter] to continue..." << std::endl;
+		std::cin.get();
+		exit(1);
+	}
+
+	//	Reclustering an empty tree does nothing.
+	if (btf->ReclusterLeaves() != OK) {
+		std::cerr << "ReclusterLeaves() failed on an empty tree" << std::endl;
+		res = false;
+	}
+
+	//	The first leaf comes from an extent of one page, and each extent
+	//	after it is twice the size of the last, up to LEAF_EXTENT_PAGES.
+	if (!InsertKey(btf, 0, 5)) {
+		res = false;
+	}
+	if (btf->header->GetNextExtentSize() != 2 || btf->header->GetExtentNumPages() != 0) {
+		std::cerr << "The first leaf extent is not a single page" << std::endl;
+		res = false;
+	}
+
+	std::vector<int> expectedKeys;
+	expectedKeys.push_back(0);
+	for (int i = 1; i < 3000; i++) {
+		int key = (i * 7919) % 3000;
+		if (!InsertKey(btf, key, 5)) {
+			res = false;
+			break;
+		}
+		expectedKeys.push_back(key);
+	}
+	std::sort(expectedKeys.begin(), expectedKeys.end());
+
+	if (btf->header->GetNextExtentSize() != LEAF_EXTENT_PAGES) {
+		std::cerr << "Leaf extents did not grow to " << LEAF_EXTENT_PAGES << " pages" << std::endl;
+		res = false;
+	}
+
+	//	Random inserts leave the leaf chain out of order on disk;
+	//	reclustering puts it back in order.
+	int numLeaves;
+	int numJumps = CountLeafJumps(btf, numLeaves);
+	if (numJumps <= 0) {
+		std::cerr << "Expected random inserts to leave the leaves out of order" << std::endl;
+		res = false;
+	}
+
+	for (int round = 0; round < 3 && res; round++) {
+		if (round == 2) {
+			//	Leave holes and new leaves, then recluster again.
+			if (!DeleteStride(btf, 0, 2999, 2, 5)) {
+				std::cerr << "DeleteStride(0, 2999, 2) failed" << std::endl;
+				res = false;
+			}
+			if (!InsertRange(btf, 5000, 5999, 0, 5, true)) {
+				std::cerr << "InsertRange(5000, 5999) failed" << std::endl;
+				res = false;
+			}
+
+			std::vector<int> keptKeys;
+			for (unsigned int i = 1; i < expectedKeys.size(); i += 2) {
+				keptKeys.push_back(expectedKeys[i]);
+			}
+			for (int i = 5000; i <= 5999; i++) {
+				keptKeys.push_back(i);
+			}
+			expectedKeys = keptKeys;
+		}
+
+		//	The second round finds the leaves in order and leaves them.
+		PageID leftmostID = GetLeftmostLeaf(btf);
+		if (btf->ReclusterLeaves() != OK) {
+			std::cerr << "Round " << round << ": ReclusterLeaves() failed" << std::endl;
+			res = false;
+		}
+		if (round == 1 && GetLeftmostLeaf(btf) != leftmostID) {
+			std::cerr << "ReclusterLeaves() moved leaves that were in order" << std::endl;
+			res = false;
+		}
+
+		numJumps = CountLeafJumps(btf, numLeaves);
+		if (numJumps != 0) {
+			std::cerr << "Round " << round << ": " << numJumps << " of " << numLeaves
+					  << " leaves out of order after ReclusterLeaves()" << std::endl;
+			res = false;
+		}
+
+		if (!TestScanKeys(btf, NULL, NULL, expectedKeys, 5)) {
+			std::cerr << "Round " << round << ": TestScanKeys(NULL, NULL) failed" << std::endl;
+			res = false;
+		}
+	}
+
+	if (btf->DestroyFile() != OK) {
+		std::cerr << "Error destroying BTreeFile" << std::endl;
+		res = false;
+	}
+
+	delete btf;
+
+	if (res) {
+		std::cout << "Test 16 Passed!" << std::endl;
+	}
+	return res;
+}
+
+//	Test DefragmentLeaves against a tree that is not defragmented
+bool BTreeDriver::Test17() {
+	Status status = OK;
+	BTreeFile *btf = NULL;
+	BTreeFile *ref = NULL;
+	bool res = true;
+
+	btf = new BTreeFile(status, "TestDefragment");
+
+	if (status == OK) {
+		ref = new BTreeFile(status, "TestDefragmentRef");
+	}
+
+	if (status != OK) {
+		std::cerr << "ERROR: Couldn't create a BTreeFile" << std::endl;
+		minibase_errors.show_errors();
+
+		std::cerr << "Hit [enter] to continue..." << std::endl;
+		std::cin.get();
+		exit(1);
+	}
+
+	//	A pass over an empty tree is done at once.
+	bool passDone;
+	if (btf->DefragmentLeaves(10, passDone) != OK || !passDone) {
+		std::cerr << "DefragmentLeaves() failed on an empty tree" << std::endl;
+		res = false;
+	}
+
+	//	Insert 3000 keys at random, then delete 70% of them, leaving
+	//	many leaves mostly empty.
+	for (int i = 0; i < 3000 && res; i++) {
+		int key = (i * 7919) % 6000;
+		res = InsertKey(btf, key, 5) && InsertKey(ref, key, 5);
+	}
+	for (int i = 0; i < 3000 && res; i++) {
+		if (i % 10 < 7) {
+			int key = (i * 7919) % 6000;
+			res = DeleteKey(btf, key, 5, false) && DeleteKey(ref, key, 5, false);
+		}
+	}
+
+	int numRefLeaves, numLeaves;
+	CountLeafJumps(ref, numRefLeaves);
+
+	//	Two passes a few leaves at a time, with inserts and deletes
+	//	between the steps, then two more on their own.
+	int numPasses = 0;
+	int nextKey = 6000;
+	int nextDelete = 0;
+	while (numPasses < 4 && res) {
+		if (btf->DefragmentLeaves(8, passDone) != OK) {
+			std::cerr << "DefragmentLeaves() failed in pass " << numPasses << std::endl;
+			res = false;
+			break;
+		}
+
+		if (numPasses < 2) {
+			for (int i = 0; i < 5 && res; i++) {
+				res = InsertKey(btf, nextKey, 5) && InsertKey(ref, nextKey, 5);
+				nextKey += 7;
+			}
+			for (int i = 0; i < 2 && res; i++) {
+				while (nextDelete % 10 < 7) {
+					nextDelete++;
+				}
+				int key = (nextDelete * 7919) % 6000;
+				res = DeleteKey(btf, key, 5, false) && DeleteKey(ref, key, 5, false);
+				nextDelete++;
+			}
+		}
+
+		if (passDone) {
+			numPasses++;
+			if (!TestSameEntries(btf, ref)) {
+				std::cerr << "TestSameEntries() failed after pass " << numPasses << std::endl;
+				res = false;
+			}
+		}
+	}
+
+	int numJumps = CountLeafJumps(btf, numLeaves);
+	if (numLeaves >= numRefLeaves / 2) {
+		std::cerr << "DefragmentLeaves() left " << numLeaves << " leaves of " << numRefLeaves << std::endl;
+		res = false;
+	}
+	if (numJumps < 0 || numJumps > numLeaves / LEAF_EXTENT_PAGES + 1) {
+		std::cerr << "DefragmentLeaves() left " << numJumps << " of " << numLeaves << " leaves out of order" << std::endl;
+		res = false;
+	}
+
+	//	The defragmented tree still takes deletes down to nothing.
+	IndexFileScan *scan = ref->OpenScan(NULL, NULL);
+	RecordID rid;
+	char key[MAX_KEY_SIZE];
+	while (res && scan->GetNext(rid, key) != DONE) {
+		if (btf->Delete(key, rid) != OK) {
+			std::cerr << "Deleting key " << key << " failed" << std::endl;
+			res = false;
+		}
+	}
+	delete scan;
+
+	if (!TestNumEntries(btf, 0)) {
+		std::cerr << "TestNumEntries(0) failed" << std::endl;
+		res = false;
+	}
+
+	if (btf->DestroyFile() != OK || ref->DestroyFile() != OK) {
+		std::cerr << "Error destroying BTreeFile" << std::endl;
+		res = false;
+	}
+
+	delete btf;
+	delete ref;
+
+	if (res) {
+		std::cout << "Test 17 Passed!" << std::endl;
+	}
+	return res;
+}
+
+//	Test the map of free leaf pages
+bool BTreeDriver::Test18() {
+	Status status = OK;
+	BTreeFile *btf = NULL;
+	bool res = true;
+
+	//	Runs next to each other merge; TakeRun takes the shortest run
+	//	that is long enough, and TakeSmallest the shortest of all.
+	BTFreeExtentMap map;
+	PageID pageID;
+	int count;
+	map.Add(10, 3);
+	map.Add(13, 2);
+	map.Add(100, 1);
+	map.Add(200, 4);
+	map.Add(300, 2);
+
+	if (map.GetNumPages() != 12 ||
+		!map.TakeRun(5, pageID) || pageID != 10 ||
+		!map.TakeRun(2, pageID) || pageID != 300 ||
+		!map.TakeRun(3, pageID) || pageID != 200 ||
+		map.TakeRun(2, pageID) ||
+		!map.TakeSmallest(pageID, count) || pageID != 100 || count != 1 ||
+		!map.TakeNear(150, pageID) || pageID != 203 ||
+		map.TakeNear(150, pageID) || map.TakeSmallest(pageID, count) ||
+		map.GetNumPages() != 0) {
+		std::cerr << "BTFreeExtentMap gave the wrong pages" << std::endl;
+		res = false;
+	}
+
+	//	Random operations against a set of the free pages.
+	std::set<PageID> freePages;
+	srand(4321);
+	for (int i = 0; i < 20000 && res; i++) {
+		int op = rand() % 4;
+
+		if (op < 2) {
+			PageID firstPage = rand() % 2000;
+			int numPages = 1 + rand() % 5;
+			bool overlaps = false;
+			for (int j = 0; j < numPages; j++) {
+				overlaps = overlaps || freePages.count(firstPage + j) > 0;
+			}
+			if (!overlaps) {
+				map.Add(firstPage, numPages);
+				for (int j = 0; j < numPages; j++) {
+					freePages.insert(firstPage + j);
+				}
+			}
+		} else if (op == 2) {
+			PageID near = rand() % 2000;
+			if (map.TakeNear(near, pageID) != !freePages.empty()) {
+				res = false;
+			} else if (!freePages.empty()) {
+				std::set<PageID>::iterator after = freePages.lower_bound(near);
+				int best = (after != freePages.end()) ? *after - near : 1 << 30;
+				if (after != freePages.begin()) {
+					--after;
+					best = std::min(best, near - *after);
+				}
+				res = freePages.erase(pageID) == 1 && abs(pageID - near) == best;
+			}
+		} else {
+			int numPages = 1 + rand() % 8;
+			if (map.TakeRun(numPages, pageID)) {
+				for (int j = 0; j < numPages && res; j++) {
+					res = freePages.erase(pageID + j) == 1;
+				}
+			}
+		}
+
+		if (res && map.GetNumPages() != (int)freePages.size()) {
+			res = false;
+		}
+		if (!res) {
+			std::cerr << "BTFreeExtentMap went wrong at operation " << i << std::endl;
+		}
+	}
+
+	btf = new BTreeFile(status, "TestFreeLeaves");
+
+	if (status != OK) {
+		std::cerr << "ERROR: Couldn't create a BTreeFile" << std::endl;
+		minibase_errors.show_errors();
+
+		std::cerr << "Hit [enter] to continue..." << std::endl;
+		std::cin.get();
+		exit(1);
+	}
+
+	//	Leaves emptied by deletes and merged away by DefragmentLeaves go
+	//	into the map, up to FREE_LEAF_MAX_PAGES of them.
+	if (!InsertRange(btf, 0, 4999, 0, 5)) {
+		std::cerr << "InsertRange(0, 4999) failed" << std::endl;
+		res = false;
+	}
+	for (int i = 0; i < 4000 && res; i++) {
+		res = DeleteKey(btf, i, 5, false);
+	}
+
+	bool passDone = false;
+	while (!passDone && res) {
+		if (btf->DefragmentLeaves(20, passDone) != OK) {
+			std::cerr << "DefragmentLeaves() failed" << std::endl;
+			res = false;
+		}
+	}
+
+	int numFreePages = btf->freeLeaves.GetNumPages();
+	if (numFreePages == 0 || numFreePages > FREE_LEAF_MAX_PAGES) {
+		std::cerr << "DefragmentLeaves() left " << numFreePages << " free leaf pages" << std::endl;
+		res = false;
+	}
+
+	//	New leaves come from the map first.
+	if (!InsertRange(btf, 6000, 6999, 0, 5)) {
+		std::cerr << "InsertRange(6000, 6999) failed" << std::endl;
+		res = false;
+	}
+	if (btf->freeLeaves.GetNumPages() >= numFreePages) {
+		std::cerr << "Inserts took no leaves from the free leaf pages" << std::endl;
+		res = false;
+	}
+
+	if (btf->ReclusterLeaves() != OK || btf->freeLeaves.GetNumPages() > FREE_LEAF_MAX_PAGES) {
+		std::cerr << "ReclusterLeaves() kept " << btf->freeLeaves.GetNumPages() << " free leaf pages" << std::endl;
+		res = false;
+	}
+
+	//	The map is not kept on disk: closing the file gives the pages
+	//	back, and the tree opens again without them.
+	delete btf;
+	btf = new BTreeFile(status, "TestFreeLeaves");
+	if (status != OK || btf->freeLeaves.GetNumPages() != 0) {
+		std::cerr << "Reopening the BTreeFile failed" << std::endl;
+		res = false;
+	}
+
+	std::vector<int> expectedKeys;
+	for (int i = 4000; i <= 4999; i++) {
+		expectedKeys.push_back(i);
+	}
+	for (int i = 6000; i <= 6999; i++) {
+		expectedKeys.push_back(i);
+	}
+
+	if (!TestScanKeys(btf, NULL, NULL, expectedKeys, 5)) {
+		std::cerr << "TestScanKeys(NULL, NULL) failed" << std::endl;
+		res = false;
+	}
+
+	if (btf->DestroyFile() != OK) {
+		std::cerr << "Error destroying BTreeFile" << std::endl;
+		res = false;
+	}
+
+	delete btf;
+
+	if (res) {
+		std::cout << "Test 18 Passed!" << std::endl;
+	}
+	return res;
+}
+
+//	Test opening a B-Tree read-only
+bool BTreeDriver::Test19() {
+	Status status = OK;
+	BTreeFile *btf = NULL;
+	bool res = true;
+
+	//	An index that does not exist is not created read-only.
+	btf = new BTreeFile(status, "TestReadOnly", LEAF_NODE, true);
+	if (status == OK) {
+		std::cerr << "Opened a missing BTreeFile read-only" << std::endl;
+		res = false;
+	}
+	delete btf;
+
+	btf = new BTreeFile(status, "TestReadOnly");
+
+	if (status != OK) {
+		std::cerr << "ERROR: Couldn't create a BTreeFile" << std::endl;
+		minibase_errors.show_errors();
+
+		std::cerr << "Hit [enter] to continue..." << std::endl;
+		std::cin.get();
+		exit(1);
+	}
+
+	if (!InsertRange(btf, 1, 2000, 0, 5, true)) {
+		std::cerr << "InsertRange(1, 2000) failed" << std::endl;
+		res = false;
+	}
+	if (btf->CreateBloomFilter(2000) != OK) {
+		std::cerr << "CreateBloomFilter(2000) failed" << std::endl;
+		res = false;
+	}
+	delete btf;
+
+	btf = new BTreeFile(status, "TestReadOnly", LEAF_NODE, true);
+	if (status != OK) {
+		std::cerr << "Opening the BTreeFile read-only failed" << std::endl;
+		res = false;
+	}
+
+	//	Lookups and scans work as before.
+	std::vector<int> expectedKeys;
+	for (int i = 1; i <= 2000; i++) {
+		expectedKeys.push_back(i);
+	}
+
+	if (!TestScanKeys(btf, NULL, NULL, expectedKeys, 5)) {
+		std::cerr << "TestScanKeys(NULL, NULL) failed" << std::endl;
+		res = false;
+	}
+
+	char key[MAX_KEY_SIZE];
+	RecordID rids[2];
+	int numRids;
+	for (int i = 0; i <= 2001; i++) {
+		toString(i, key, 5);
+		if (btf->Lookup(key, rids, 2, numRids) != OK || numRids != (i >= 1 && i <= 2000 ? 1 : 0)) {
+			std::cerr << "Lookup(" << key << ") failed" << std::endl;
+			res = false;
+			break;
+		}
+	}
+
+	//	Anything that would change the file fails and leaves it as it was.
+	bool passDone;
+	RecordID rid;
+	rid.pageNo = 1;
+	rid.slotNo = 2;
+	toString(1, key, 5);
+	if (btf->Insert("zzzzz", rid) != FAIL ||
+		btf->Delete(key, rid) != FAIL ||
+		btf->DefragmentLeaves(10, passDone) != FAIL ||
+		btf->ReclusterLeaves() != FAIL ||
+		btf->CreateBloomFilter(100) != FAIL ||
+		btf->RebuildBloomFilter() != FAIL ||
+		btf->DestroyBloomFilter() != FAIL ||
+		btf->DestroyFile() != FAIL) {
+		std::cerr << "A read-only BTreeFile was changed" << std::endl;
+		res = false;
+	}
+
+	if (!TestScanKeys(btf, NULL, NULL, expectedKeys, 5)) {
+		std::cerr << "TestScanKeys(NULL, NULL) failed after changes were refused" << std::endl;
+		res = false;
+	}
+	delete btf;
+
+	//	Opened for writing again, it can be changed and destroyed.
+	btf = new BTreeFile(status, "TestReadOnly");
+	if (status != OK || !DeleteKey(btf, 1, 5, false) || !TestNumEntries(btf, 1999)) {
+		std::cerr << "Reopening the BTreeFile for writing failed" << std::endl;
+		res = false;
+	}
+
+	if (btf->DestroyFile() != OK) {
+		std::cerr << "Error destroying BTreeFile" << std::endl;
+		res = false;
+	}
+
+	delete btf;
+
+	if (res) {
+		std::cout << "Test 19 Passed!" << std::endl;
+	}
+	return res;
+}
+
+//	Test that a leaf split promotes the shortest separator that tells
+//	the two leaves apart, not the whole first key of the new leaf
+bool BTreeDriver::Test20() {
+	Status status = OK;
+	BTreeFile *btf = NULL;
+	bool res = true;
+
+	btf = new BTreeFile(status, "TestSeparators");
+
+	if (status != OK) {
+		std::cerr << "ERROR: Couldn't create a BTreeFile" << std::endl;
+		minibase_errors.show_errors();
+
+		std::cerr << "Hit [enter] to continue..." << std::endl;
+		std::cin.get();
+		exit(1);
+	}
+
+	//	Long keys that differ only in their first four bytes, so that a
+	//	separator needs at most four bytes however long the keys are.
+	const int numKeys = 300;
+	const int keyLen = 60;
+	char key[MAX_KEY_SIZE];
+	RecordID rid;
+
+	for (int i = 1; i <= numKeys; i++) {
+		toString(i, key, 4);
+		memset(key + 4, 'x', keyLen - 4);
+		key[keyLen] = '\0';
+		rid.pageNo = i;
+		rid.slotNo = i + 1;
+		if (btf->Insert(key, rid) != OK) {
+			std::cerr << "Inserting key " << i << " failed" << std::endl;
+			res = false;
+			break;
+		}
+	}
+
+	PageID rootID = btf->header->GetRootPageID();
+	SortedPage *root;
+	if (MINIBASE_BM->PinPage(rootID, (Page *&)root) == FAIL) {
+		std::cerr << "Unable to pin page" << std::endl;
+		exit(1);
+	}
+
+	if (root->GetType() != INDEX_NODE || root->GetNumOfRecords() == 0) {
+		std::cerr << "The leaves did not split" << std::endl;
+		res = false;
+	}
+	else {
+		for (int i = 0; i < root->GetNumOfRecords(); i++) {
+			KeyView separator = root->GetKeyView(i);
+			if (separator.length < 1 || separator.length > 4) {
+				std::cerr << "Separator " << i << " is " << separator.length << " bytes long" << std::endl;
+				res = false;
+				break;
+			}
+		}
+	}
+
+	if (MINIBASE_BM->UnpinPage(rootID, CLEAN) == FAIL) {
+		std::cerr << "Unable to unpin page" << std::endl;
+		exit(1);
+	}
+
+	//	The short separators still lead every lookup to its leaf.
+	RecordID rids[2];
+	int numRids;
+	for (int i = 0; i <= numKeys + 1; i++) {
+		toString(i, key, 4);
+		memset(key + 4, 'x', keyLen - 4);
+		key[keyLen] = '\0';
+		if (btf->Lookup(key, rids, 2, numRids) != OK ||
+			numRids != (i >= 1 && i <= numKeys ? 1 : 0) ||
+			(numRids == 1 && rids[0].pageNo != i)) {
+			std::cerr << "Lookup(" << i << ") failed" << std::endl;
+			res = false;
+			break;
+		}
+	}
+
+	//	A key that is only a prefix of the keys in the tree sorts before
+	//	them, even though it may equal a separator.
+	toString(numKeys / 2, key, 4);
+	if (btf->Lookup(key, rids, 2, numRids) != OK || numRids != 0) {
+		std::cerr << "Lookup of a separator found an entry" << std::endl;
+		res = false;
+	}
+
+	if (btf->DestroyFile() != OK) {
+		std::cerr << "Error destroying BTreeFile" << std::endl;
+		res = false;
+	}
+
+	delete btf;
+
+	if (res) {
+		std::cout << "Test 20 Passed!" << std::endl;
+	}
+	return res;
+}
+
+//	Test comparing keys of different lengths in place on the pages,
+//	including keys that are prefixes of others, and scans that start
+//	between two leaves
+bool BTreeDriver::Test21() {
+	Status status = OK;
+	BTreeFile *btf = NULL;
+	bool res = true;
+
+	btf = new BTreeFile(status, "TestInPlaceKeys");
+
+	if (status != OK) {
+		std::cerr << "ERROR: Couldn't create a BTreeFile" << std::endl;
+		minibase_errors.show_errors();
+
+		std::cerr << "Hit [enter] to continue..." << std::endl;
+		std::cin.get();
+		exit(1);
+	}
+
+	//	Key i (even only) is i in five digits followed by 1 to 61 'z's,
+	//	so the five digits alone are a prefix that sorts just below it.
+	const int maxKey = 1200;
+	char key[MAX_KEY_SIZE];
+	RecordID rid;
+
+	for (int i = 2; i <= maxKey && res; i += 2) {
+		toString(i, key, 5);
+		int tailLen = 1 + (i % 7) * 10;
+		memset(key + 5, 'z', tailLen);
+		key[5 + tailLen] = '\0';
+		rid.pageNo = i;
+		rid.slotNo = i + 1;
+		if (btf->Insert(key, rid) != OK) {
+			std::cerr << "Inserting key " << key << " failed" << std::endl;
+			res = false;
+		}
+	}
+
+	int numLeaves;
+	CountLeafJumps(btf, numLeaves);
+	if (numLeaves < 10) {
+		std::cerr << "Only " << numLeaves << " leaves were made" << std::endl;
+		res = false;
+	}
+
+	//	A scan from any five digit key, odd or even, returns exactly the
+	//	keys at or above it, wherever among the leaves it falls.
+	for (int j = 1; j <= maxKey + 1 && res; j++) {
+		toString(j, key, 5);
+		IndexFileScan *scan = btf->OpenScan(key, NULL);
+		if (!TestScanCount(scan, maxKey / 2 - (j - 1) / 2)) {
+			std::cerr << "Scan from " << key << " failed" << std::endl;
+			res = false;
+		}
+		delete scan;
+	}
+
+	//	The five digits alone are never found, the whole keys always are.
+	RecordID rids[2];
+	int numRids;
+	for (int i = 2; i <= maxKey && res; i += 2) {
+		toString(i, key, 5);
+		if (btf->Lookup(key, rids, 2, numRids) != OK || numRids != 0) {
+			std::cerr << "Lookup(" << key << ") found a longer key" << std::endl;
+			res = false;
+		}
+		int tailLen = 1 + (i % 7) * 10;
+		memset(key + 5, 'z', tailLen);
+		key[5 + tailLen] = '\0';
+		if (btf->Lookup(key, rids, 2, numRids) != OK || numRids != 1 || rids[0].pageNo != i) {
+			std::cerr << "Lookup(" << key << ") failed" << std::endl;
+			res = false;
+		}
+	}
+
+	if (btf->DestroyFile() != OK) {
+		std::cerr << "Error destroying BTreeFile" << std::endl;
+		res = false;
+	}
+
+	delete btf;
+
+	if (res) {
+		std::cout << "Test 21 Passed!" << std::endl;
+	}
+	return res;
+}
+
+//	Test binary keys with embedded and trailing null bytes, which only
+//	their lengths tell apart
+bool BTreeDriver::Test22() {
+	Status status = OK;
+	BTreeFile *btf = NULL;
+	bool res = true;
+
+	btf = new BTreeFile(status, "TestBinaryKeys");
+
+	if (status != OK) {
+		std::cerr << "ERROR: Couldn't create a BTreeFile" << std::endl;
+		minibase_errors.show_errors();
+
+		std::cerr << "Hit [enter] to continue..." << std::endl;
+		std::cin.get();
+		exit(1);
+	}
+
+	//	Key 2i is the three bytes 0, i / 256, i % 256, and key 2i + 1 the
+	//	same three bytes followed by another 0.  Every key starts with a
+	//	null byte and many have more, so none of them is a C string.
+	const int numPairs = 600;
+	const int numKeys = 2 * numPairs;
+	char key[MAX_KEY_SIZE];
+	KeyView view;
+	view.key = key;
+	RecordID rid;
+
+	for (int i = 0; i < numKeys && res; i++) {
+		key[0] = 0;
+		key[1] = (char)(i / 2 / 256);
+		key[2] = (char)(i / 2 % 256);
+		key[3] = 0;
+		view.length = 3 + i % 2;
+		rid.pageNo = i;
+		rid.slotNo = i + 1;
+		if (btf->Insert(view, rid) != OK) {
+			std::cerr << "Inserting key " << i << " failed" << std::endl;
+			res = false;
+		}
+	}
+
+	//	A full scan returns the keys in order, each with its own length.
+	BTreeFileScan *scan = (BTreeFileScan *)btf->OpenScan(NULL, NULL);
+	char scanKey[MAX_KEY_SIZE];
+	int scanKeyLen;
+	int numScanned = 0;
+	while (res && scan->GetNext(rid, scanKey, scanKeyLen) != DONE) {
+		int i = numScanned++;
+		if (rid.pageNo != i || scanKeyLen != 3 + i % 2 ||
+			scanKey[0] != 0 || scanKey[1] != (char)(i / 2 / 256) || scanKey[2] != (char)(i / 2 % 256) ||
+			(scanKeyLen == 4 && scanKey[3] != 0)) {
+			std::cerr << "Scanned entry " << i << " is wrong" << std::endl;
+			res = false;
+		}
+	}
+	delete scan;
+	if (res && numScanned != numKeys) {
+		std::cerr << "Scanned " << numScanned << " entries, expected " << numKeys << std::endl;
+		res = false;
+	}
+
+	//	A range scan between two binary keys.
+	char lowKey[3] = { 0, 0, 10 };
+	char highKey[4] = { 0, 0, 19, 0 };
+	KeyView lowView = { lowKey, 3 };
+	KeyView highView = { highKey, 4 };
+	IndexFileScan *rangeScan = btf->OpenScan(lowView, highView);
+	numScanned = 0;
+	while (rangeScan->GetNext(rid, scanKey) != DONE) {
+		if (rid.pageNo != 20 + numScanned) {
+			std::cerr << "Range scan returned entry " << rid.pageNo << std::endl;
+			res = false;
+			break;
+		}
+		numScanned++;
+	}
+	delete rangeScan;
+	if (numScanned != 20) {
+		std::cerr << "Range scan returned " << numScanned << " entries, expected 20" << std::endl;
+		res = false;
+	}
+
+	//	Deleting the four-byte keys leaves the three-byte keys they start
+	//	with, and a lookup never confuses the two.
+	for (int i = 1; i < numKeys && res; i += 2) {
+		key[1] = (char)(i / 2 / 256);
+		key[2] = (char)(i / 2 % 256);
+		key[3] = 0;
+		view.length = 4;
+		rid.pageNo = i;
+		rid.slotNo = i + 1;
+		if (btf->Delete(view, rid) != OK) {
+			std::cerr << "Deleting key " << i << " failed" << std::endl;
+			res = false;
+		}
+	}
+
+	RecordID rids[2];
+	int numRids;
+	for (int i = 0; i < numKeys && res; i++) {
+		key[1] = (char)(i / 2 / 256);
+		key[2] = (char)(i / 2 % 256);
+		view.length = 3 + i % 2;
+		if (btf->Lookup(view, rids, 2, numRids) != OK ||
+			numRids != (i % 2 == 0 ? 1 : 0) ||
+			(numRids == 1 && rids[0].pageNo != i)) {
+			std::cerr << "Lookup of key " << i << " failed" << std::endl;
+			res = false;
+		}
+	}
+
+	if (!TestNumEntries(btf, numPairs)) {
+		std::cerr << "TestNumEntries(" << numPairs << ") failed" << std::endl;
+		res = false;
+	}
+
+	if (btf->DestroyFile() != OK) {
+		std::cerr << "Error destroying BTreeFile" << std::endl;
+		res = false;
+	}
+
+	delete btf;
+
+	if (res) {
+		std::cout << "Test 22 Passed!" << std::endl;
+	}
+	return res;
+}
+
+//	Test deleting exact (key, rid) entries from a run of one key that
+//	spans many leaves, and that only the separators inside the run
+//	store a record id
+bool BTreeDriver::Test23() {
+	Status status = OK;
+	BTreeFile *btf = NULL;
+	bool res = true;
+
+	btf = new BTreeFile(status, "TestDuplicateRun");
+
+	if (status != OK) {
+		std::cerr << "ERROR: Couldn't create a BTreeFile" << std::endl;
+		minibase_errors.show_errors();
+
+		std::cerr << "Hit [enter] to continue..." << std::endl;
+		std::cin.get();
+		exit(1);
+	}
+
+	//	Distinct keys on both sides of a run of 800 entries of "dup".
+	const int runLen = 800;
+	char key[MAX_KEY_SIZE];
+	RecordID rid;
+
+	for (int i = 0; i < 400 && res; i++) {
+		sprintf_s(key, MAX_KEY_SIZE, "%c%03d", (i % 2 == 0) ? 'a' : 'z', i);
+		rid.pageNo = i;
+		rid.slotNo = i + 1;
+		if (btf->Insert(key, rid) != OK) {
+			std::cerr << "Inserting key " << key << " failed" << std::endl;
+			res = false;
+		}
+	}
+	for (int i = 0; i < runLen && res; i++) {
+		rid.pageNo = 1000 + (i * 37) % runLen;
+		rid.slotNo = i % 7;
+		if (btf->Insert("dup", rid) != OK) {
+			std::cerr << "Inserting dup " << i << " failed" << std::endl;
+			res = false;
+		}
+	}
+
+	//	Walk the index pages.  A separator inside the run is "dup" with
+	//	the record id of the first entry on its right; any other keeps
+	//	no record id, and its entry is four bytes longer than its key.
+	std::vector<PageID> indexPages;
+	int numInRun = 0;
+	indexPages.push_back(btf->header->GetRootPageID());
+	for (int p = 0; p < (int)indexPages.size() && res; p++) {
+		BTIndexPage *index;
+		if (MINIBASE_BM->PinPage(indexPages[p], (Page *&)index) == FAIL) {
+			std::cerr << "Unable to pin page" << std::endl;
+			exit(1);
+		}
+
+		if (index->GetType() == INDEX_NODE) {
+			for (int i = -1; i < index->GetNumOfRecords(); i++) {
+				indexPages.push_back(index->GetChild(i));
+			}
+			for (int i = 0; i < index->GetNumOfRecords(); i++) {
+				RecordID slotRid;
+				char *entry;
+				int entryLen;
+				slotRid.pageNo = indexPages[p];
+				slotRid.slotNo = i;
+				index->ReturnRecord(slotRid, entry, entryLen);
+
+				KeyView separator = index->GetKeyView(i);
+				RecordID keyRid = index->GetKeyRid(i);
+				bool inRun = (KeyCmp(separator, MakeKeyView("dup")) == 0);
+				if (inRun) {
+					numInRun++;
+				}
+				if (inRun != (keyRid != LOWEST_RID) ||
+					entryLen != separator.length + (int)sizeof(PageID) + (inRun ? (int)sizeof(RecordID) : 0)) {
+					std::cerr << "Index entry " << i << " on page " << indexPages[p] << " is wrong" << std::endl;
+					res = false;
+				}
+			}
+		}
+
+		if (MINIBASE_BM->UnpinPage(indexPages[p], CLEAN) == FAIL) {
+			std::cerr << "Unable to unpin page" << std::endl;
+			exit(1);
+		}
+	}
+
+	if (numInRun < 3) {
+		std::cerr << "The run of dup only has " << numInRun << " separators" << std::endl;
+		res = false;
+	}
+
+	//	Delete every third entry of the run, in an order that jumps
+	//	between its leaves.  Each delete removes exactly its own entry,
+	//	and a few are tried again to check that they are gone.
+	std::set<int> remaining;
+	for (int i = 0; i < runLen; i++) {
+		remaining.insert(i);
+	}
+	for (int j = 0; j < runLen && res; j++) {
+		int i = (j * 337) % runLen;
+		if (i % 3 != 0) {
+			continue;
+		}
+		rid.pageNo = 1000 + (i * 37) % runLen;
+		rid.slotNo = i % 7;
+		if (btf->Delete("dup", rid) != OK) {
+			std::cerr << "Deleting dup " << i << " failed" << std::endl;
+			res = false;
+		}
+		else if (i % 30 == 0 && btf->Delete("dup", rid) != FAIL) {
+			std::cerr << "Deleting dup " << i << " twice succeeded" << std::endl;
+			res = false;
+		}
+		remaining.erase(i);
+	}
+
+	//	The record ids left are exactly the ones that were not deleted.
+	RecordID *rids = new RecordID[runLen];
+	int numRids;
+	if (btf->Lookup("dup", rids, runLen, numRids) != OK || numRids != (int)remaining.size()) {
+		std::cerr << "Lookup(dup) returned " << numRids << " record ids, expected " << remaining.size() << std::endl;
+		res = false;
+	}
+	else {
+		std::set<std::pair<int, int> > found, expected;
+		for (int i = 0; i < numRids; i++) {
+			found.insert(std::make_pair(rids[i].pageNo, rids[i].slotNo));
+		}
+		for (std::set<int>::iterator it = remaining.begin(); it != remaining.end(); ++it) {
+			expected.insert(std::make_pair(1000 + (*it * 37) % runLen, *it % 7));
+		}
+		if (found != expected) {
+			std::cerr << "Lookup(dup) returned the wrong record ids" << std::endl;
+			res = false;
+		}
+	}
+	delete [] rids;
+
+	if (!TestNumEntries(btf, 400 + (int)remaining.size())) {
+		std::cerr << "TestNumEntries failed" << std::endl;
+		res = false;
+	}
+
+	if (btf->DestroyFile() != OK) {
+		std::cerr << "Error destroying BTreeFile" << std::endl;
+		res = false;
+	}
+
+	delete btf;
+
+	//	An index in an older layout is refused.
+	btf = new BTreeFile(status, "TestOldFormat");
+	if (status != OK) {
+		std::cerr << "ERROR: Couldn't create a BTreeFile" << std::endl;
+		exit(1);
+	}
+	btf->header->SetFormatVersion(1);
+	delete btf;
+
+	btf = new BTreeFile(status, "TestOldFormat");
+	if (status == OK) {
+		std::cerr << "Opened an index in an older layout" << std::endl;
+		res = false;
+	}
+	delete btf;
+
+	PageID headerID;
+	BTreeFile::BTreeHeaderPage *header;
+	if (MINIBASE_DB->GetFileEntry("TestOldFormat", headerID) != OK ||
+		MINIBASE_BM->PinPage(headerID, (Page *&)header) != OK) {
+		std::cerr << "Unable to pin the header page" << std::endl;
+		exit(1);
+	}
+	header->SetFormatVersion(BTREE_FORMAT_VERSION);
+	if (MINIBASE_BM->UnpinPage(headerID, DIRTY) != OK) {
+		std::cerr << "Unable to unpin the header page" << std::endl;
+		exit(1);
+	}
+
+	btf = new BTreeFile(status, "TestOldFormat");
+	if (status != OK || btf->DestroyFile() != OK) {
+		std::cerr << "Error destroying BTreeFile" << std::endl;
+		res = false;
+	}
+	delete btf;
+
+	if (res) {
+		std::cout << "Test 23 Passed!" << std::endl;
+	}
+	return res;
+}
+
+//	Test that the upper index pages of open trees stay resident, that
+//	a descent through them pins only its leaf with the buffer manager,
+//	that all trees together keep no more than their share of the pool
+//	resident, and that closing or destroying a tree lets its pages go
+bool BTreeDriver::Test24() {
+	Status status = OK;
+	bool res = true;
+
+	//	Keys with a long common prefix, so that separators stay long and
+	//	even a few hundred keys need several index pages.
+	const int numTrees = 4;
+	const int numKeys = 600;
+	const int prefixLen = 50;
+	const int maxResident = (int)(MINIBASE_BM->GetNumOfBuffers() / RESIDENT_POOL_SHARE);
+	const int residentBefore = BTResidentTable::GetTotalPages();
+	BTreeFile *btf[numTrees];
+	char name[32];
+	char key[MAX_KEY_SIZE];
+	char digits[MAX_KEY_SIZE];
+	RecordID rid;
+	PageID leafID;
+	long numPins, numMisses;
+
+	memset(key, 'x', prefixLen);
+	for (int t = 0; t < numTrees; t++) {
+		sprintf_s(name, 32, "TestResident%d", t);
+		btf[t] = new BTreeFile(status, name);
+
+		if (status != OK) {
+			std::cerr << "ERROR: Couldn't create a BTreeFile" << std::endl;
+			minibase_errors.show_errors();
+
+			std::cerr << "Hit [enter] to continue..." << std::endl;
+			std::cin.get();
+			exit(1);
+		}
+
+		for (int i = 0; i < numKeys && res; i++) {
+			toString(i, digits, 5);
+			strcpy(key + prefixLen, digits);
+			rid.pageNo = i;
+			rid.slotNo = i + 1;
+			if (btf[t]->Insert(key, rid) != OK) {
+				std::cerr << "Inserting key " << i << " into tree " << t << " failed" << std::endl;
+				res = false;
+			}
+		}
+	}
+
+	//	The first tree has all its index pages resident, so a search
+	//	goes to the buffer manager for its leaf alone.
+	PageID rootID = btf[0]->header->GetRootPageID();
+	if (btf[0]->resident.Find(rootID) == NULL) {
+		std::cerr << "The root of the first tree is not resident" << std::endl;
+		res = false;
+	}
+
+	MINIBASE_BM->ResetStat();
+	for (int i = 0; i < numKeys; i++) {
+		toString(i, digits, 5);
+		strcpy(key + prefixLen, digits);
+		if (btf[0]->Search(key, leafID) != OK) {
+			std::cerr << "Search(" << i << ") failed" << std::endl;
+			res = false;
+			break;
+		}
+	}
+	MINIBASE_BM->GetStat(numPins, numMisses);
+	if (numPins != numKeys) {
+		std::cerr << numKeys << " searches pinned " << numPins << " pages, not one leaf each" << std::endl;
+		res = false;
+	}
+
+	//	The trees together fill their share of the pool and no more, so
+	//	the last one has to pin some of its index pages as it goes.
+	int numResident = 0;
+	for (int t = 0; t < numTrees; t++) {
+		if (btf[t]->resident.GetNumPages() > RESIDENT_MAX_PAGES) {
+			std::cerr << "Tree " << t << " has " << btf[t]->resident.GetNumPages() << " resident pages" << std::endl;
+			res = false;
+		}
+		numResident += btf[t]->resident.GetNumPages();
+	}
+	if (numResident != BTResidentTable::GetTotalPages() - residentBefore ||
+		BTResidentTable::GetTotalPages() != maxResident) {
+		std::cerr << "The trees keep " << numResident << " pages resident, not their share of "
+			<< maxResident << std::endl;
+		res = false;
+	}
+
+	MINIBASE_BM->ResetStat();
+	for (int i = 0; i < numKeys; i++) {
+		toString(i, digits, 5);
+		strcpy(key + prefixLen, digits);
+		btf[numTrees - 1]->Search(key, leafID);
+	}
+	MINIBASE_BM->GetStat(numPins, numMisses);
+	if (numPins <= numKeys) {
+		std::cerr << "The last tree searched without pinning any index page" << std::endl;
+		res = false;
+	}
+
+	//	Closing the first tree hands its pages back; opened again, it
+	//	starts with none, and the last tree can take up the share.
+	int numReleased = btf[0]->resident.GetNumPages();
+	int numLast = btf[numTrees - 1]->resident.GetNumPages();
+	delete btf[0];
+	if (BTResidentTable::GetTotalPages() != maxResident - numReleased) {
+		std::cerr << "Closing a tree did not release its resident pages" << std::endl;
+		res = false;
+	}
+
+	btf[0] = new BTreeFile(status, "TestResident0");
+	if (status != OK || btf[0]->resident.GetNumPages() != 0) {
+		std::cerr << "Reopening the first tree failed" << std::endl;
+		res = false;
+	}
+
+	for (int i = 0; i < numKeys; i++) {
+		toString(i, digits, 5);
+		strcpy(key + prefixLen, digits);
+		btf[numTrees - 1]->Search(key, leafID);
+	}
+	if (btf[numTrees - 1]->resident.GetNumPages() <= numLast) {
+		std::cerr << "The last tree did not take up the released pages" << std::endl;
+		res = false;
+	}
+
+	//	Destroying a tree frees its index pages, which it can only do
+	//	once they are no longer resident.
+	for (int t = 0; t < numTrees; t++) {
+		if (btf[t]->DestroyFile() != OK) {
+			std::cerr << "Error destroying BTreeFile" << std::endl;
+			res = false;
+		}
+		if (btf[t]->resident.GetNumPages() != 0) {
+			std::cerr << "Tree " << t << " kept pages resident after it was destroyed" << std::endl;
+			res = false;
+		}
+		delete btf[t];
+	}
+
+	if (BTResidentTable::GetTotalPages() != residentBefore) {
+		std::cerr << BTResidentTable::GetTotalPages() - residentBefore << " pages are still resident" << std::endl;
+		res = false;
+	}
+
+	if (res) {
+		std::cout << "Test 24 Passed!" << std::endl;
+	}
+	return res;
+}
+
+//	Test that leaves can still be added when the database has no free
+//	run of pages left for an extent, only single pages
+bool BTreeDriver::Test25() {
+	Status status = OK;
+	BTreeFile *btf = NULL;
+	bool res = true;
+
+	//	Take every free page, then give back every third one, so that no
+	//	two free pages are next to each other.
+	std::vector<PageID> taken;
+	PageID pageID;
+	while (MINIBASE_DB->AllocatePage(pageID, 1) == OK)
+		taken.push_back(pageID);
+	minibase_errors.clear_errors();
+	for (size_t i = 0; i < taken.size(); i += 3)
+		MINIBASE_DB->DeallocatePage(taken[i], 1);
+
+	btf = new BTreeFile(status, "TestNearlyFull");
+
+	if (status != OK) {
+		std::cerr << "ERROR: Couldn't create a BTreeFile" << std::endl;
+		minibase_errors.show_errors();
+
+		std::cerr << "Hit [enter] to continue..." << std::endl;
+		std::cin.get();
+		exit(1);
+	}
+
+	//	Enough keys for dozens of leaves, each on a page of its own.
+	const int numKeys = 3000;
+	if (!InsertRange(btf, 1, numKeys, 1, 5, false)) {
+		std::cerr << "Inserting into a nearly full database failed" << std::endl;
+		res = false;
+	}
+	minibase_errors.clear_errors();
+
+	int numLeaves;
+	int numJumps = CountLeafJumps(btf, numLeaves);
+	if (numLeaves < 10 || numJumps < numLeaves - 1) {
+		std::cerr << "Found " << numLeaves << " leaves, " << numJumps << " of them apart" << std::endl;
+		res = false;
+	}
+
+	if (btf->header->GetNextExtentSize() > 2) {
+		std::cerr << "An extent of " << btf->header->GetNextExtentSize() / 2
+			<< " pages was taken from a database with no free runs" << std::endl;
+		res = false;
+	}
+
+	if (!TestNumEntries(btf, numKeys)) {
+		std::cerr << "The entries are not all there" << std::endl;
+		res = false;
+	}
+
+	if (btf->DestroyFile() != OK) {
+		std::cerr << "Error destroying BTreeFile" << std::endl;
+		res = false;
+	}
+
+	delete btf;
+
+	for (size_t i = 0; i < taken.size(); i++) {
+		if (i % 3 != 0)
+			MINIBASE_DB->DeallocatePage(taken[i], 1);
+	}
+
+	if (res) {
+		std::cout << "Test 25 Passed!" << std::endl;
+	}
+	return res;
+}
+
+//	Test that an index destroyed and created again under its name is a
+//	new, empty index, even when another index has since taken the header
+//	page its name used to lead to
+bool BTreeDriver::Test26() {
+	Status status = OK;
+	BTreeFile *btf = NULL;
+	BTreeFile *other = NULL;
+	bool res = true;
+
+	btf = new BTreeFile(status, "TestStaleName");
+
+	if (status != OK) {
+		std::cerr << "ERROR: Couldn't create a BTreeFile" << std::endl;
+		minibase_errors.show_errors();
+
+		std::cerr << "Hit [enter] to continue..." << std::endl;
+		std::cin.get();
+		exit(1);
+	}
+
+	//	Open the index a second time, so that its name has been looked up
+	//	and not only added, then destroy it.
+	if (!InsertRange(btf, 1, 100)) {
+		std::cerr << "Inserting into the first index failed" << std::endl;
+		res = false;
+	}
+	delete btf;
+
+	btf = new BTreeFile(status, "TestStaleName");
+	PageID oldHeaderID = btf->headerID;
+	if (status != OK || !TestNumEntries(btf, 100)) {
+		std::cerr << "Reopening the first index failed" << std::endl;
+		res = false;
+	}
+	if (btf->DestroyFile() != OK) {
+		std::cerr << "Error destroying BTreeFile" << std::endl;
+		res = false;
+	}
+	delete btf;
+
+	//	The next index to be created takes the header page back.
+	other = new BTreeFile(status, "TestStaleOther");
+	if (status != OK || other->headerID != oldHeaderID) {
+		std::cerr << "The second index did not reuse header page " << oldHeaderID << std::endl;
+		res = false;
+	}
+	if (!InsertRange(other, 1001, 1050)) {
+		std::cerr << "Inserting into the second index failed" << std::endl;
+		res = false;
+	}
+
+	//	The old name must not lead to the second index.
+	btf = new BTreeFile(status, "TestStaleName");
+	PageID dirHeaderID;
+	if (status != OK || btf->headerID == other->headerID) {
+		std::cerr << "The old name opened the second index" << std::endl;
+		res = false;
+	}
+	if (MINIBASE_DB->GetFileEntry("TestStaleName", dirHeaderID) != OK ||
+		dirHeaderID != btf->headerID) {
+		std::cerr << "The index is not the one in the file directory" << std::endl;
+		res = false;
+	}
+	if (!TestNumEntries(btf, 0) || !TestNumEntries(other, 50)) {
+		std::cerr << "The indexes do not hold their own entries" << std::endl;
+		res = false;
+	}
+
+	if (btf->DestroyFile() != OK || other->DestroyFile() != OK) {
+		std::cerr << "Error destroying BTreeFile" << std::endl;
+		res = false;
+	}
+
+	delete btf;
+	delete other;
+
+	if (res) {
+		std::cout << "Test 26 Passed!" << std::endl;
+	}
+	return res;
+}
+
+//	Test Helper functions
+
+//-------------------------------------------------------------------
+// BTreeDriver::InsertRange
+//
+// Input   : btf,  The BTree to insert into.
+//           low,  The beginning of the range (inclusive).
+//           high, The end of the range (inclusive).
+//           ridOffset, The offset used to compute the rid.
+//           pad,  The amount of padding to use for the keys.
+//           reverse, Whether to insert in reverse order.
+// Output  : None
+// Return  : True if this operation completed succesfully.
+// Purpose : Inserts a range of keys into the B-Tree.
+//-------------------------------------------------------------------
+bool BTreeDriver::InsertRange(BTreeFile *btf, int low, int high,
+							  int ridOffset, int pad, bool reverse) {
+	int numKeys = high - low + 1;
+	int keyNum;
+
+	char skey[MAX_KEY_SIZE];
+
+	int i;
+	if (reverse) {
+		i = numKeys - 1;
+	} else {
+		i = 0;
+	}
+
+	while (reverse && i >= 0 || !reverse && i < numKeys) {
+		RecordID rid;
+		keyNum = i+low;
+		rid.pageNo=keyNum + ridOffset;
+		rid.slotNo=keyNum + ridOffset + 1;
+		BTreeDriver::toString(keyNum, skey, pad);
+
+		if (btf->Insert(skey, rid) != OK) {
+			std::cerr << "Insertion of range failed at key=" << skey
+					  << " rid=" << rid << std::endl;
+			minibase_errors.show_errors();
+			return false;
+		}
+
+		if (reverse) {
+			i--;
+		} else {
+			i++;
+		}
+	}
+
+	return true;
+}
+
+//	Delete from BTree with a certain stride
+bool BTreeDriver::DeleteStride(BTreeFile *btf, int low, int high,
+							  int stride, int pad) {
+	char lowKey[MAX_KEY_SIZE];
+	char highKey[MAX_KEY_SIZE];
+    BTreeDriver::toString(low, lowKey, pad);
+    BTreeDriver::toString(high, highKey, pad);
+
+	IndexFileScan* scan = btf->OpenScan(lowKey, highKey);
+	RecordID rid;
+	char curKey[MAX_KEY_SIZE];
+	int count = 0;
+
+	std::vector<std::pair<char*, RecordID>*> deleteVec;
+
+	while(scan->GetNext(rid, curKey) != DONE) {
+		char* tempKey = new char[MAX_KEY_SIZE];
+		memcpy(tempKey, curKey, strlen(curKey) + 1);
+
+		if(count == 0) {
+			deleteVec.push_back(new std::pair<char*, RecordID>(tempKey, rid));
+		}
+		count = (count + 1)	% stride;
+	}
+
+	delete scan;
+
+	int numToDelete = deleteVec.size();
+	int numDeleted = 0;
+
+	std::vector<std::pair<char*, RecordID>*>::iterator it;
+	for(it = deleteVec.begin(); it != deleteVec.end(); it++) {
+		std::pair<char*, RecordID>* pair = *it;
+		if(btf->Delete(pair->first, pair->second) == OK) {
+			numDeleted++;
+		}
+	}
+
+	for(it = deleteVec.begin(); it != deleteVec.end(); it++) {
+		delete [] (*it)->first;
+		delete *it;
+	}
+
+	if(numDeleted != numToDelete) {
+		std::cerr << "Error: Attempted to delete " << numToDelete
+         	      << "pairs. Only able to delete " << numDeleted << std::endl;
+		return false;
+	}
+
+	return true;
+
+}
+
+//-------------------------------------------------------------------
+// BTreeDriver::TestNumLeafPages
+//
+// Input   : btf,  The BTree to test
+//           expected,  The number of leaf pages you expect.
+// Output  : None
+// Return  : True if the number of leaf pages == expected.
+// Purpose : Tests the number of leaf pages in the tree.
+//-------------------------------------------------------------------
+bool BTreeDriver::TestNumLeafPages(BTreeFile *btf, int expected)
+{
+	PageID pid = GetLeftmostLeaf(btf);
+
+	if (pid == INVALID_PAGE) {
+		std::cerr << "Unable to access left leaf" << std::endl;
+		return false;
+	}
+
+	int numPages = 0;
+
+	while (pid != INVALID_PAGE) {
+		numPages++;
+
+		SortedPage *page;
+		if (MINIBASE_BM->PinPage(pid, (Page *&)page) == FAIL) {
+			std::cerr << "Unable to pin page" << std::endl;
+			return false;
+		}
+
+		pid = page->GetNextPage();
+
+		if (MINIBASE_BM->UnpinPage(page->PageNo(), CLEAN) == FAIL) {
+			std::cerr << "Unable to unpin page" << std::endl;
+			return false;
+		}
+	}
+
+	if (numPages != expected) {
+		std::cerr << "Unexpected number of leaf pages. Expected " << expected
+				  << ", but got " << numPages << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+//	Get the leftmost leaf page in this index.
+PageID BTreeDriver::GetLeftmostLeaf(BTreeFile *btf) {
+	PageID curPid = btf->header->GetRootPageID();
+
+	while (curPid != INVALID_PAGE) {
+		SortedPage *curPage;
+
+		if (MINIBASE_BM->PinPage(curPid, (Page *&)curPage) == FAIL) {
+			std::cerr << "Unable to pin page" << std::endl;
+			return INVALID_PAGE;
+		}
+	
+		NodeType nodeType = curPage->GetType();
+
+		if (nodeType == LEAF_NODE) {
+			//	If we have reached a leaf page, then we are done.
+			break;
+		} else {
+			//	Traverse down to the leftmost branch
+			PageID tempPid = curPage->GetPrevPage();
+
+			if (MINIBASE_BM->UnpinPage(curPid, CLEAN) == FAIL) {
+				std::cerr << "Unable to unpin page" << std::endl;
+				return INVALID_PAGE;
+			}
+
+			curPid = tempPid;
+		}
+	}
+
+	if (curPid != INVALID_PAGE) {
+		if (MINIBASE_BM->UnpinPage(curPid, CLEAN) == FAIL) {
+			std::cerr << "Unable to unpin page" << std::endl;
+			return INVALID_PAGE;
+		}
+	}
+	return curPid;
+}
+
+//-------------------------------------------------------------------
+// BTreeDriver::CountLeafJumps
+//
+// Input   : btf,  The B-Tree to test.
+// Output  : numLeaves, The number of leaves in the tree.
+// Return  : The number of leaves that are not on the page after the
+//           leaf before them, or -1 on error or if the leaves are not
+//           linked both ways.
+// Purpose : Tests how well the leaves are laid out on disk.
+//-------------------------------------------------------------------
+int BTreeDriver::CountLeafJumps(BTreeFile *btf, int &numLeaves)
+{
+	PageID curPid = GetLeftmostLeaf(btf);
+	PageID prevPid = INVALID_PAGE;
+	int numJumps = 0;
+
+	numLeaves = 0;
+	while (curPid != INVALID_PAGE) {
+		SortedPage *curPage;
+
+		if (MINIBASE_BM->PinPage(curPid, (Page *&)curPage) == FAIL) {
+			std::cerr << "Unable to pin page" << std::endl;
+			return -1;
+		}
+
+		bool linked = (curPage->GetPrevPage() == prevPid);
+		PageID nextPid = curPage->GetNextPage();
+
+		if (MINIBASE_BM->UnpinPage(curPid, CLEAN) == FAIL) {
+			std::cerr << "Unable to unpin page" << std::endl;
+			return -1;
+		}
+
+		if (!linked) {
+			std::cerr << "Leaf " << curPid << " is not linked back to leaf " << prevPid << std::endl;
+			return -1;
+		}
+
+		if (prevPid != INVALID_PAGE && curPid != prevPid + 1) {
+			numJumps++;
+		}
+		numLeaves++;
+
+		prevPid = curPid;
+		curPid = nextPid;
+	}
+
+	return numJumps;
+}
+
+//-------------------------------------------------------------------
 // BTreeDriver::TestNumEntries
 //
 // Input   : btf,  The B-Tree to test.
@@ -946,6 +3532,172 @@ bool BTreeDriver::TestScanCount(IndexFileScan* scan, int expected) {
 	return true;
 }
 
+//-------------------------------------------------------------------
+// BTreeDriver::TestSameEntries
+//
+// Input   : scan,    A scan of the index to test.
+//           refScan, The same scan of a B-Tree holding the entries the
+//                    index should hold.
+// Output  : None
+// Return  : True if both scans return the same keys and record ids
+//           in the same order.
+// Purpose : Tests an index against a reference B-Tree.
+//-------------------------------------------------------------------
+bool BTreeDriver::TestSameEntries(IndexFileScan *scan, IndexFileScan *refScan)
+{
+	RecordID rid, refRid;
+	char curKey[MAX_KEY_SIZE];
+	char refKey[MAX_KEY_SIZE];
+	int index = 0;
+
+	while (refScan->GetNext(refRid, refKey) != DONE) {
+		if (scan->GetNext(rid, curKey) == DONE) {
+			std::cerr << "Scan ended after " << index << " entries" << std::endl;
+			return false;
+		}
+
+		if (strcmp(curKey, refKey) != 0 || rid != refRid) {
+			std::cerr << "Entry " << index << " is " << curKey << " (" << rid.pageNo << ", "
+					  << rid.slotNo << "), expected " << refKey << " (" << refRid.pageNo
+					  << ", " << refRid.slotNo << ")" << std::endl;
+			return false;
+		}
+		index++;
+	}
+
+	if (scan->GetNext(rid, curKey) != DONE) {
+		std::cerr << "Scan has more than " << index << " entries" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool BTreeDriver::TestSameEntries(IndexFileScan *scan, BTreeFile *ref)
+{
+	IndexFileScan *refScan = ref->OpenScan(NULL, NULL);
+	bool test = TestSameEntries(scan, refScan);
+	delete refScan;
+	return test;
+}
+
+bool BTreeDriver::TestSameEntries(BTreeFile *btf, BTreeFile *ref)
+{
+	IndexFileScan *scan = btf->OpenScan(NULL, NULL);
+	bool test = TestSameEntries(scan, ref);
+	delete scan;
+	return test;
+}
+
+//-------------------------------------------------------------------
+// BTreeDriver::TestMultiGet
+//
+// Input   : btf,    The B-Tree to test.
+//           keys,   The keys to look up, as numbers.
+//           counts, The number of record ids expected for each key.
+//                   The record ids of key k are (k, 0), (k, 1), ...
+//           interleaved, Whether to use MultiGetInterleaved.
+// Output  : None
+// Return  : True if the batch and Lookup both find the expected
+//           record ids.
+// Purpose : Tests a batch of lookups against single lookups.
+//-------------------------------------------------------------------
+bool BTreeDriver::TestMultiGet(BTreeFile *btf, const std::vector<int> &keys,
+							   const std::vector<int> &counts, bool interleaved)
+{
+	std::vector<KeyView> keyViews(keys.size());
+	std::vector<std::string> keyStrings(keys.size());
+	std::vector<int> numRids(keys.size());
+	std::vector<RecordID> rids(3 * keys.size() + 1);
+	char key[MAX_KEY_SIZE];
+
+	for (unsigned int i = 0; i < keys.size(); i++) {
+		toString(keys[i], key);
+		keyStrings[i] = key;
+		keyViews[i].key = keyStrings[i].c_str();
+		keyViews[i].length = (int)keyStrings[i].size();
+	}
+
+	Status status;
+	if (interleaved) {
+		status = btf->MultiGetInterleaved(&keyViews[0], (int)keys.size(), &rids[0], (int)rids.size(), &numRids[0]);
+	} else {
+		status = btf->MultiGet(&keyViews[0], (int)keys.size(), &rids[0], (int)rids.size(), &numRids[0]);
+	}
+
+	if (status != OK) {
+		std::cerr << "MultiGet() failed" << std::endl;
+		return false;
+	}
+
+	int offset = 0;
+	for (unsigned int i = 0; i < keys.size(); i++) {
+		if (numRids[i] != counts[i]) {
+			std::cerr << "MultiGet() found " << numRids[i] << " record ids for key "
+					  << keyStrings[i] << ", expected " << counts[i] << std::endl;
+			return false;
+		}
+
+		for (int j = 0; j < numRids[i]; j++) {
+			if (rids[offset + j].pageNo != keys[i] || rids[offset + j].slotNo != j) {
+				std::cerr << "MultiGet() returned a wrong record id for key " << keyStrings[i] << std::endl;
+				return false;
+			}
+		}
+
+		RecordID lookupRids[3];
+		int numLookupRids;
+		if (btf->Lookup(keyStrings[i].c_str(), lookupRids, 3, numLookupRids) != OK ||
+			numLookupRids != counts[i] ||
+			!std::equal(lookupRids, lookupRids + numLookupRids, rids.begin() + offset)) {
+			std::cerr << "Lookup() disagrees with MultiGet() for key " << keyStrings[i] << std::endl;
+			return false;
+		}
+
+		offset += numRids[i];
+	}
+
+	return true;
+}
+
+//-------------------------------------------------------------------
+// BTreeDriver::TestSameLookups
+//
+// Input   : index, The index to test.
+//           ref,   A B-Tree holding the entries the index should hold.
+//           keys,  The keys to look up.
+// Output  : None
+// Return  : True if Lookup finds the same record ids, in any order,
+//           for every key in both.
+// Purpose : Tests an index that cannot be scanned against a B-Tree.
+//-------------------------------------------------------------------
+bool BTreeDriver::TestSameLookups(IndexFile *index, BTreeFile *ref,
+								  const std::vector<std::string> &keys)
+{
+	const int maxRids = 1000;
+	std::vector<RecordID> rids(maxRids);
+	std::vector<RecordID> refRids(maxRids);
+	int numRids, numRefRids;
+
+	for (unsigned int i = 0; i < keys.size(); i++) {
+		if (index->Lookup(keys[i].c_str(), &rids[0], maxRids, numRids) != OK ||
+			ref->Lookup(keys[i].c_str(), &refRids[0], maxRids, numRefRids) != OK) {
+			std::cerr << "Lookup(" << keys[i] << ") failed" << std::endl;
+			return false;
+		}
+
+		std::sort(rids.begin(), rids.begin() + numRids);
+		std::sort(refRids.begin(), refRids.begin() + numRefRids);
+		if (numRids != numRefRids || !std::equal(rids.begin(), rids.begin() + numRids, refRids.begin())) {
+			std::cerr << "Lookup(" << keys[i] << ") found " << numRids
+					  << " record ids, expected " << numRefRids << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
 bool BTreeDriver::TestScanKeys(BTreeFile *btf, const char *lowKey, const char *highKey, const std::vector<int> &keys, int pad)
 {
 	IndexFileScan *scan = btf->OpenScan(lowKey, highKey);
@@ -0,0 +1,144 @@
+#include "bufmgr.h"
+#include "btresident.h"
+
+
+int BTResidentTable::totalPages = 0;
+
+
+//-------------------------------------------------------------------
+// BTResidentTable::BTResidentTable
+//
+// Input   : None
+// Output  : None
+// Purpose : Create an empty table.
+//-------------------------------------------------------------------
+
+BTResidentTable::BTResidentTable ()
+{
+	for (int i = 0; i < RESIDENT_TABLE_SIZE; i++)
+		entries[i].pageID = INVALID_PAGE;
+	numPages = 0;
+}
+
+
+//-------------------------------------------------------------------
+// BTResidentTable::Slot
+//
+// Input   : pageID - a page id.
+// Output  : None
+// Return  : The entry that holds pageID, or the free entry where it
+//           would go.  The table is never full, so there is one.
+//-------------------------------------------------------------------
+
+int BTResidentTable::Slot (PageID pageID)
+{
+	int slot = (int)((unsigned int)pageID * 2654435761U) & (RESIDENT_TABLE_SIZE - 1);
+
+	while (entries[slot].pageID != INVALID_PAGE && entries[slot].pageID != pageID)
+		slot = (slot + 1) & (RESIDENT_TABLE_SIZE - 1);
+	return slot;
+}
+
+
+//-------------------------------------------------------------------
+// BTResidentTable::Find
+//
+// Input   : pageID - the page to look up.
+// Output  : None
+// Return  : The frame of the page if it is resident, NULL otherwise.
+//-------------------------------------------------------------------
+
+SortedPage *BTResidentTable::Find (PageID pageID)
+{
+	Entry *entry = &entries[Slot(pageID)];
+
+	return (entry->pageID == pageID) ? entry->page : NULL;
+}
+
+
+//-------------------------------------------------------------------
+// BTResidentTable::Add
+//
+// Input   : pageID, page - a page that has just been pinned.
+// Output  : None
+// Return  : true if the page is now resident, and the table has taken
+//           over the pin; false if the table is full or the trees
+//           already have their share of the buffer pool resident.
+//-------------------------------------------------------------------
+
+bool BTResidentTable::Add (PageID pageID, SortedPage *page)
+{
+	Entry *entry;
+
+	if (numPages == RESIDENT_MAX_PAGES ||
+		totalPages >= (int)(MINIBASE_BM->GetNumOfBuffers() / RESIDENT_POOL_SHARE))
+		return false;
+
+	entry = &entries[Slot(pageID)];
+	entry->pageID = pageID;
+	entry->page = page;
+	entry->dirty = false;
+	numPages++;
+	totalPages++;
+	return true;
+}
+
+
+//-------------------------------------------------------------------
+// BTResidentTable::Unpin
+//
+// Input   : pageID - a page the caller is done with.
+//           dirty - whether the caller changed it.
+// Output  : None
+// Return  : OK if the page is resident, in which case it stays
+//           pinned; DONE if the caller has to unpin it; FAIL on error.
+// Purpose : Pass the first change to a resident page on to the buffer
+//           manager, by pinning it once more and unpinning it dirty.
+//-------------------------------------------------------------------
+
+Status BTResidentTable::Unpin (PageID pageID, bool dirty)
+{
+	Entry *entry = &entries[Slot(pageID)];
+	Page *page;
+
+	if (entry->pageID != pageID)
+		return DONE;
+
+	if (dirty && !entry->dirty) {
+		PIN(pageID, page);
+		UNPIN(pageID, DIRTY);
+		entry->dirty = true;
+	}
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTResidentTable::ReleaseAll
+//
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Unpin every resident page, dirty if it was changed, and
+//           empty the table.
+//-------------------------------------------------------------------
+
+Status BTResidentTable::ReleaseAll ()
+{
+	Status s = OK;
+
+	for (int i = 0; i < RESIDENT_TABLE_SIZE; i++) {
+		if (entries[i].pageID == INVALID_PAGE)
+			continue;
+
+		if (MINIBASE_BM->UnpinPage(entries[i].pageID, entries[i].dirty) != OK) {
+			cerr << "Unable to unpin page " << entries[i].pageID << endl;
+			s = FAIL;
+		}
+		entries[i].pageID = INVALID_PAGE;
+	}
+
+	totalPages -= numPages;
+	numPages = 0;
+	return s;
+}
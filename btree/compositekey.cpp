@@ -0,0 +1,387 @@
+#include <string.h>
+#include "compositekey.h"
+
+
+//-------------------------------------------------------------------
+// KeySchema::KeySchema
+//
+// Input   : None
+// Output  : None
+// Purpose : Create a schema with no columns.
+//-------------------------------------------------------------------
+
+KeySchema::KeySchema ()
+{
+	numOfColumns = 0;
+}
+
+
+//-------------------------------------------------------------------
+// KeySchema::AddColumn
+//
+// Input   : type - type of the column.
+//           length - length of the column in a record, as in the
+//                    attrLen of the catalog.  Integers may be 1, 2, 4
+//                    or 8 bytes and reals 4 or 8; strings any length.
+// Output  : None
+// Purpose : Append a column to the schema.
+// Return  : OK if successful, FAIL if the schema is full or the
+//           column cannot be encoded.
+//-------------------------------------------------------------------
+
+Status KeySchema::AddColumn (AttrType type, int length)
+{
+	if (numOfColumns == MAX_KEY_COLUMNS)
+	{
+		cerr << "error: too many key columns" << endl;
+		return FAIL;
+	}
+
+	switch (type)
+	{
+	case attrInteger:
+		if (length != 1 && length != 2 && length != 4 && length != 8)
+			return FAIL;
+		break;
+	case attrReal:
+		if (length != sizeof(float) && length != sizeof(double))
+			return FAIL;
+		break;
+	case attrString:
+		if (length <= 0)
+			return FAIL;
+		break;
+	default:
+		return FAIL;
+	}
+
+	types[numOfColumns] = type;
+	lengths[numOfColumns] = length;
+	numOfColumns++;
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// CompositeKey::CompositeKey
+//
+// Input   : schema - the columns of the key.  It must outlive the key.
+// Output  : None
+// Purpose : Create an empty key over schema.
+//-------------------------------------------------------------------
+
+CompositeKey::CompositeKey (const KeySchema &s) : schema(s)
+{
+	Clear();
+}
+
+
+//-------------------------------------------------------------------
+// CompositeKey::Clear
+//
+// Input   : None
+// Output  : None
+// Purpose : Remove all columns from the key so that it can be reused.
+//-------------------------------------------------------------------
+
+void CompositeKey::Clear ()
+{
+	numOfColumns = 0;
+	length = 0;
+}
+
+
+//-------------------------------------------------------------------
+// CompositeKey::GetKeyView
+//
+// Input   : None
+// Output  : None
+// Purpose : Return the encoded key.  If fewer columns than the schema
+//           has have been appended, this is a prefix that can be
+//           passed to BTreeFile::OpenPrefixScan.
+// Return  : A view of the key, valid until the key is changed.
+//-------------------------------------------------------------------
+
+KeyView CompositeKey::GetKeyView () const
+{
+	KeyView view;
+
+	view.key = key;
+	view.length = length;
+	return view;
+}
+
+
+//-------------------------------------------------------------------
+// CompositeKey::AppendInt
+//
+// Input   : value - value of the next column, which is an integer.
+// Output  : None
+// Purpose : Encode an integer so that the signed order of the values
+//           is the unsigned order of the bytes.
+// Return  : OK if successful, FAIL otherwise.
+//-------------------------------------------------------------------
+
+Status CompositeKey::AppendInt (int value)
+{
+	return AppendInteger(value);
+}
+
+
+//-------------------------------------------------------------------
+// CompositeKey::AppendInteger
+//
+// Input   : value - value of the next column, which is an integer.
+// Output  : None
+// Purpose : Encode an integer in the width of its column, so that keys
+//           built from AppendInt and from AppendColumn agree.
+// Return  : OK if successful, FAIL if the value does not fit in the
+//           column, as it would then sort in the wrong place.
+//-------------------------------------------------------------------
+
+Status CompositeKey::AppendInteger (long long value)
+{
+	unsigned char bytes[8];
+	int len;
+
+	if (CheckColumn(attrInteger) != OK)
+		return FAIL;
+
+	len = schema.GetLength(numOfColumns);
+	if (len < 8) {
+		long long limit = 1LL << (8 * len - 1);
+
+		if (value < -limit || value >= limit)
+			return FAIL;
+	}
+
+	unsigned long long bits = (unsigned long long)value;
+	bits ^= 1ULL << (8 * len - 1);
+	for (int i = 0; i < len; i++)
+		bytes[i] = (unsigned char)(bits >> (8 * (len - 1 - i)));
+
+	if (AppendBytes(bytes, len) != OK)
+		return FAIL;
+	numOfColumns++;
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// CompositeKey::AppendReal
+//
+// Input   : value - value of the next column, which is a real.
+// Output  : None
+// Purpose : Encode a float or double, as the column length says, so
+//           that the numeric order of the values is the unsigned order
+//           of the bytes.  -0.0 sorts just below 0.0.
+// Return  : OK if successful, FAIL otherwise.
+//-------------------------------------------------------------------
+
+Status CompositeKey::AppendReal (double value)
+{
+	unsigned char bytes[8];
+	unsigned long long bits;
+	int len;
+
+	if (CheckColumn(attrReal) != OK)
+		return FAIL;
+
+	len = schema.GetLength(numOfColumns);
+	if (len == sizeof(float))
+	{
+		float f = (float)value;
+		unsigned int b;
+		memcpy(&b, &f, sizeof(b));
+		bits = b;
+	}
+	else
+	{
+		memcpy(&bits, &value, sizeof(bits));
+	}
+
+	unsigned long long signBit = 1ULL << (8 * len - 1);
+	if (bits & signBit)
+		bits = ~bits;
+	else
+		bits |= signBit;
+
+	for (int i = 0; i < len; i++)
+		bytes[i] = (unsigned char)(bits >> (8 * (len - 1 - i)));
+
+	if (AppendBytes(bytes, len) != OK)
+		return FAIL;
+	numOfColumns++;
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// CompositeKey::AppendString
+//
+// Input   : value - value of the next column, a null-terminated string.
+// Output  : None
+// Purpose : Encode a string column.
+// Return  : OK if successful, FAIL otherwise.
+//-------------------------------------------------------------------
+
+Status CompositeKey::AppendString (const char *value)
+{
+	return AppendString(value, strlen(value));
+}
+
+
+//-------------------------------------------------------------------
+// CompositeKey::AppendString
+//
+// Input   : value - value of the next column, which is a string.
+//           len - number of bytes in value, which may contain nulls.
+// Output  : None
+// Purpose : Encode a string column, escaping its nulls and ending it
+//           with a terminator.
+// Return  : OK if successful, FAIL otherwise.
+//-------------------------------------------------------------------
+
+Status CompositeKey::AppendString (const char *value, int len)
+{
+	static const unsigned char escape[2] = { 0x00, 0xFF };
+	static const unsigned char terminator[2] = { 0x00, 0x01 };
+	int start = length;
+
+	if (CheckColumn(attrString) != OK)
+		return FAIL;
+
+	if (len > schema.GetLength(numOfColumns))
+		return FAIL;
+
+	for (int i = 0; i < len; i++)
+	{
+		Status s;
+
+		if (value[i] == '\0')
+			s = AppendBytes(escape, 2);
+		else
+			s = AppendBytes((const unsigned char *)value + i, 1);
+
+		if (s != OK)
+		{
+			length = start;
+			return FAIL;
+		}
+	}
+
+	if (AppendBytes(terminator, 2) != OK)
+	{
+		length = start;
+		return FAIL;
+	}
+
+	numOfColumns++;
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// CompositeKey::AppendColumn
+//
+// Input   : value - the next column as it is stored in a record:
+//                   a native integer or real of the column's length,
+//                   or a string padded with nulls to that length.
+// Output  : None
+// Purpose : Encode a column straight out of a record.
+// Return  : OK if successful, FAIL otherwise.
+//-------------------------------------------------------------------
+
+Status CompositeKey::AppendColumn (const char *value)
+{
+	if (numOfColumns == schema.GetNumOfColumns())
+		return FAIL;
+
+	int len = schema.GetLength(numOfColumns);
+
+	switch (schema.GetType(numOfColumns))
+	{
+	case attrInteger:
+		{
+			long long v;
+
+			switch (len)
+			{
+			case 1: { signed char c; memcpy(&c, value, 1); v = c; break; }
+			case 2: { short h; memcpy(&h, value, 2); v = h; break; }
+			case 4: { int i; memcpy(&i, value, 4); v = i; break; }
+			default: memcpy(&v, value, 8); break;
+			}
+			return AppendInteger(v);
+		}
+
+	case attrReal:
+		if (len == sizeof(float))
+		{
+			float f;
+			memcpy(&f, value, sizeof(f));
+			return AppendReal(f);
+		}
+		else
+		{
+			double d;
+			memcpy(&d, value, sizeof(d));
+			return AppendReal(d);
+		}
+
+	case attrString:
+		{
+			const char *end = (const char *)memchr(value, '\0', len);
+			return AppendString(value, end ? end - value : len);
+		}
+
+	default:
+		return FAIL;
+	}
+}
+
+
+//-------------------------------------------------------------------
+// CompositeKey::CheckColumn
+//
+// Input   : type - type of the value about to be appended.
+// Output  : None
+// Purpose : Make sure the next column of the schema has that type.
+// Return  : OK if it does, FAIL otherwise.
+//-------------------------------------------------------------------
+
+Status CompositeKey::CheckColumn (AttrType type)
+{
+	if (numOfColumns == schema.GetNumOfColumns() ||
+		schema.GetType(numOfColumns) != type)
+	{
+		cerr << "error: key value does not match the key schema" << endl;
+		return FAIL;
+	}
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// CompositeKey::AppendBytes
+//
+// Input   : bytes - encoded bytes to add to the key.
+//           len - number of bytes.
+// Output  : None
+// Purpose : Add bytes to the end of the key.  The caller counts the
+//           column once all of its bytes are in.
+// Return  : OK if successful, FAIL if the key would be too long.
+//-------------------------------------------------------------------
+
+Status CompositeKey::AppendBytes (const unsigned char *bytes, int len)
+{
+	if (length + len >= MAX_KEY_SIZE)
+	{
+		cerr << "error: composite key length exceeds maximum" << endl;
+		return FAIL;
+	}
+
+	memcpy(key + length, bytes, len);
+	length += len;
+	return OK;
+}
@@ -0,0 +1,802 @@
+#include "minirel.h"
+#include "bufmgr.h"
+#include "db.h"
+#include "hashindex.h"
+
+//-------------------------------------------------------------------
+// HashIndexFile::HashIndexFile
+//
+// Input   : filename - filename of an index.
+// Output  : returnStatus - status of execution of constructor.
+//           OK if successful, FAIL otherwise.
+// Purpose : Open the index file, if it exists.  Otherwise, create a
+//           new index with the specified filename, made of a header
+//           page, a directory of one entry and a single empty bucket.
+//           The header page stays pinned until the index is closed.
+//-------------------------------------------------------------------
+
+HashIndexFile::HashIndexFile (Status& returnStatus, const char *filename)
+{
+	dbname = strcpy(new char[strlen(filename) + 1], filename);
+
+	Status stat = GetIndexFileEntry(filename, headerID);
+	Page *_headerPage;
+	returnStatus = OK;
+
+	if (stat == FAIL) {
+		stat = MINIBASE_BM->NewPage(headerID, _headerPage, 1);
+
+		if (stat != OK) {
+			cerr << "Error allocating header page." << endl;
+			headerID = INVALID_PAGE;
+			header = NULL;
+			returnStatus = FAIL;
+			return;
+		}
+
+		header = (HashHeaderPage *)(_headerPage);
+		header->Init(headerID);
+
+		if (CreateDirectory() != OK || AddIndexFileEntry(filename, headerID) != OK) {
+			cerr << "Error creating file" << endl;
+			MINIBASE_BM->UnpinPage(headerID, DIRTY);
+			headerID = INVALID_PAGE;
+			header = NULL;
+			returnStatus = FAIL;
+			return;
+		}
+	} else {
+		stat = MINIBASE_BM->PinPage(headerID, _headerPage);
+
+		if (stat != OK) {
+			cerr << "Error pinning existing header page" << endl;
+			headerID = INVALID_PAGE;
+			header = NULL;
+			returnStatus = FAIL;
+			return;
+		}
+
+		header = (HashHeaderPage *) _headerPage;
+	}
+}
+
+
+//-------------------------------------------------------------------
+// HashIndexFile::~HashIndexFile
+//
+// Input   : None
+// Output  : None
+// Purpose : Free memory and unpin the header page, unless DestroyFile
+//           has freed it.  The header is written back, as it holds
+//           the directory.
+//-------------------------------------------------------------------
+
+HashIndexFile::~HashIndexFile ()
+{
+	delete [] dbname;
+
+	if (headerID != INVALID_PAGE) {
+		if (MINIBASE_BM->UnpinPage(headerID, DIRTY) != OK)
+			cerr << "ERROR : Cannot unpin page " << headerID << " in HashIndexFile::~HashIndexFile" << endl;
+	}
+}
+
+
+//-------------------------------------------------------------------
+// HashIndexFile::DestroyFile
+//
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Free the buckets, the directory and the header page, and
+//           delete the index file.  The directory is walked from
+//           the top, so a bucket is freed at its lowest entry, the one
+//           whose index is below 2^localDepth, after all the others.
+//-------------------------------------------------------------------
+
+Status HashIndexFile::DestroyFile ()
+{
+	PageID dirPageID = header->GetDirPageID();
+	int dirSize = 1 << header->GetGlobalDepth();
+
+	for (int index = dirSize - 1; index >= 0; index--) {
+		PageID bucketID;
+		HashBucketPage *bucket;
+
+		if (GetBucket((unsigned long long)index, bucketID) != OK)
+			return FAIL;
+
+		PIN(bucketID, bucket);
+		if (index < (1 << bucket->GetLocalDepth())) {
+			if (FreeChain(bucket->GetNextPage()) != OK)
+				return FAIL;
+			FREEPAGE(bucketID);
+		}
+		else {
+			UNPIN(bucketID, CLEAN);
+		}
+	}
+
+	if (FreeDirectory(dirPageID, header->GetDirNumPages()) != OK)
+		return FAIL;
+
+	if (DeleteIndexFileEntry(dbname, headerID) != OK) {
+		cerr << "DeleteIndexFileEntry failed in HashIndexFile::DestroyFile" << endl;
+		return FAIL;
+	}
+
+	FREEPAGE(headerID);
+	headerID = INVALID_PAGE;
+	header = NULL;
+
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// HashIndexFile::Insert
+//
+// Input   : key - pointer to the value of the key to be inserted.
+//           rid - RecordID of the record to be inserted.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Insert an index entry with this rid and key.
+//-------------------------------------------------------------------
+
+Status HashIndexFile::Insert (const char *key, const RecordID rid)
+{
+	return Insert(MakeKeyView(key), rid);
+}
+
+
+//-------------------------------------------------------------------
+// HashIndexFile::Insert
+//
+// Input   : key - the key to be inserted, which may be any sequence
+//                 of bytes.
+//           rid - RecordID of the record to be inserted.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Insert the entry into the bucket of its key.  A full
+//           bucket is split, doubling the directory if need be, and
+//           the insert tried again; a bucket that no split can help
+//           gets an overflow page instead.
+//-------------------------------------------------------------------
+
+Status HashIndexFile::Insert (const KeyView &key, const RecordID rid)
+{
+	KeyDataEntry entry;
+	DataType data;
+	int len;
+	unsigned long long hash = GetKeyHash(key);
+
+	data.rid = rid;
+	MakeEntry(&entry, key, LEAF_NODE, data, &len);
+
+	while (true) {
+		PageID bucketID;
+		HashBucketPage *bucket;
+		RecordID entryRid;
+		bool canSplit;
+		Status s;
+
+		if (GetBucket(hash, bucketID) != OK)
+			return FAIL;
+
+		PIN(bucketID, bucket);
+
+		if (bucket->AvailableSpace() >= len) {
+			s = bucket->InsertRecord((char *)&entry, len, entryRid);
+			UNPIN(bucketID, DIRTY);
+			return s;
+		}
+
+		if (CanSplit(bucket, hash, canSplit) != OK) {
+			UNPIN(bucketID, CLEAN);
+			return FAIL;
+		}
+
+		if (!canSplit) {
+			s = ChainInsert(bucketID, bucket, (char *)&entry, len);
+			UNPIN(bucketID, DIRTY);
+			return s;
+		}
+
+		if (bucket->GetLocalDepth() == header->GetGlobalDepth() && DoubleDirectory() != OK) {
+			UNPIN(bucketID, CLEAN);
+			return FAIL;
+		}
+
+		s = SplitBucket(bucketID, bucket, hash);
+		UNPIN(bucketID, DIRTY);
+		if (s != OK)
+			return FAIL;
+	}
+}
+
+
+//-------------------------------------------------------------------
+// HashIndexFile::Delete
+//
+// Input   : key - pointer to the value of the key to be deleted.
+//           rid - RecordID of the record to be deleted.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Delete an entry with this rid and key.
+//-------------------------------------------------------------------
+
+Status HashIndexFile::Delete (const char *key, const RecordID rid)
+{
+	return Delete(MakeKeyView(key), rid);
+}
+
+
+//-------------------------------------------------------------------
+// HashIndexFile::Delete
+//
+// Input   : key - the key to be deleted.
+//           rid - RecordID of the record to be deleted.
+// Output  : None
+// Return  : OK if successful, FAIL if there is no such entry.
+// Purpose : Delete the entry (key, rid) from the bucket of key.  An
+//           overflow page left empty is taken out of the chain and
+//           freed; the first page of a bucket stays even when empty.
+//-------------------------------------------------------------------
+
+Status HashIndexFile::Delete (const KeyView &key, const RecordID rid)
+{
+	PageID bucketID, pageID, prevID = INVALID_PAGE;
+	HashBucketPage *page;
+
+	if (GetBucket(GetKeyHash(key), bucketID) != OK)
+		return FAIL;
+
+	pageID = bucketID;
+	while (pageID != INVALID_PAGE) {
+		RecordID cur;
+		Status s;
+
+		PIN(pageID, page);
+
+		for (s = page->FirstRecord(cur); s == OK; s = page->NextRecord(cur, cur)) {
+			char *entry;
+			int len;
+
+			page->ReturnRecord(cur, entry, len);
+			if (GetEntryRid(entry, len, LEAF_NODE) != rid ||
+				KeyCmp(GetEntryKey(entry, len, LEAF_NODE), key) != 0)
+				continue;
+
+			page->DeleteRecord(cur);
+
+			if (prevID != INVALID_PAGE && page->IsEmpty()) {
+				HashBucketPage *prev;
+				PageID nextID = page->GetNextPage();
+
+				FREEPAGE(pageID);
+				PIN(prevID, prev);
+				prev->SetNextPage(nextID);
+				UNPIN(prevID, DIRTY);
+			}
+			else {
+				UNPIN(pageID, DIRTY);
+			}
+			return OK;
+		}
+
+		prevID = pageID;
+		pageID = page->GetNextPage();
+		UNPIN(prevID, CLEAN);
+	}
+
+	return FAIL;
+}
+
+
+//-------------------------------------------------------------------
+// HashIndexFile::Lookup
+//
+// Input   : key - pointer to the key to look up.
+//           rids - buffer for the record ids found.
+//           maxRids - number of record ids rids can hold.
+// Output  : numRids - number of record ids written to rids.
+// Return  : OK if every entry with key was returned, DONE if rids
+//           filled up first, FAIL on error.
+// Purpose : Find all entries with key.
+//-------------------------------------------------------------------
+
+Status HashIndexFile::Lookup (const char *key, RecordID *rids, int maxRids, int &numRids)
+{
+	return Lookup(MakeKeyView(key), rids, maxRids, numRids);
+}
+
+
+//-------------------------------------------------------------------
+// HashIndexFile::Lookup
+//
+// Input   : key - the key to look up, which may be any sequence of
+//                 bytes.
+//           rids, maxRids - as above.
+// Output  : numRids - as above.
+// Return  : As above.
+// Purpose : Find all entries with key, reading one directory page and
+//           the pages of one bucket.  The record ids come out in no
+//           particular order.
+//-------------------------------------------------------------------
+
+Status HashIndexFile::Lookup (const KeyView &key, RecordID *rids, int maxRids, int &numRids)
+{
+	PageID pageID;
+	HashBucketPage *page;
+
+	numRids = 0;
+
+	if (GetBucket(GetKeyHash(key), pageID) != OK)
+		return FAIL;
+
+	while (pageID != INVALID_PAGE) {
+		RecordID cur;
+		Status s;
+
+		PIN(pageID, page);
+
+		for (s = page->FirstRecord(cur); s == OK; s = page->NextRecord(cur, cur)) {
+			char *entry;
+			int len;
+
+			page->ReturnRecord(cur, entry, len);
+			if (KeyCmp(GetEntryKey(entry, len, LEAF_NODE), key) != 0)
+				continue;
+
+			if (numRids == maxRids) {
+				UNPIN(pageID, CLEAN);
+				return DONE;
+			}
+			rids[numRids++] = GetEntryRid(entry, len, LEAF_NODE);
+		}
+
+		PageID nextID = page->GetNextPage();
+		UNPIN(pageID, CLEAN);
+		pageID = nextID;
+	}
+
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// HashIndexFile::CreateDirectory
+//
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Give a new index a directory of one entry, of global
+//           depth 0, pointing to an empty bucket.
+//-------------------------------------------------------------------
+
+Status HashIndexFile::CreateDirectory ()
+{
+	PageID bucketID, dirPageID;
+	HashBucketPage *bucket;
+	PageID *entries;
+
+	NEWPAGE(bucketID, bucket);
+	bucket->Init(bucketID, 0);
+	UNPIN(bucketID, DIRTY);
+
+	NEWPAGE(dirPageID, entries);
+	entries[0] = bucketID;
+	UNPIN(dirPageID, DIRTY);
+
+	header->SetDirectory(0, dirPageID, 1);
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// HashIndexFile::GetBucket
+//
+// Input   : hash - the hash of a key.
+// Output  : bucketID - the first page of the bucket of the key.
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Look up the directory entry for the low globalDepth bits
+//           of hash.
+//-------------------------------------------------------------------
+
+Status HashIndexFile::GetBucket (unsigned long long hash, PageID &bucketID)
+{
+	int index = (int)(hash & ((1ULL << header->GetGlobalDepth()) - 1));
+	PageID dirPageID = header->GetDirPageID() + index / HASH_DIR_ENTRIES_PER_PAGE;
+	PageID *entries;
+
+	PIN(dirPageID, entries);
+	bucketID = entries[index % HASH_DIR_ENTRIES_PER_PAGE];
+	UNPIN(dirPageID, CLEAN);
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// HashIndexFile::SetBuckets
+//
+// Input   : hash - the hash of a key of the bucket.
+//           localDepth - the local depth of the bucket.
+//           bucketID - the first page of the bucket.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Point every directory entry that agrees with hash on its
+//           low localDepth bits to the bucket.
+//-------------------------------------------------------------------
+
+Status HashIndexFile::SetBuckets (unsigned long long hash, int localDepth, PageID bucketID)
+{
+	int dirSize = 1 << header->GetGlobalDepth();
+	int step = 1 << localDepth;
+	PageID pinnedID = INVALID_PAGE;
+	PageID *entries = NULL;
+
+	for (int index = (int)(hash & (step - 1)); index < dirSize; index += step) {
+		PageID dirPageID = header->GetDirPageID() + index / HASH_DIR_ENTRIES_PER_PAGE;
+
+		if (dirPageID != pinnedID) {
+			if (pinnedID != INVALID_PAGE) {
+				UNPIN(pinnedID, DIRTY);
+			}
+			pinnedID = dirPageID;
+			PIN(pinnedID, entries);
+		}
+		entries[index % HASH_DIR_ENTRIES_PER_PAGE] = bucketID;
+	}
+
+	if (pinnedID != INVALID_PAGE) {
+		UNPIN(pinnedID, DIRTY);
+	}
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// HashIndexFile::DoubleDirectory
+//
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Increase the global depth by one.  The directory is copied
+//           into a run twice its size, where entries i and
+//           i + 2^globalDepth both take the bucket of old entry i, and
+//           the old run is freed.
+//-------------------------------------------------------------------
+
+Status HashIndexFile::DoubleDirectory ()
+{
+	int globalDepth = header->GetGlobalDepth();
+	int oldSize = 1 << globalDepth;
+	int newSize = oldSize * 2;
+	int oldNumPages = header->GetDirNumPages();
+	int newNumPages = (newSize + HASH_DIR_ENTRIES_PER_PAGE - 1) / HASH_DIR_ENTRIES_PER_PAGE;
+	PageID oldFirstID = header->GetDirPageID();
+	PageID newFirstID;
+	Page *newFirstPage;
+	Status s = OK;
+
+	if (globalDepth >= HASH_MAX_GLOBAL_DEPTH)
+		return FAIL;
+
+	if (MINIBASE_BM->NewPage(newFirstID, newFirstPage, newNumPages) != OK) {
+		cerr << "Unable to allocate " << newNumPages << " directory pages" << endl;
+		return FAIL;
+	}
+
+	for (int i = 0; i < newNumPages; i++) {
+		PageID *newEntries, *oldEntries;
+		PageID oldPageID = oldFirstID + i % oldNumPages;
+		int first = i * HASH_DIR_ENTRIES_PER_PAGE;              // first index on the new page
+		int oldFirst = (i % oldNumPages) * HASH_DIR_ENTRIES_PER_PAGE; // first index on the old page
+
+		// NewPage pins only the first page of the run
+		if (i == 0) {
+			newEntries = (PageID *) newFirstPage;
+		}
+		else if (MINIBASE_BM->PinPage(newFirstID + i, (Page *&)newEntries, true) != OK) {
+			cerr << "Unable to pin page " << newFirstID + i << endl;
+			s = FAIL;
+			break;
+		}
+
+		if (MINIBASE_BM->PinPage(oldPageID, (Page *&)oldEntries) != OK) {
+			cerr << "Unable to pin page " << oldPageID << endl;
+			MINIBASE_BM->UnpinPage(newFirstID + i, CLEAN);
+			s = FAIL;
+			break;
+		}
+		for (int k = 0; k < HASH_DIR_ENTRIES_PER_PAGE && first + k < newSize; k++)
+			newEntries[k] = oldEntries[((first + k) & (oldSize - 1)) - oldFirst];
+		if (MINIBASE_BM->UnpinPage(oldPageID, CLEAN) != OK ||
+			MINIBASE_BM->UnpinPage(newFirstID + i, DIRTY) != OK) {
+			cerr << "Unable to unpin directory pages" << endl;
+			s = FAIL;
+			break;
+		}
+	}
+
+	// The old directory stays in use until the new one is complete
+	if (s != OK) {
+		FreeDirectory(newFirstID, newNumPages);
+		return FAIL;
+	}
+
+	if (FreeDirectory(oldFirstID, oldNumPages) != OK)
+		return FAIL;
+
+	header->SetDirectory(globalDepth + 1, newFirstID, newNumPages);
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// HashIndexFile::SplitBucket
+//
+// Input   : bucketID, bucket - the first page of a full bucket, pinned.
+//           hash - the hash of a key of the bucket.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Split the bucket on bit localDepth of the hashes: the
+//           entries of the whole chain that have the bit set move to
+//           a new bucket, the others are packed back into bucket, and
+//           both get local depth localDepth + 1.  The global depth
+//           must already be above localDepth.
+// Note    : The entries that stay are first packed into a copy of
+//           bucket, which is only copied over it, and the old chain
+//           freed, once every entry has been placed.  If the split
+//           fails, the bucket is left as it was.
+//-------------------------------------------------------------------
+
+Status HashIndexFile::SplitBucket (PageID bucketID, HashBucketPage *bucket, unsigned long long hash)
+{
+	int localDepth = bucket->GetLocalDepth();
+	unsigned long long bit = 1ULL << localDepth;
+	PageID newBucketID, pageID, oldNextID;
+	HashBucketPage *newBucket, *kept;
+	int numPages;
+	char *entries;
+	int length = 0;
+	Status s = OK;
+
+	// Copy the entries of the chain out, each one after its length
+	for (pageID = bucket->GetNextPage(), numPages = 1; pageID != INVALID_PAGE; numPages++) {
+		HashBucketPage *page;
+
+		PIN(pageID, page);
+		PageID nextID = page->GetNextPage();
+		UNPIN(pageID, CLEAN);
+		pageID = nextID;
+	}
+
+	entries = new char[numPages * MAX_SPACE];
+
+	for (pageID = bucketID; pageID != INVALID_PAGE; ) {
+		HashBucketPage *page = bucket;
+		RecordID cur;
+		Status t;
+
+		if (pageID != bucketID) {
+			PIN(pageID, page);
+		}
+
+		for (t = page->FirstRecord(cur); t == OK; t = page->NextRecord(cur, cur)) {
+			char *entry;
+			int len;
+
+			page->ReturnRecord(cur, entry, len);
+			memcpy(entries + length, &len, sizeof(int));
+			memcpy(entries + length + sizeof(int), entry, len);
+			length += sizeof(int) + len;
+		}
+
+		PageID nextID = page->GetNextPage();
+		if (pageID != bucketID) {
+			UNPIN(pageID, CLEAN);
+		}
+		pageID = nextID;
+	}
+
+	// Deal the entries out between the new bucket and a fresh copy of
+	// this one, leaving the old chain alone until they are all placed
+	if (MINIBASE_BM->NewPage(newBucketID, (Page *&)newBucket) != OK) {
+		cerr << "Unable to allocate new page" << endl;
+		delete [] entries;
+		return FAIL;
+	}
+	newBucket->Init(newBucketID, localDepth + 1);
+
+	kept = (HashBucketPage *)new char[MAX_SPACE];
+	kept->Init(bucketID, localDepth + 1);
+
+	for (int offset = 0; offset < length && s == OK; ) {
+		char *entry = entries + offset + sizeof(int);
+		int len;
+
+		memcpy(&len, entries + offset, sizeof(int));
+		offset += sizeof(int) + len;
+
+		if (GetKeyHash(GetEntryKey(entry, len, LEAF_NODE)) & bit)
+			s = ChainInsert(newBucketID, newBucket, entry, len);
+		else
+			s = ChainInsert(bucketID, kept, entry, len);
+	}
+	delete [] entries;
+
+	if (s != OK) {
+		FreeChain(kept->GetNextPage());
+		FreeChain(newBucket->GetNextPage());
+		MINIBASE_BM->FreePage(newBucketID);
+		delete [] (char *)kept;
+		return FAIL;
+	}
+
+	// Every entry is placed, so the old overflow pages can go
+	oldNextID = bucket->GetNextPage();
+	memcpy(bucket, kept, MAX_SPACE);
+	delete [] (char *)kept;
+
+	UNPIN(newBucketID, DIRTY);
+	if (FreeChain(oldNextID) != OK)
+		return FAIL;
+
+	return SetBuckets((hash & (bit - 1)) | bit, localDepth + 1, newBucketID);
+}
+
+
+//-------------------------------------------------------------------
+// HashIndexFile::ChainInsert
+//
+// Input   : bucketID, bucket - the first page of a bucket, pinned.
+//           entry, len - the entry to be inserted.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Insert the entry on the first page of the chain with room
+//           for it, adding an overflow page at the end if none has.
+//           bucket is left pinned.
+//-------------------------------------------------------------------
+
+Status HashIndexFile::ChainInsert (PageID bucketID, HashBucketPage *bucket, char *entry, int len)
+{
+	HashBucketPage *page = bucket;
+	PageID pageID = bucketID;
+	RecordID entryRid;
+	Status s;
+
+	while (page->AvailableSpace() < len) {
+		PageID nextID = page->GetNextPage();
+		HashBucketPage *next;
+		bool dirty = false;
+
+		if (nextID == INVALID_PAGE) {
+			if (MINIBASE_BM->NewPage(nextID, (Page *&)next) != OK) {
+				cerr << "Unable to allocate new page" << endl;
+				if (page != bucket) {
+					MINIBASE_BM->UnpinPage(pageID, CLEAN);
+				}
+				return FAIL;
+			}
+			next->Init(nextID, bucket->GetLocalDepth());
+			page->SetNextPage(nextID);
+			dirty = true;
+		}
+		else {
+			PIN(nextID, next);
+		}
+
+		if (page != bucket) {
+			UNPIN(pageID, dirty);
+		}
+		page = next;
+		pageID = nextID;
+	}
+
+	s = page->InsertRecord(entry, len, entryRid);
+	if (page != bucket) {
+		UNPIN(pageID, DIRTY);
+	}
+	return s;
+}
+
+
+//-------------------------------------------------------------------
+// HashIndexFile::CanSplit
+//
+// Input   : bucket - the first page of a full bucket, pinned.
+//           hash - the hash of the key being inserted.
+// Output  : canSplit - whether splitting the bucket, as many times as
+//                      the depth allows, could make room.
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : A split helps only if some entry of the chain differs from
+//           hash in the low HASH_MAX_GLOBAL_DEPTH bits.
+//-------------------------------------------------------------------
+
+Status HashIndexFile::CanSplit (HashBucketPage *bucket, unsigned long long hash, bool &canSplit)
+{
+	unsigned long long mask = (1ULL << HASH_MAX_GLOBAL_DEPTH) - 1;
+	HashBucketPage *page = bucket;
+	PageID pageID = INVALID_PAGE;   // set once we have moved past bucket
+
+	canSplit = false;
+	if (bucket->GetLocalDepth() >= HASH_MAX_GLOBAL_DEPTH)
+		return OK;
+
+	while (!canSplit) {
+		RecordID cur;
+		Status s;
+
+		for (s = page->FirstRecord(cur); s == OK && !canSplit; s = page->NextRecord(cur, cur)) {
+			char *entry;
+			int len;
+
+			page->ReturnRecord(cur, entry, len);
+			canSplit = ((GetKeyHash(GetEntryKey(entry, len, LEAF_NODE)) ^ hash) & mask) != 0;
+		}
+
+		PageID nextID = page->GetNextPage();
+		if (pageID != INVALID_PAGE) {
+			UNPIN(pageID, CLEAN);
+		}
+		if (canSplit || nextID == INVALID_PAGE)
+			break;
+
+		pageID = nextID;
+		PIN(pageID, page);
+	}
+
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// HashIndexFile::FreeChain
+//
+// Input   : pageID - the first page of a chain of bucket pages, or
+//                    INVALID_PAGE.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Free the page and all the pages after it.
+//-------------------------------------------------------------------
+
+Status HashIndexFile::FreeChain (PageID pageID)
+{
+	while (pageID != INVALID_PAGE) {
+		HashBucketPage *page;
+
+		PIN(pageID, page);
+		PageID nextID = page->GetNextPage();
+		FREEPAGE(pageID);
+		pageID = nextID;
+	}
+
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// HashIndexFile::FreeDirectory
+//
+// Input   : firstID, numPages - a run of directory pages, none of
+//                               them pinned.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Free the pages of the run.
+//-------------------------------------------------------------------
+
+Status HashIndexFile::FreeDirectory (PageID firstID, int numPages)
+{
+	for (int i = 0; i < numPages; i++) {
+		Page *page;
+
+		if (MINIBASE_BM->PinPage(firstID + i, page, true) != OK) {
+			cerr << "Unable to pin page " << firstID + i << endl;
+			return FAIL;
+		}
+		FREEPAGE(firstID + i);
+	}
+
+	return OK;
+}
@@ -0,0 +1,190 @@
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include "minirel.h"
+#include "bufmgr.h"
+#include "db.h"
+#include "index.h"
+#include "btfile.h"
+#include "hashindex.h"
+
+// Header pages of the indexes looked up or created so far, by name.  An
+// entry is only a hint: it is used once the page it names is found to
+// still carry the name of the index (see HeaderHasName).
+static std::unordered_map<std::string, PageID> indexEntries;
+
+// Where an index keeps its name on its header page: the last MAX_NAME
+// bytes of the page, which no header uses otherwise.
+#define INDEX_NAME_OFFSET   (MAX_SPACE - MAX_NAME)
+
+//-------------------------------------------------------------------
+// OpenIndexFile
+//
+// Input   : filename - filename of an index.
+//           type - the kind of index to open.
+// Output  : status - OK if successful, FAIL otherwise.
+// Purpose : Open, or create, an index of the given type.  Both kinds of
+//           hash index are served by the extendible hash index, which
+//           grows without rehashing the whole file.
+// Return  : The index, to be deleted by the caller, or NULL.
+//-------------------------------------------------------------------
+
+IndexFile *OpenIndexFile (Status &status, const char *filename, IndexType type)
+{
+	IndexFile *index;
+
+	switch (type) {
+	case B_Index:
+		index = new BTreeFile(status, filename);
+		break;
+
+	case SH_Index:
+	case Hash:
+		index = new HashIndexFile(status, filename);
+		break;
+
+	default:
+		status = FAIL;
+		return NULL;
+	}
+
+	if (status != OK) {
+		delete index;
+		return NULL;
+	}
+	return index;
+}
+
+
+//-------------------------------------------------------------------
+// SetHeaderName
+//
+// Input   : headerID - the header page of an index.
+//           filename - the name to give it, or "" to take it away.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Write the name of an index on its header page.
+//-------------------------------------------------------------------
+
+static Status SetHeaderName (PageID headerID, const char *filename)
+{
+	Page *page;
+
+	PIN(headerID, page);
+	strncpy((char *)page + INDEX_NAME_OFFSET, filename, MAX_NAME);
+	UNPIN(headerID, DIRTY);
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// HeaderHasName
+//
+// Input   : headerID - a page of the current database.
+//           filename - filename of an index.
+// Output  : None
+// Return  : true if the page is the header page of that index.
+// Purpose : Check an entry of the table before it is used.  The table
+//           cannot see every change to the file directory: the database
+//           may have been closed and another opened in its place, and
+//           a header page freed since may have been reused.  The page
+//           is about to be pinned by the index anyway, so this costs no
+//           I/O.  An index whose directory entry is deleted through DB
+//           rather than DeleteIndexFileEntry keeps its name until its
+//           header page is reused, so indexes are only destroyed
+//           through their DestroyFile.
+//-------------------------------------------------------------------
+
+static bool HeaderHasName (PageID headerID, const char *filename)
+{
+	Page *page;
+	bool match;
+
+	if (headerID < 0 || headerID >= MINIBASE_DB->GetNumOfPages() ||
+		MINIBASE_BM->PinPage(headerID, page) != OK)
+		return false;
+
+	match = strncmp((char *)page + INDEX_NAME_OFFSET, filename, MAX_NAME) == 0;
+	MINIBASE_BM->UnpinPage(headerID, CLEAN);
+	return match;
+}
+
+//-------------------------------------------------------------------
+// GetIndexFileEntry
+//
+// Input   : filename - filename of an index.
+// Output  : headerID - page number of its header page.
+// Return  : OK if the index exists, FAIL otherwise.
+// Purpose : Find the header page of an index, in the table if it has
+//           been seen before and its header page still carries its
+//           name, and in the file directory otherwise.
+// Note    : Misses are not kept, and creating an index still searches
+//           the directory (DB::AddFileEntry does too, for duplicates).
+//           Heap files and the catalog add and delete entries of the
+//           same directory through DB, which cannot tell the table, so
+//           only DB itself could answer a miss without the search.
+//-------------------------------------------------------------------
+
+Status GetIndexFileEntry (const char *filename, PageID &headerID)
+{
+	std::unordered_map<std::string, PageID>::iterator entry = indexEntries.find(filename);
+
+	if (entry != indexEntries.end()) {
+		if (HeaderHasName(entry->second, filename)) {
+			headerID = entry->second;
+			return OK;
+		}
+		indexEntries.erase(entry);
+	}
+
+	if (MINIBASE_DB->GetFileEntry(filename, headerID) != OK)
+		return FAIL;
+
+	// Indexes created before their header pages carried names are not kept
+	if (HeaderHasName(headerID, filename))
+		indexEntries[filename] = headerID;
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// AddIndexFileEntry
+//
+// Input   : filename - filename of a new index.
+//           headerID - page number of its header page.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Add an index to the file directory, and to the table, and
+//           write its name on its header page.
+//-------------------------------------------------------------------
+
+Status AddIndexFileEntry (const char *filename, PageID headerID)
+{
+	if (MINIBASE_DB->AddFileEntry(filename, headerID) != OK)
+		return FAIL;
+
+	if (SetHeaderName(headerID, filename) != OK)
+		return FAIL;
+
+	indexEntries[filename] = headerID;
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// DeleteIndexFileEntry
+//
+// Input   : filename - filename of an index.
+//           headerID - page number of its header page, which must not
+//                      be freed yet.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Remove an index from the file directory, and from the
+//           table, and take its name off its header page, so that the
+//           page no longer passes for its header once it is freed.
+//-------------------------------------------------------------------
+
+Status DeleteIndexFileEntry (const char *filename, PageID headerID)
+{
+	indexEntries.erase(filename);
+	if (SetHeaderName(headerID, "") != OK)
+		return FAIL;
+	return MINIBASE_DB->DeleteFileEntry(filename);
+}
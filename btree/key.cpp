@@ -11,15 +11,24 @@
 
 #include "bt.h"
 
+// SSE2 is part of every x86-64 target, and of 32-bit x86 targets built
+// with /arch:SSE2 (MSVC) or -msse2 (gcc).  Elsewhere CountPrefixes falls
+// back to a scalar loop.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define KEY_PREFIX_SSE2
+#endif
+
 
 
 //-------------------------------------------------------------------
 // KeyCmp
 //
-// Input   : key1, key2 - pointer to two key to compare.
-//           t - type of attribute key1 and key2
+// Input   : key1, key2 - the two keys to compare.
 // Output  : None
-// Purpose : Compare the value of two keys
+// Purpose : Compare the value of two keys.  Keys are byte strings:
+//           they are compared with memcmp over the shorter length,
+//           and if that is equal the shorter key sorts first.
 // Return  : 
 //   - key1  < key2 : negative
 //   - key1 == key2 : 0
@@ -27,26 +36,302 @@
 //-------------------------------------------------------------------
 
 
+int KeyCmp(const KeyView &key1, const KeyView &key2)
+{
+	int minLen = key1.length < key2.length ? key1.length : key2.length;
+	int cmp = memcmp(key1.key, key2.key, minLen);
+	
+	if (cmp != 0)
+		return cmp;
+	return key1.length - key2.length;
+}
+
+
+//-------------------------------------------------------------------
+// KeyCmp
+//
+// Input   : key1, key2 - pointer to two null-terminated keys to compare.
+// Output  : None
+// Purpose : Compare two string keys the same way as the KeyView
+//           version does.
+// Return  : Same as above.
+//-------------------------------------------------------------------
+
 int KeyCmp(const char *key1, const char *key2)
 {
-	return strncmp(key1, key2, MAX_KEY_SIZE);
+	return KeyCmp(MakeKeyView(key1), MakeKeyView(key2));
+}
+
+
+//-------------------------------------------------------------------
+// KeyCmp
+//
+// Input   : key1, rid1 - the first (key, record id) pair.
+//           key2, rid2 - the second pair.
+// Output  : None
+// Purpose : Compare two entries in the order they are kept in the
+//           tree: by key, and by record id between equal keys.
+// Return  : Same as above.
+//-------------------------------------------------------------------
+
+int KeyCmp(const KeyView &key1, const RecordID &rid1, 
+           const KeyView &key2, const RecordID &rid2)
+{
+	int cmp = KeyCmp(key1, key2);
+	
+	if (cmp != 0)
+		return cmp;
+	if (rid1 < rid2)
+		return -1;
+	return (rid1 > rid2) ? 1 : 0;
+}
+
+
+//-------------------------------------------------------------------
+// MakeKeyView
+//
+// Input   : key - pointer to a null-terminated key.
+// Output  : None
+// Purpose : Wrap a string key so that it can be passed where a key
+//           with an explicit length is expected.  The terminating
+//           null is not part of the key.
+// Return  : A view of the key.
+//-------------------------------------------------------------------
+
+KeyView MakeKeyView(const char *key)
+{
+	KeyView view;
+	
+	view.key = key;
+	view.length = strlen(key);
+	return view;
+}
+
+
+//-------------------------------------------------------------------
+// GetIndexDataLength
+//
+// Input   : entry - pointer to an index entry as it is stored on a page.
+//           len - length of the entry.
+// Output  : None
+// Purpose : Find how much of an index entry follows its key: the child
+//           page id, and before it the record id of the separator if
+//           the page id is flagged with INDEX_RID_FLAG.
+// Return  : The length of the data of the entry.
+//-------------------------------------------------------------------
+
+static int GetIndexDataLength(const char *entry, int len)
+{
+	PageID pageNo;
+	
+	memcpy(&pageNo, entry + len - sizeof(PageID), sizeof(PageID));
+	if (pageNo & INDEX_RID_FLAG)
+		return sizeof(RecordID) + sizeof(PageID);
+	return sizeof(PageID);
+}
+
+
+//-------------------------------------------------------------------
+// GetEntryKey
+//
+// Input   : entry - pointer to an entry as it is stored on a page.
+//           len - length of the entry.
+//           nodeType - type of the node the entry is in.
+// Output  : None
+// Purpose : Find the key of an entry.  Index and leaf entries are the
+//           key followed by their data, which for an index entry may
+//           or may not include a record id; a posting-list entry is a
+//           byte holding the key length followed by the key.
+// Return  : A view of the key inside entry.
+//-------------------------------------------------------------------
+
+KeyView GetEntryKey(const char *entry, int len, NodeType nodeType)
+{
+	KeyView view;
+	
+	if (nodeType == POSTING_NODE)
+	{
+		view.key = entry + 1;
+		view.length = (unsigned char)entry[0];
+	}
+	else
+	{
+		view.key = entry;
+		if (nodeType == INDEX_NODE)
+			view.length = len - GetIndexDataLength(entry, len);
+		else
+			view.length = len - GetDataLength(nodeType);
+	}
+	return view;
+}
+
+
+//-------------------------------------------------------------------
+// GetEntryRid
+//
+// Input   : entry - pointer to an entry as it is stored on a page.
+//           len - length of the entry.
+//           nodeType - type of the node the entry is in.
+// Output  : None
+// Purpose : Find the record id that orders an entry among the entries
+//           with the same key: the data of a leaf entry, the separator
+//           record id of an index entry.  Posting-list entries all have
+//           distinct keys, so they have none.
+// Return  : The record id, or LOWEST_RID for a posting-list entry and
+//           an index entry that stores no record id.
+//-------------------------------------------------------------------
+
+RecordID GetEntryRid(const char *entry, int len, NodeType nodeType)
+{
+	RecordID rid;
+	
+	switch (nodeType)
+	{
+	case INDEX_NODE:
+		if (GetIndexDataLength(entry, len) == sizeof(PageID))
+			return LOWEST_RID;
+		memcpy(&rid, entry + len - sizeof(PageID) - sizeof(RecordID), sizeof(RecordID));
+		return rid;
+	
+	case LEAF_NODE:
+		memcpy(&rid, entry + len - sizeof(RecordID), sizeof(RecordID));
+		return rid;
+	
+	default:
+		return LOWEST_RID;
+	}
 }
 
+
 //-------------------------------------------------------------------
-// GetKeyLength
+// MakeSeparatorKey
+//
+// Input   : leftKey  - the largest key that must sort below the separator.
+//           rightKey - the smallest key that must sort at or above the
+//                      separator.  leftKey <= rightKey.
+// Output  : separator - shortest key s such that leftKey < s <= rightKey,
+//                       or rightKey itself if the two keys are equal.
+// Purpose : Compute a suffix-truncated separator for an index node.
+// Precond : separator is big enough to hold rightKey.
+// Return  : The length of the separator.
+//-------------------------------------------------------------------
+
+int MakeSeparatorKey(char *separator, const KeyView &leftKey, const KeyView &rightKey)
+{
+	int len = 0;
+
+	while (len < leftKey.length && leftKey.key[len] == rightKey.key[len])
+		len++;
+
+	// The keys first differ at position len, so the prefix of rightKey
+	// up to and including that byte is already greater than leftKey.
+	if (len < rightKey.length)
+		len++;
+
+	memcpy(separator, rightKey.key, len);
+	return len;
+}
+
+
+//-------------------------------------------------------------------
+// GetKeyPrefix
+//
+// Input   : key - key we are interested in.
+// Output  : None
+// Purpose : Pack the leading bytes of key into an order-preserving
+//           integer.  Bytes past the end of the key count as zero, so
+//           a key and the same key followed by zero bytes can share a
+//           prefix; KeyCmp then tells them apart by length.
+// Return  : The prefix of the key.
+//-------------------------------------------------------------------
+
+KeyPrefix GetKeyPrefix(const KeyView &key)
+{
+	KeyPrefix prefix = 0;
+	int i;
+	
+	for (i = 0; i < KEY_PREFIX_SIZE && i < key.length; i++)
+		prefix = (prefix << 8) | (unsigned char)key.key[i];
+	
+	for (; i < KEY_PREFIX_SIZE; i++)
+		prefix <<= 8;
+	
+	return prefix;
+}
+
+
+//-------------------------------------------------------------------
+// CountPrefixes
+//
+// Input   : prefixes - array of n key prefixes.
+//           probe    - prefix to compare them against.
+// Output  : below - number of prefixes less than probe.
+//           equal - number of prefixes equal to probe.
+// Purpose : Compare probe against a run of prefixes without branching
+//           on each comparison.  Since the prefixes come from sorted
+//           keys, the first *below of them are less than probe and the
+//           *equal after those are the ones that need a full compare.
+//-------------------------------------------------------------------
+
+void CountPrefixes(const KeyPrefix *prefixes, int n, KeyPrefix probe, 
+				   int *below, int *equal)
+{
+	int i = 0;
+	int numBelow = 0;
+	int numEqual = 0;
+
+#ifdef KEY_PREFIX_SSE2
+	// SSE2 only has signed 32-bit compares, so flip the sign bit of both
+	// sides to compare them as unsigned.  Each movemask yields one bit
+	// per lane, which the table turns into a count.
+	static const int bitCount[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+	const __m128i bias = _mm_set1_epi32((int)0x80000000);
+	const __m128i p = _mm_xor_si128(_mm_set1_epi32((int)probe), bias);
+	
+	for (; i + 4 <= n; i += 4) 
+	{
+		__m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(prefixes + i)), bias);
+		numBelow += bitCount[_mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(v, p)))];
+		numEqual += bitCount[_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, p)))];
+	}
+#endif
+
+	for (; i < n; i++) 
+	{
+		numBelow += (prefixes[i] < probe);
+		numEqual += (prefixes[i] == probe);
+	}
+	
+	*below = numBelow;
+	*equal = numEqual;
+}
+
+
+//-------------------------------------------------------------------
+// GetKeyHash
 //
 // Input   : key - key we are interested in.
 // Output  : None
-// Purpose : Return the size of key
-// Return  : The size of the key.
+// Purpose : Hash the bytes of a key with 64-bit FNV-1a, followed by a
+//           final mix so that every bit of the result depends on every
+//           byte of the key and any slice of it can be used as a hash.
+// Return  : The hash of the key.
 //-------------------------------------------------------------------
 
-int GetKeyLength(const char *key)
+unsigned long long GetKeyHash(const KeyView &key)
 {
-	int len;
+	unsigned long long h = 14695981039346656037ULL;
 	
-	len = strlen((char *) key); 
-	return len+1;
+	for (int i = 0; i < key.length; i++)
+	{
+		h ^= (unsigned char)key.key[i];
+		h *= 1099511628211ULL;
+	}
+	
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	return h;
 }
 
 
@@ -60,18 +345,53 @@ int GetKeyLength(const char *key)
 // Return  : The size of the key and data.
 //-------------------------------------------------------------------
 
-int GetKeyDataLength(const char *key, const NodeType nodeType)
+int GetKeyDataLength(const KeyView &key, const NodeType nodeType)
 {
-	int keylen = GetKeyLength (key);
+	return key.length + GetDataLength (nodeType);
+}
+
+
+//-------------------------------------------------------------------
+// GetKeyDataLength
+//
+// Input   : key - key of a separator.
+//           keyRid - record id of the separator.
+// Output  : None
+// Purpose : Return the size of an index entry for the separator, which
+//           only stores keyRid if it is not LOWEST_RID.
+// Return  : The size of the index entry.
+//-------------------------------------------------------------------
 
+int GetKeyDataLength(const KeyView &key, const RecordID &keyRid)
+{
+	if (keyRid == LOWEST_RID)
+		return key.length + sizeof(PageID);
+	return key.length + sizeof(RecordID) + sizeof(PageID);
+}
+
+
+//-------------------------------------------------------------------
+// GetDataLength
+//
+// Input   : nodeType - the type of the node (INDEX or LEAF)
+// Output  : None
+// Purpose : Return the size of the data part of an entry.  For an
+//           index entry that is the page id alone; an entry that also
+//           stores the record id of its separator is longer (see the
+//           GetKeyDataLength that takes a record id).
+// Return  : The size of the data.
+//-------------------------------------------------------------------
+
+int GetDataLength(const NodeType nodeType)
+{
 	switch(nodeType) 
 	{
 	
 	case INDEX_NODE:
-		return keylen + sizeof(PageID);
+		return sizeof(PageID);
 	
 	case LEAF_NODE:
-		return keylen + sizeof(RecordID);
+		return sizeof(RecordID);
 	
 	default:  // sanity check
 		assert(0);
@@ -86,22 +406,22 @@ int GetKeyDataLength(const char *key, const NodeType nodeType)
 // FillEntryKey
 //
 // Write the key part of a (key, data) pair.  Set keyLen to the length
-// of the key.
+// of the key.  No terminator is stored: the length of the key is
+// whatever is left of the entry once the data is taken off the end.
 //
-// Assume for key of type string, there is enough space.
+// Keys are kept one byte short of MAX_KEY_SIZE so that a copy of any
+// key, null-terminated, still fits in a KeyType.
 //-------------------------------------------------------------------
 
-static void FillEntryKey(KeyType *target, const char *key, 
+static void FillEntryKey(KeyType *target, const KeyView &key, 
                          int *keyLen)
 {
-	char *p = (char *) target;
-	int len = strlen((char *)key)+1;
-	if (len >= MAX_KEY_SIZE) {
-		cerr<<"error: string key length exceeds maximum"<<endl;
+	if (key.length >= MAX_KEY_SIZE) {
+		cerr<<"error: key length exceeds maximum"<<endl;
 		exit(1);
 	}
-	strcpy(p, (char *) key);
-	*keyLen = len;
+	memcpy((char *) target, key.key, key.length);
+	*keyLen = key.length;
 	return;
 }
 
@@ -156,7 +476,7 @@ static void FillEntryData(char *target, DataType source, NodeType nodeType,
 
 
 void MakeEntry (KeyDataEntry *target,
-                const char *key,
+                const KeyView &key,
                 NodeType nodeType, DataType data,
                 int *len)
 {
@@ -175,6 +495,41 @@ void MakeEntry (KeyDataEntry *target,
 }
 
 
+//-------------------------------------------------------------------
+// MakeEntry
+//
+// Input   : target   - pointer to a location in mem where entry is to 
+//                      be created.
+//           key      - the key of the separator.
+//           keyRid   - the record id of the separator.
+//           pageNo   - the child page the entry points to.
+// Output  : len      - length of the entry created.
+// Purpose : Create an index entry (key, keyRid, pageNo) in location
+//           target.  keyRid is left out if it is LOWEST_RID; if not,
+//           the stored page id is flagged with INDEX_RID_FLAG.
+// Precond : target is big enough to hold the created entry.
+//-------------------------------------------------------------------
+
+void MakeEntry (KeyDataEntry *target,
+                const KeyView &key, const RecordID &keyRid,
+                PageID pageNo, int *len)
+{
+	DataType data;
+	char *c;
+	
+	data.pid = pageNo;
+	MakeEntry(target, key, INDEX_NODE, data, len);
+	if (keyRid == LOWEST_RID)
+		return;
+	
+	c = (char *)target + key.length;
+	data.pid = pageNo | INDEX_RID_FLAG;
+	memcpy(c, &keyRid, sizeof(RecordID));
+	memcpy(c + sizeof(RecordID), &data.pid, sizeof(PageID));
+	*len += sizeof(RecordID);
+}
+
+
 //-------------------------------------------------------------------
 // GetKeyData
 //
@@ -187,34 +542,27 @@ void MakeEntry (KeyDataEntry *target,
 //           len      - length (num of bytes) of the (key, data) pair.
 //           nodeType - type of the B+-tree node where the entry is in.
 // Output  : None
-// Purpose : Extract the key and data from an (key, data) pair.
+// Purpose : Extract the key and data from an (key, data) pair.  The
+//           copied key is followed by a null so that string keys can
+//           be used as such; binary keys should be read through a
+//           KeyView, which carries the length.  The data of an index
+//           entry is its page id, without INDEX_RID_FLAG; its record
+//           id is read with GetEntryRid.
 //-------------------------------------------------------------------
 
 void GetKeyData (char *key, DataType *data, KeyDataEntry *pair, int len, NodeType nodeType)
 {
-	int dataLen;
-	int keyLen;
-	
-	switch(nodeType) 
-	{
-	
-	case INDEX_NODE:
-		dataLen = sizeof(PageID);
-		break;
-	
-	case LEAF_NODE:
-		dataLen = sizeof(RecordID);
-		break;
-	
-	default:
-		assert(0);
-	}
-	
-	keyLen = len - dataLen;
+	int keyLen = GetEntryKey((char *)pair, len, nodeType).length;
+	int dataLen = (nodeType == INDEX_NODE) ? sizeof(PageID) : sizeof(RecordID);
 
-	if (key)
+	if (key) {
 		memcpy(key, pair, keyLen);
+		key[keyLen] = '\0';
+	}
 
-	if (data)
-		memcpy(data, ((char*)pair) + keyLen, dataLen);
+	if (data) {
+		memcpy(data, ((char*)pair) + len - dataLen, dataLen);
+		if (nodeType == INDEX_NODE)
+			data->pid &= ~INDEX_RID_FLAG;
+	}
 }
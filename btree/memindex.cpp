@@ -0,0 +1,839 @@
+#include <string.h>
+#include "memindex.h"
+#include "btfile.h"
+#include "btfilescan.h"
+
+
+//-------------------------------------------------------------------
+// Helpers for the keys of MemNodes.
+//-------------------------------------------------------------------
+
+static KeyView KeyOf(const MemKey *key)
+{
+	KeyView view;
+
+	view.key = key->bytes;
+	view.length = key->length;
+	return view;
+}
+
+static MemKey *CopyKey(const KeyView &key)
+{
+	MemKey *copy = (MemKey *) new char[sizeof(MemKey) + key.length];
+
+	copy->length = key.length;
+	memcpy(copy->bytes, key.key, key.length);
+	return copy;
+}
+
+static void DeleteKey(MemKey *key)
+{
+	delete [] (char *) key;
+}
+
+
+//-------------------------------------------------------------------
+// NodeLowerBound / NodeUpperBound
+//
+// The number of entries of node below (key, rid), or at or below it.
+// The prefixes settle most entries; only those whose prefix equals
+// the key's are compared in full.
+//-------------------------------------------------------------------
+
+static int NodeLowerBound(const MemNode *node, const KeyView &key, const RecordID &rid)
+{
+	int below, equal;
+
+	CountPrefixes(node->prefixes, node->numKeys, GetKeyPrefix(key), &below, &equal);
+	while (equal > 0 && KeyCmp(KeyOf(node->keys[below]), node->rids[below], key, rid) < 0) {
+		below++;
+		equal--;
+	}
+	return below;
+}
+
+static int NodeUpperBound(const MemNode *node, const KeyView &key, const RecordID &rid)
+{
+	int below, equal;
+
+	CountPrefixes(node->prefixes, node->numKeys, GetKeyPrefix(key), &below, &equal);
+	while (equal > 0 && KeyCmp(KeyOf(node->keys[below]), node->rids[below], key, rid) <= 0) {
+		below++;
+		equal--;
+	}
+	return below;
+}
+
+
+//-------------------------------------------------------------------
+// IsSameEntry
+//
+// Whether entries slot and slot + 1 of a leaf are identical.
+//-------------------------------------------------------------------
+
+static bool IsSameEntry(const MemNode *node, int slot)
+{
+	return node->rids[slot] == node->rids[slot + 1] &&
+		KeyCmp(KeyOf(node->keys[slot]), KeyOf(node->keys[slot + 1])) == 0;
+}
+
+
+//-------------------------------------------------------------------
+// FreeTree
+//
+// Free a node, its keys and everything below it.
+//-------------------------------------------------------------------
+
+static void FreeTree(MemNode *node)
+{
+	for (int i = 0; i < node->numKeys; i++)
+		DeleteKey(node->keys[i]);
+	if (!node->isLeaf) {
+		for (int i = 0; i <= node->numKeys; i++)
+			FreeTree(node->children[i]);
+	}
+	delete node;
+}
+
+
+//-------------------------------------------------------------------
+// CountIndexNodes
+//
+// Add up the index nodes at or below node, their separators and the
+// bytes of their keys.
+//-------------------------------------------------------------------
+
+static void CountIndexNodes(const MemNode *node, int &numIndex, int &numSeparators, long &keyBytes)
+{
+	if (node->isLeaf)
+		return;
+
+	numIndex++;
+	numSeparators += node->numKeys;
+	for (int i = 0; i < node->numKeys; i++)
+		keyBytes += node->keys[i]->length;
+	for (int i = 0; i <= node->numKeys; i++)
+		CountIndexNodes(node->children[i], numIndex, numSeparators, keyBytes);
+}
+
+
+//-------------------------------------------------------------------
+// MemIndexFile::MemIndexFile
+//
+// Input   : None
+// Output  : None
+// Purpose : Create an empty index.
+//-------------------------------------------------------------------
+
+MemIndexFile::MemIndexFile ()
+{
+	root = NewNode(true);
+	height = 1;
+}
+
+
+//-------------------------------------------------------------------
+// MemIndexFile::~MemIndexFile
+//
+// Input   : None
+// Output  : None
+// Purpose : Free all nodes and keys.
+//-------------------------------------------------------------------
+
+MemIndexFile::~MemIndexFile ()
+{
+	FreeTree(root);
+}
+
+
+//-------------------------------------------------------------------
+// MemIndexFile::Clear
+//
+// Input   : None
+// Output  : None
+// Purpose : Delete all entries.
+//-------------------------------------------------------------------
+
+void MemIndexFile::Clear ()
+{
+	FreeTree(root);
+	root = NewNode(true);
+	height = 1;
+}
+
+
+//-------------------------------------------------------------------
+// MemIndexFile::Insert
+//
+// Input   : key - pointer to the value of the key to be inserted.
+//           rid - RecordID of the record to be inserted.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Insert an index entry with this rid and key.
+//-------------------------------------------------------------------
+
+Status MemIndexFile::Insert (const char *key, const RecordID rid)
+{
+	return Insert(MakeKeyView(key), rid);
+}
+
+
+//-------------------------------------------------------------------
+// MemIndexFile::Insert
+//
+// Input   : key - the key to be inserted, which may be any sequence
+//                 of bytes.
+//           rid - RecordID of the record to be inserted.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Insert the entry after any equal ones on its leaf.  A full
+//           node is split and its separator inserted into its parent,
+//           up to the root, which gets a new root above it if it
+//           splits too.
+//-------------------------------------------------------------------
+
+Status MemIndexFile::Insert (const KeyView &key, const RecordID rid)
+{
+	MemNode *path[MAX_TREE_HEIGHT];
+	int pathSlots[MAX_TREE_HEIGHT];
+	MemNode *node;
+	int level = height - 1;
+	int pos;
+	MemKey *entryKey;
+	RecordID entryRid = rid;
+	MemNode *entryChild = NULL;
+
+	if (key.length >= MAX_KEY_SIZE)
+		return FAIL;
+
+	node = FindLeaf(key, rid, false, path, pathSlots);
+	pos = NodeUpperBound(node, key, rid);
+
+	// Splits that reach the root add a level, so refuse the entry before
+	// anything is split if every node on the path is full and the tree is
+	// already as high as it may be
+	if (height == MAX_TREE_HEIGHT && node->numKeys == MEM_NODE_FANOUT) {
+		int full = level - 1;
+
+		while (full >= 0 && path[full]->numKeys == MEM_NODE_FANOUT)
+			full--;
+		if (full < 0) {
+			cerr << "Tree is too high in MemIndexFile::Insert" << endl;
+			return FAIL;
+		}
+	}
+
+	entryKey = CopyKey(key);
+
+	while (node->numKeys == MEM_NODE_FANOUT) {
+		MemKey *separator;
+		RecordID separatorRid;
+		MemNode *right = Split(node, separator, separatorRid);
+
+		// Insert into the half that pos falls in.  An index node gave
+		// its middle separator up to the parent.
+		if (pos > node->numKeys)
+			InsertAt(right, pos - node->numKeys - (node->isLeaf ? 0 : 1), entryKey, entryRid, entryChild);
+		else
+			InsertAt(node, pos, entryKey, entryRid, entryChild);
+
+		entryKey = separator;
+		entryRid = separatorRid;
+		entryChild = right;
+
+		if (level == 0) {
+			root = NewNode(false);
+			root->children[0] = node;
+			InsertAt(root, 0, entryKey, entryRid, entryChild);
+			height++;
+			return OK;
+		}
+
+		level--;
+		node = path[level];
+		pos = pathSlots[level];
+	}
+
+	InsertAt(node, pos, entryKey, entryRid, entryChild);
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// MemIndexFile::Delete
+//
+// Input   : key - pointer to the value of the key to be deleted.
+//           rid - RecordID of the record to be deleted.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Delete an entry with this rid and key.
+//-------------------------------------------------------------------
+
+Status MemIndexFile::Delete (const char *key, const RecordID rid)
+{
+	return Delete(MakeKeyView(key), rid);
+}
+
+
+//-------------------------------------------------------------------
+// MemIndexFile::Delete
+//
+// Input   : key - the key to be deleted.
+//           rid - RecordID of the record to be deleted.
+// Output  : None
+// Return  : OK if successful, FAIL if there is no such entry.
+// Purpose : Delete the entry (key, rid).  A leaf left empty is freed
+//           and taken out of its parent, and so is each index node
+//           above it that is left without children.  A root with a
+//           single child gives its place to that child.
+//-------------------------------------------------------------------
+
+Status MemIndexFile::Delete (const KeyView &key, const RecordID rid)
+{
+	MemNode *path[MAX_TREE_HEIGHT];
+	int pathSlots[MAX_TREE_HEIGHT];
+	MemNode *leaf = FindLeaf(key, rid, true, path, pathSlots);
+	int pos = NodeLowerBound(leaf, key, rid);
+
+	// Identical entries may run over several leaves, with separators
+	// equal to them in between, so the entry may be further right
+	while (pos == leaf->numKeys && NextLeaf(path, pathSlots, leaf))
+		pos = NodeLowerBound(leaf, key, rid);
+
+	if (pos == leaf->numKeys || KeyCmp(KeyOf(leaf->keys[pos]), leaf->rids[pos], key, rid) != 0)
+		return FAIL;
+
+	DeleteKey(leaf->keys[pos]);
+	RemoveAt(leaf, pos, -1);
+
+	if (leaf->numKeys > 0 || leaf == root)
+		return OK;
+
+	if (leaf->prevLeaf != NULL)
+		leaf->prevLeaf->nextLeaf = leaf->nextLeaf;
+	if (leaf->nextLeaf != NULL)
+		leaf->nextLeaf->prevLeaf = leaf->prevLeaf;
+
+	// Take the empty node out of its parent, going up while that leaves
+	// the parent empty too.  The root always has two children or more,
+	// so this stops below it.
+	MemNode *child = leaf;
+	for (int level = height - 2; level >= 0; level--) {
+		MemNode *parent = path[level];
+		int childPos = pathSlots[level];
+
+		FreeNode(child);
+		if (parent->numKeys > 0) {
+			int keyPos = (childPos > 0) ? childPos - 1 : 0;
+
+			DeleteKey(parent->keys[keyPos]);
+			RemoveAt(parent, keyPos, childPos);
+			break;
+		}
+		child = parent;
+	}
+
+	while (!root->isLeaf && root->numKeys == 0) {
+		MemNode *oldRoot = root;
+
+		root = root->children[0];
+		FreeNode(oldRoot);
+		height--;
+	}
+
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// MemIndexFile::Lookup
+//
+// Input   : key - pointer to the key to look up.
+//           rids - buffer for the record ids found.
+//           maxRids - number of record ids rids can hold.
+// Output  : numRids - number of record ids written to rids.
+// Return  : OK if every entry with key was returned, DONE if rids
+//           filled up first.
+// Purpose : Find all entries with key.
+//-------------------------------------------------------------------
+
+Status MemIndexFile::Lookup (const char *key, RecordID *rids, int maxRids, int &numRids)
+{
+	return Lookup(MakeKeyView(key), rids, maxRids, numRids);
+}
+
+
+//-------------------------------------------------------------------
+// MemIndexFile::Lookup
+//
+// Input   : key - the key to look up, which may be any sequence of
+//                 bytes.
+//           rids, maxRids - as above.
+// Output  : numRids - as above.
+// Return  : As above.
+// Purpose : Find all entries with key, in record id order.
+//-------------------------------------------------------------------
+
+Status MemIndexFile::Lookup (const KeyView &key, RecordID *rids, int maxRids, int &numRids)
+{
+	MemNode *leaf = FindLeaf(key, LOWEST_RID, false, NULL, NULL);
+	int slot = NodeLowerBound(leaf, key, LOWEST_RID);
+
+	numRids = 0;
+
+	while (leaf != NULL) {
+		for (; slot < leaf->numKeys; slot++) {
+			if (KeyCmp(KeyOf(leaf->keys[slot]), key) != 0)
+				return OK;
+			if (numRids == maxRids)
+				return DONE;
+			rids[numRids++] = leaf->rids[slot];
+		}
+		leaf = leaf->nextLeaf;
+		slot = 0;
+	}
+
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// MemIndexFile::OpenScan
+//
+// Input   : lowKey, highKey - pointers to the bounds of the scan,
+//                             NULL for an open end.
+// Output  : None
+// Return  : A scan of the entries with keys between the bounds, both
+//           included, in order.
+// Purpose : Open a scan.  The index must not change while the scan
+//           is open.
+//-------------------------------------------------------------------
+
+IndexFileScan *MemIndexFile::OpenScan (const char *lowKey, const char *highKey)
+{
+	KeyView low, high;
+
+	if (lowKey != NULL)
+		low = MakeKeyView(lowKey);
+	if (highKey != NULL)
+		high = MakeKeyView(highKey);
+
+	return OpenScan(lowKey ? &low : NULL, highKey ? &high : NULL);
+}
+
+
+//-------------------------------------------------------------------
+// MemIndexFile::OpenScan
+//
+// Input   : lowKey, highKey - the bounds of the scan, NULL for an open
+//                             end.
+// Output  : None
+// Return  : As above.
+// Purpose : As above, for keys that may be any sequence of bytes.
+//-------------------------------------------------------------------
+
+IndexFileScan *MemIndexFile::OpenScan (const KeyView *lowKey, const KeyView *highKey)
+{
+	MemIndexFileScan *scan = new MemIndexFileScan();
+
+	if (lowKey != NULL) {
+		scan->leaf = FindLeaf(*lowKey, LOWEST_RID, false, NULL, NULL);
+		scan->slot = NodeLowerBound(scan->leaf, *lowKey, LOWEST_RID);
+	}
+	else {
+		scan->leaf = root;
+		while (!scan->leaf->isLeaf)
+			scan->leaf = scan->leaf->children[0];
+		scan->slot = 0;
+	}
+
+	scan->hasHighKey = (highKey != NULL);
+	if (highKey != NULL) {
+		memcpy(scan->highKeyData, highKey->key, highKey->length);
+		scan->highKeyView.key = scan->highKeyData;
+		scan->highKeyView.length = highKey->length;
+	}
+
+	return scan;
+}
+
+
+//-------------------------------------------------------------------
+// MemIndexFile::Checkpoint
+//
+// Input   : file - an empty BTreeFile.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Copy every entry into file, in order.
+//-------------------------------------------------------------------
+
+Status MemIndexFile::Checkpoint (BTreeFile *file)
+{
+	MemNode *leaf = root;
+
+	while (!leaf->isLeaf)
+		leaf = leaf->children[0];
+
+	for (; leaf != NULL; leaf = leaf->nextLeaf) {
+		for (int i = 0; i < leaf->numKeys; i++) {
+			if (file->Insert(KeyOf(leaf->keys[i]), leaf->rids[i]) != OK)
+				return FAIL;
+		}
+	}
+
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// MemIndexFile::Restore
+//
+// Input   : file - a BTreeFile, such as one written by Checkpoint.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Replace the entries of the index with those of file.
+//-------------------------------------------------------------------
+
+Status MemIndexFile::Restore (BTreeFile *file)
+{
+	BTreeFileScan *scan = (BTreeFileScan *) file->OpenScan();
+	KeyType keyData;
+	KeyView key;
+	RecordID rid;
+	Status s;
+
+	if (scan == NULL)
+		return FAIL;
+
+	Clear();
+
+	key.key = keyData;
+	while ((s = scan->GetNext(rid, keyData, key.length)) == OK) {
+		if (Insert(key, rid) != OK) {
+			s = FAIL;
+			break;
+		}
+	}
+
+	delete scan;
+	return (s == DONE) ? OK : FAIL;
+}
+
+
+//-------------------------------------------------------------------
+// MemIndexFile::DumpStatistics
+//
+// Input   : None
+// Output  : None
+// Return  : OK
+// Purpose : Print the size and fill of the tree, as
+//           BTreeFile::DumpStatistics does, and the memory it takes.
+//-------------------------------------------------------------------
+
+Status MemIndexFile::DumpStatistics ()
+{
+	ostream& os = std::cout;
+	int numLeaves = 0, numIndex = 0, numData = 0, numSeparators = 0;
+	long keyBytes = 0;
+	MemNode *first = root;
+
+	CountIndexNodes(root, numIndex, numSeparators, keyBytes);
+	while (!first->isLeaf)
+		first = first->children[0];
+
+	for (MemNode *leaf = first; leaf != NULL; leaf = leaf->nextLeaf) {
+		numLeaves++;
+		numData += leaf->numKeys;
+		for (int i = 0; i < leaf->numKeys; i++)
+			keyBytes += leaf->keys[i]->length;
+	}
+
+	os << "\n------------ Now dumping statistics of current in-memory B+ Tree!---------------" << endl;
+	os << "  Total nodes are        : " << numLeaves + numIndex << " ( " << numLeaves << " Data";
+	os << "  , " << numIndex << " index nodes )" << endl;
+	os << "  Total data entries are : " << numData << endl;
+	os << "  Total index entries are: " << numSeparators << endl;
+	os << "  Hight of the tree is   : " << height << endl;
+	os << "  Average fill factors for leaf is : " << (numLeaves ? (float)numData / (numLeaves * MEM_NODE_FANOUT) : 0) << endl;
+	os << "  Average fill factors for index is : " << (numIndex ? (float)numSeparators / (numIndex * MEM_NODE_FANOUT) : 0) << endl;
+	os << "  Memory used, in bytes  : " << (long)(numLeaves + numIndex) * sizeof(MemNode) + keyBytes << endl;
+	os << "  That's the end of dumping statistics." << endl;
+
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// MemIndexFile::NewNode
+//
+// Input   : isLeaf - whether the node is a leaf.
+// Output  : None
+// Return  : A new, empty node.
+//-------------------------------------------------------------------
+
+MemNode *MemIndexFile::NewNode (bool isLeaf)
+{
+	MemNode *node = new MemNode;
+
+	node->numKeys = 0;
+	node->isLeaf = isLeaf;
+	node->prevLeaf = NULL;
+	node->nextLeaf = NULL;
+	return node;
+}
+
+
+//-------------------------------------------------------------------
+// MemIndexFile::FreeNode
+//
+// Input   : node - a node whose keys and children have been taken
+//                  care of.
+// Output  : None
+// Purpose : Free the node itself.
+//-------------------------------------------------------------------
+
+void MemIndexFile::FreeNode (MemNode *node)
+{
+	delete node;
+}
+
+
+//-------------------------------------------------------------------
+// MemIndexFile::FindLeaf
+//
+// Input   : key, rid - the entry to look for.
+//           leftmost - whether to stop left of separators equal to
+//                      (key, rid) rather than right of them.
+// Output  : path - if not NULL, the index nodes from the root down,
+//                  height - 1 of them.
+//           pathSlots - if not NULL, the child followed from each.
+// Return  : The leaf that (key, rid) is inserted on.  With leftmost,
+//           the first leaf that may hold an entry identical to it.
+//-------------------------------------------------------------------
+
+MemNode *MemIndexFile::FindLeaf (const KeyView &key, const RecordID &rid, bool leftmost, MemNode **path, int *pathSlots)
+{
+	MemNode *node = root;
+	int level = 0;
+
+	while (!node->isLeaf) {
+		int slot = leftmost ? NodeLowerBound(node, key, rid) : NodeUpperBound(node, key, rid);
+
+		if (path != NULL) {
+			path[level] = node;
+			pathSlots[level] = slot;
+		}
+		level++;
+		node = node->children[slot];
+	}
+
+	return node;
+}
+
+
+//-------------------------------------------------------------------
+// MemIndexFile::NextLeaf
+//
+// Input   : path, pathSlots - the path to a leaf, from FindLeaf.
+// Output  : path, pathSlots - the path to the next leaf.
+//           leaf - the next leaf.
+// Return  : false if there is no next leaf.
+//-------------------------------------------------------------------
+
+bool MemIndexFile::NextLeaf (MemNode **path, int *pathSlots, MemNode *&leaf)
+{
+	int level = height - 2;
+	MemNode *node;
+
+	while (level >= 0 && pathSlots[level] == path[level]->numKeys)
+		level--;
+	if (level < 0)
+		return false;
+
+	pathSlots[level]++;
+	node = path[level]->children[pathSlots[level]];
+	for (level++; level < height - 1; level++) {
+		path[level] = node;
+		pathSlots[level] = 0;
+		node = node->children[0];
+	}
+
+	leaf = node;
+	return true;
+}
+
+
+//-------------------------------------------------------------------
+// MemIndexFile::InsertAt
+//
+// Input   : node - a node that is not full.
+//           pos - where the new entry goes.
+//           key, rid - the entry, or separator.  The node takes over
+//                      the key.
+//           child - for an index node, the child to the right of the
+//                   separator.
+// Output  : None
+// Purpose : Make room at pos and put the entry there.
+//-------------------------------------------------------------------
+
+void MemIndexFile::InsertAt (MemNode *node, int pos, MemKey *key, const RecordID &rid, MemNode *child)
+{
+	int n = node->numKeys;
+
+	memmove(&node->prefixes[pos + 1], &node->prefixes[pos], (n - pos) * sizeof(KeyPrefix));
+	memmove(&node->keys[pos + 1], &node->keys[pos], (n - pos) * sizeof(MemKey *));
+	memmove(&node->rids[pos + 1], &node->rids[pos], (n - pos) * sizeof(RecordID));
+	node->prefixes[pos] = GetKeyPrefix(KeyOf(key));
+	node->keys[pos] = key;
+	node->rids[pos] = rid;
+
+	if (!node->isLeaf) {
+		memmove(&node->children[pos + 2], &node->children[pos + 1], (n - pos) * sizeof(MemNode *));
+		node->children[pos + 1] = child;
+	}
+	node->numKeys++;
+}
+
+
+//-------------------------------------------------------------------
+// MemIndexFile::RemoveAt
+//
+// Input   : node - the node to remove from.
+//           pos - the entry to remove, whose key has been freed.
+//           childPos - for an index node, the child to remove along
+//                      with it; -1 for a leaf.
+// Output  : None
+// Purpose : Close the gap left by an entry.
+//-------------------------------------------------------------------
+
+void MemIndexFile::RemoveAt (MemNode *node, int pos, int childPos)
+{
+	int n = node->numKeys;
+
+	memmove(&node->prefixes[pos], &node->prefixes[pos + 1], (n - pos - 1) * sizeof(KeyPrefix));
+	memmove(&node->keys[pos], &node->keys[pos + 1], (n - pos - 1) * sizeof(MemKey *));
+	memmove(&node->rids[pos], &node->rids[pos + 1], (n - pos - 1) * sizeof(RecordID));
+
+	if (childPos >= 0)
+		memmove(&node->children[childPos], &node->children[childPos + 1], (n - childPos) * sizeof(MemNode *));
+	node->numKeys--;
+}
+
+
+//-------------------------------------------------------------------
+// MemIndexFile::Split
+//
+// Input   : node - a full node.
+// Output  : separator, separatorRid - the separator to insert into the
+//                                    parent, to the left of the new
+//                                    node.
+// Return  : The new node, which takes the upper half of the entries.
+// Purpose : Split a node in two.  A leaf keeps identical entries on one
+//           side, so that a search for them always finds them right
+//           of the separator, and the separator is a copy of the first
+//           key moved.  An index node moves its middle separator up.
+//-------------------------------------------------------------------
+
+MemNode *MemIndexFile::Split (MemNode *node, MemKey *&separator, RecordID &separatorRid)
+{
+	MemNode *right = NewNode(node->isLeaf != 0);
+	int n = node->numKeys;
+	int mid = n / 2;
+
+	if (node->isLeaf) {
+		// Look for the split point nearest the middle that does not
+		// fall between two identical entries
+		for (int below = mid, above = mid; below > 0 || above < n; below--, above++) {
+			if (below > 0 && !IsSameEntry(node, below - 1)) {
+				mid = below;
+				break;
+			}
+			if (above < n && !IsSameEntry(node, above - 1)) {
+				mid = above;
+				break;
+			}
+		}
+
+		memcpy(right->prefixes, &node->prefixes[mid], (n - mid) * sizeof(KeyPrefix));
+		memcpy(right->keys, &node->keys[mid], (n - mid) * sizeof(MemKey *));
+		memcpy(right->rids, &node->rids[mid], (n - mid) * sizeof(RecordID));
+		right->numKeys = n - mid;
+		node->numKeys = mid;
+
+		separator = CopyKey(KeyOf(right->keys[0]));
+		separatorRid = right->rids[0];
+
+		right->nextLeaf = node->nextLeaf;
+		right->prevLeaf = node;
+		if (node->nextLeaf != NULL)
+			node->nextLeaf->prevLeaf = right;
+		node->nextLeaf = right;
+	}
+	else {
+		memcpy(right->prefixes, &node->prefixes[mid + 1], (n - mid - 1) * sizeof(KeyPrefix));
+		memcpy(right->keys, &node->keys[mid + 1], (n - mid - 1) * sizeof(MemKey *));
+		memcpy(right->rids, &node->rids[mid + 1], (n - mid - 1) * sizeof(RecordID));
+		memcpy(right->children, &node->children[mid + 1], (n - mid) * sizeof(MemNode *));
+		right->numKeys = n - mid - 1;
+
+		separator = node->keys[mid];
+		separatorRid = node->rids[mid];
+		node->numKeys = mid;
+	}
+
+	return right;
+}
+
+
+//-------------------------------------------------------------------
+// MemIndexFileScan::GetNext
+//
+// Input   : None
+// Output  : rid - record id of the scanned record.
+//           keyptr - its key, null-terminated.
+// Return  : OK if successful, DONE if no more records to read.
+//-------------------------------------------------------------------
+
+Status MemIndexFileScan::GetNext (RecordID &rid, char *keyptr)
+{
+	int keyLen;
+	Status s = GetNext(rid, keyptr, keyLen);
+
+	if (s == OK)
+		keyptr[keyLen] = '\0';
+	return s;
+}
+
+
+//-------------------------------------------------------------------
+// MemIndexFileScan::GetNext
+//
+// Input   : None
+// Output  : rid - record id of the scanned record.
+//           keyptr - the bytes of its key.
+//           keyLen - the length of the key.
+// Return  : OK if successful, DONE if no more records to read.
+//-------------------------------------------------------------------
+
+Status MemIndexFileScan::GetNext (RecordID &rid, char *keyptr, int &keyLen)
+{
+	while (leaf != NULL && slot >= leaf->numKeys) {
+		leaf = leaf->nextLeaf;
+		slot = 0;
+	}
+	if (leaf == NULL)
+		return DONE;
+
+	KeyView key = KeyOf(leaf->keys[slot]);
+
+	if (hasHighKey && KeyCmp(key, highKeyView) > 0) {
+		leaf = NULL;
+		return DONE;
+	}
+
+	memcpy(keyptr, key.key, key.length);
+	keyLen = key.length;
+	rid = leaf->rids[slot];
+	slot++;
+	return OK;
+}
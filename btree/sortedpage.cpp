@@ -4,6 +4,7 @@
 * Johannes Gehrke & Gideon Glass  951016  CS564  UW-Madison
 */
 
+#include <string.h>
 #include "sortedpage.h"
 #include "btindex.h"
 #include "btleaf.h"
@@ -27,6 +28,7 @@ Status SortedPage::InsertRecord (char * recPtr,
 {
 	Status status;
 	int i;
+	Slot newSlot;
 	
 	// ASSERTIONS:
 	// - the slot directory is compressed -> inserts will occur at the end
@@ -35,38 +37,22 @@ Status SortedPage::InsertRecord (char * recPtr,
 	// general plan:
 	//    1. Insert the record into the page,
 	//       which is then not necessarily any more sorted
-	//    2. Sort the page by rearranging the slots (insertion sort)
+	//    2. Binary search the sorted slots before it for its position
+	//       by (key, record id) and shift the slots above it up one
 	
 	status = HeapPage::InsertRecord (recPtr, recLen, rid);
 	if (status != OK)
 		return FAIL;
 	
-	// performs a simple insertion sort
-
-	for (i = numOfSlots - 1; i > 0; i--) 
-	{
-		char *x = data + slots[i].offset;
-		char *y = data + slots[i-1].offset;
-		
-		if (KeyCmp((char*)x, (char*)y) < 0)
-		{
-			// switch slots
-
-			Slot tmpSlot;
-			tmpSlot   = slots[i];
-			slots[i]   = slots[i-1];
-			slots[i-1] = tmpSlot;
-			
-		} else {
-			
-			// end insertion sort
-
-			break;
-		}
-	}
+	newSlot = slots[numOfSlots - 1];
+	i = SearchSlots(GetEntryKey(recPtr, recLen, (NodeType)type), 
+		GetEntryRid(recPtr, recLen, (NodeType)type), numOfSlots - 1, true);
+	
+	memmove(&slots[i + 1], &slots[i], (numOfSlots - 1 - i) * sizeof(Slot));
+	slots[i] = newSlot;
 	
 	// ASSERTIONS:
-	// - record keys increase with increasing slot number (starting at slot 0)
+	// - record (key, rid) pairs increase with increasing slot number (starting at slot 0)
 	// - slot directory compacted
 	
 	rid.slotNo = i;
@@ -102,3 +88,120 @@ Status SortedPage::DeleteRecord (const RecordID& rid)
 	return OK;
 }
 
+
+//-------------------------------------------------------------------
+// SortedPage::Prefetch
+//
+// Input   : None
+// Output  : None
+// Purpose : Start loading the whole page into the CPU cache, so that
+//           a search of it a little later does not stall on each slot
+//           and key it reads.  The page must be pinned.
+//-------------------------------------------------------------------
+
+void SortedPage::Prefetch ()
+{
+	for (int offset = 0; offset < MAX_SPACE; offset += CACHE_LINE_SIZE)
+		PREFETCH((char *)this + offset);
+}
+
+
+//-------------------------------------------------------------------
+// SortedPage::GetKeyView
+//
+// Input   : slotNo - slot number of the entry whose key we want.
+// Output  : None
+// Purpose : Return the key of an entry in place, without copying it
+//           out of the page.
+// Return  : A view of the key, valid while this page stays pinned.
+//-------------------------------------------------------------------
+
+KeyView SortedPage::GetKeyView (int slotNo)
+{
+	return GetEntryKey(data + slots[slotNo].offset, slots[slotNo].length, (NodeType)type);
+}
+
+
+//-------------------------------------------------------------------
+// SortedPage::GetKeyRid
+//
+// Input   : slotNo - slot number of the entry.
+// Output  : None
+// Purpose : Return the record id that orders the entry among those
+//           with the same key (see GetEntryRid).
+// Return  : The record id.
+//-------------------------------------------------------------------
+
+RecordID SortedPage::GetKeyRid (int slotNo)
+{
+	return GetEntryRid(data + slots[slotNo].offset, slots[slotNo].length, (NodeType)type);
+}
+
+
+//-------------------------------------------------------------------
+// SortedPage::LowerBound
+//
+// Input   : key - the key to search for.
+//           rid - the record id to search for; by default, one below
+//                 every record id, so that only the key counts.
+// Output  : None
+// Purpose : Binary search the page for the first entry whose (key,
+//           record id) is greater than or equal to (key, rid).
+// Return  : The slot number of that entry, or the number of records
+//           on the page if there is none.
+//-------------------------------------------------------------------
+
+int SortedPage::LowerBound (const KeyView &key, const RecordID &rid)
+{
+	return SearchSlots(key, rid, numOfSlots, false);
+}
+
+
+//-------------------------------------------------------------------
+// SortedPage::UpperBound
+//
+// Input   : key - the key to search for.
+//           rid - the record id to search for, as above.
+// Output  : None
+// Purpose : Binary search the page for the first entry whose (key,
+//           record id) is strictly greater than (key, rid).
+// Return  : The slot number of that entry, or the number of records
+//           on the page if there is none.
+//-------------------------------------------------------------------
+
+int SortedPage::UpperBound (const KeyView &key, const RecordID &rid)
+{
+	return SearchSlots(key, rid, numOfSlots, true);
+}
+
+
+//-------------------------------------------------------------------
+// SortedPage::SearchSlots
+//
+// Input   : key, rid - the entry to search for.
+//           count - number of slots, starting at slot 0, to search.
+//           upper - true to skip over entries equal to (key, rid).
+// Output  : None
+// Purpose : Binary search shared by LowerBound and UpperBound.  Each
+//           probe compares the keys in place on the page.
+// Return  : The slot number found.
+//-------------------------------------------------------------------
+
+int SortedPage::SearchSlots (const KeyView &key, const RecordID &rid, int count, bool upper)
+{
+	int low = 0;
+	int high = count;
+	
+	while (low < high)
+	{
+		int mid = (low + high) / 2;
+		int cmp = KeyCmp(key, rid, GetKeyView(mid), GetKeyRid(mid));
+		
+		if (cmp > 0 || (upper && cmp == 0))
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	
+	return low;
+}
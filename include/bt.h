@@ -39,7 +39,8 @@
 typedef enum 
 {
 	INDEX_NODE,
-	LEAF_NODE		
+	LEAF_NODE,
+	POSTING_NODE	// leaf holding one posting list per key (see btposting.h)
 } NodeType;
 
 
@@ -58,7 +59,7 @@ typedef enum
 
 #define MAX_KEY_SIZE        220
 
-//#define ATTR_INT  attrInteger
+#define ATTR_INT  attrInteger
 #define ATTR_STRING attrString
 //#define ATTR_FOO	attrFoo
 /*
@@ -102,21 +103,90 @@ union DataType
 struct KeyDataEntry
 {
 	KeyType    key;
+	RecordID   keyRid;   // room for the record id of an index entry
 	DataType   data;
 };
 
+/*
+* struct KeyView:
+*
+* A key together with its length.  Keys are arbitrary byte strings and
+* are stored on pages without a terminator, so every key the BT*Page code
+* handles is passed around as a view: either in place on a page (valid
+* only while that page stays pinned) or over a caller's buffer.  String
+* keys are wrapped with make_key_view, which leaves the null out.
+*/
+
+struct KeyView
+{
+	const char *key;
+	int         length;
+};
+
+/*
+* KeyPrefix: the first KEY_PREFIX_SIZE bytes of a key packed big-endian
+* into an unsigned integer (shorter keys are padded with zero bytes).
+* Comparing the prefixes of two keys as integers orders them exactly as
+* KeyCmp does, unless the prefixes are equal, in which case the keys
+* themselves have to be compared.
+*/
+
+typedef unsigned int KeyPrefix;
+
+/*
+* Entries are ordered by (key, record id), not by key alone, so that
+* every leaf entry has a distinct place in the tree even when many share
+* a key.  A leaf entry's record id is its data.  Separators that do not
+* fall between two equal keys carry LOWEST_RID, (INVALID_PAGE,
+* INVALID_SLOT), which sorts below every real record id, and so do
+* searches by key alone: they find the first entry with the key.
+*
+* Most separators are not inside a run of equal keys, so an index entry
+* stores the record id half of its separator, between the key and the
+* child page id, only when it is not LOWEST_RID.  INDEX_RID_FLAG is then
+* set in the stored page id, which is otherwise never negative.
+*/
+
+const RecordID LOWEST_RID = { -1, -1 };
+
+#define INDEX_RID_FLAG      ((PageID)0x80000000)
+
+/*
+* PREFETCH(addr) asks the CPU to start loading the cache line holding
+* addr, without waiting for it.  Batched lookups use it to overlap the
+* cache misses of several searches (see BTreeFile::MultiGetInterleaved).
+* It is a no-op where the compiler offers no prefetch intrinsic.
+*/
+
+#define CACHE_LINE_SIZE     64
+
+#if defined(__GNUC__)
+#define PREFETCH(addr)      __builtin_prefetch((const void *)(addr))
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <xmmintrin.h>
+#define PREFETCH(addr)      _mm_prefetch((const char *)(addr), _MM_HINT_T0)
+#else
+#define PREFETCH(addr)      ((void)(addr))
+#endif
+
+#define KEY_PREFIX_SIZE     ((int)sizeof(KeyPrefix))
+
 /*
 * Finally, here is the interface to our <key,data> abstraction.
 * 
 * keyCompare simply compares keys (types must be the same); return 
-* value is < 0, 0, or > 0.
+* value is < 0, 0, or > 0.  Keys compare bytewise with memcmp, and a key
+* sorts after every proper prefix of itself, so string keys keep the
+* order strcmp gives them.  The four-argument form compares (key, record
+* id) pairs, breaking ties between equal keys on the record ids.
 *
 * make_entry packages a key and a data value into a chunk of memory 
 * large enough to hold it (the first parameter).  Note that the 
 * resultant KeyDataEntry cannot be accessed by its members because
 * the Datatype member may start after the actual beginning of the
 * data value stored here.  The real length of the resulting <key,data>
-* pair is returned in *pentry_len.
+* pair is returned in *pentry_len.  Index entries are made with the form
+* that also takes the record id of the separator.
 *
 * get_key_data takes a KeyDataEntry chunk and its real length and 
 * unpacks the <key,data> values from it; those are written to *targetkey
@@ -125,16 +195,50 @@ struct KeyDataEntry
 *   - key1 == key2 : 0
 *   - key1  > key2 : positive
 *
-* Finally, get_key_length and get_key_data_length determine the 
-* storage required for given key and key+data. 
+* Finally, get_data_length and get_key_data_length determine the storage
+* required for given data and key+data; the form of get_key_data_length
+* that takes a record id sizes an index entry for that separator.
+* get_entry_key finds the key of an entry of any node type, including
+* posting-list entries, which keep the length of their key in their
+* first byte instead of having a fixed amount of data after it.
+* get_entry_rid finds the record id that the entry is ordered by, which
+* is LOWEST_RID for posting-list entries since no two of them share a
+* key, and for index entries that store none.
+*
+* get_key_prefix returns the KeyPrefix of a key, which lets searches of
+* nodes that keep their prefixes in one array (see memindex.h) settle
+* most comparisons with a single integer compare.  count_prefixes
+* compares a probe prefix against a whole run of prefixes at once (with
+* SSE2 where the compiler targets it) and reports how many are below it
+* and how many are equal to it.
+*
+* get_key_hash hashes the bytes of a key to 64 well-mixed bits, for the
+* Bloom filter and the hash index.
+*
+* make_separator_key computes the shortest key that sorts strictly above
+* one key and at or below another; this is what leaf splits promote into
+* the index so that long keys do not eat up index node fan-out.
 */
 
+int KeyCmp(const KeyView &key1, const KeyView &key2);
 int KeyCmp(const char *key1, const char *key2);
-int GetKeyLength(const char *key);
-int GetKeyDataLength(const char *key, const NodeType nodeType);
-void MakeEntry (KeyDataEntry *target, const char *key,
+int KeyCmp(const KeyView &key1, const RecordID &rid1, 
+           const KeyView &key2, const RecordID &rid2);
+KeyView MakeKeyView(const char *key);
+KeyView GetEntryKey(const char *entry, int len, NodeType nodeType);
+RecordID GetEntryRid(const char *entry, int len, NodeType nodeType);
+int GetDataLength(const NodeType nodeType);
+int GetKeyDataLength(const KeyView &key, const NodeType nodeType);
+int GetKeyDataLength(const KeyView &key, const RecordID &keyRid);
+void MakeEntry (KeyDataEntry *target, const KeyView &key,
                 NodeType nodeType, DataType data,int *len);
+void MakeEntry (KeyDataEntry *target, const KeyView &key,
+                const RecordID &keyRid, PageID pageNo, int *len);
 void GetKeyData (char *key, DataType *data, KeyDataEntry *pair, int len, NodeType nodeType);
+int MakeSeparatorKey(char *separator, const KeyView &leftKey, const KeyView &rightKey);
+KeyPrefix GetKeyPrefix(const KeyView &key);
+void CountPrefixes(const KeyPrefix *prefixes, int n, KeyPrefix probe, int *below, int *equal);
+unsigned long long GetKeyHash(const KeyView &key);
 
 #define INSERT(page, key, data, rid) {\
 	if ((page)->Insert(key, data, rid) != OK) {\
@@ -0,0 +1,44 @@
+#ifndef BTBLOOM_PAGE_H
+#define BTBLOOM_PAGE_H
+
+#include "minirel.h"
+#include "page.h"
+#include "heappage.h"
+#include "bt.h"
+
+/*
+* Bloom filter pages.
+*
+* A BTreeFile may keep a Bloom filter of its keys in a run of pages
+* recorded in its header page.  A key that the filter does not contain
+* is certainly not in the tree, so a lookup for it can stop without
+* reading a single tree page.
+*
+* The filter is blocked: a key hashes to one page of the run, and all
+* BLOOM_NUM_HASHES of its bits are set in that page.  Adding or testing
+* a key therefore pins one page, whatever the size of the filter.  The
+* pages hold nothing but bits, in the data area of a HeapPage, so the
+* filter is sized at BLOOM_BITS_PER_KEY bits for each key it is expected
+* to hold, which gives about one false positive in a hundred.
+*
+* Bits cannot be taken out of a Bloom filter, so deleted keys stay in
+* it until it is rebuilt from the leaves.
+*/
+
+#define BLOOM_BITS_PER_KEY  10
+#define BLOOM_NUM_HASHES    6
+#define BLOOM_PAGE_BITS     (HEAPPAGE_DATA_SIZE * 8)
+
+
+class BTBloomPage : public HeapPage {
+
+public:
+
+	static int GetPageIndex(const KeyView &key, int numPages);
+
+	void Clear();
+	void Add(const KeyView &key);
+	bool MayContain(const KeyView &key);
+};
+
+#endif
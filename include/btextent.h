@@ -0,0 +1,58 @@
+#ifndef BTEXTENT_H
+#define BTEXTENT_H
+
+#include <map>
+#include <set>
+#include <utility>
+#include "minirel.h"
+#include "page.h"
+
+/*
+* Free leaf pages of a tree.
+*
+* A BTreeFile does not give the pages of the leaves it merges or moves
+* back to the database straight away.  It keeps them, as runs of
+* consecutive pages, in a BTFreeExtentMap and takes new leaves from
+* there before going to DB::AllocatePage, whose search of the space
+* map grows with the database.
+*
+* The map is indexed both by first page, so that a split can take the
+* free page nearest its leaf and freed pages merge with the runs next
+* to them, and by size, so that a run for a new extent is found with a
+* best fit.  Every operation takes O(log n) in the number of runs.
+*
+* The map lives in memory only, so the tree keeps no more than
+* FREE_LEAF_MAX_PAGES in it (see btfile.h).  Pages beyond that go back
+* to the database as soon as they are freed, the shortest runs first,
+* and the rest when the tree is closed or destroyed.
+*/
+
+
+class BTFreeExtentMap {
+
+public:
+
+	BTFreeExtentMap() : numPages(0) {}
+
+	void Add(PageID firstPage, int count);
+	bool TakeNear(PageID near, PageID &pageID);
+	bool TakeRun(int count, PageID &firstPage);
+	bool TakeSmallest(PageID &firstPage, int &count);
+
+	int  GetNumPages() { return numPages; }
+
+private:
+
+	typedef std::map<PageID, int>                StartMap;
+	typedef std::set<std::pair<int, PageID> >    SizeSet;
+
+	StartMap byStart;    // number of pages of each run, by first page
+	SizeSet  bySize;     // (number of pages, first page) of each run
+	int      numPages;   // pages in all runs
+
+	void Insert(PageID firstPage, int count);
+	void Remove(StartMap::iterator run);
+	void TakePage(StartMap::iterator run, PageID pageID);
+};
+
+#endif
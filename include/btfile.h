@@ -3,10 +3,51 @@
 
 #include "btindex.h"
 #include "btleaf.h"
+#include "btposting.h"
+#include "btbloom.h"
+#include "bthint.h"
+#include "btresident.h"
+#include "btextent.h"
 #include "index.h"
 #include "btfilescan.h"
 #include "bt.h"
 
+// Upper bound on the number of levels of a tree, used to size the
+// descent path that MultiGet keeps on the stack.
+#define MAX_TREE_HEIGHT     32
+
+// Number of lookups MultiGetInterleaved advances together.  Each one
+// has a page on its way into the cache while the others are searched.
+#define LOOKUP_GROUP_SIZE   8
+
+// Largest number of pages reserved at a time for new leaves.  Leaves
+// come from these extents rather than one page at a time from anywhere
+// in the database, so that a chain of leaves stays on a few runs of
+// pages.  The first extent of a tree is a single page and each one
+// after it twice the last, so that a small tree does not hold on to
+// pages it will never use.
+#define LEAF_EXTENT_PAGES   64
+
+// Most pages a tree keeps in its map of free leaf pages (see btextent.h)
+// for new leaves; pages freed beyond that go back to the database.
+#define FREE_LEAF_MAX_PAGES LEAF_EXTENT_PAGES
+
+// DefragmentLeaves merges two neighbouring leaves only if this much of
+// the page (a fraction of HEAPPAGE_DATA_SIZE) is still free afterwards,
+// so that merged leaves do not split again at the next insert.
+#define DEFRAG_MIN_FREE     4    // a quarter of the page
+
+// Number of pages of a new Bloom filter that each insert or delete
+// clears or fills from the leaves while the filter is being rebuilt.
+#define BLOOM_REBUILD_STEP  4
+
+// Layout of the pages of an index, kept on its header page so that an
+// index in another layout is refused rather than misread.  Version 2
+// leaves the record id out of index entries that do not need it (see
+// INDEX_RID_FLAG in bt.h); version 3 keeps the bits of the Bloom filter
+// in the data area of its pages (see btbloom.h).
+#define BTREE_FORMAT_VERSION 0x42540003
+
 enum PrintOption
 { SINGLE,
   RECURSIVE
@@ -19,7 +60,7 @@ public:
 	friend class BTreeDriver;
 	friend class BTreeFileScan;
 
-    BTreeFile(Status& status, const char *filename);
+    BTreeFile(Status& status, const char *filename, NodeType leafType = LEAF_NODE, bool readOnly = false);
 
 	~BTreeFile();
 	
@@ -28,10 +69,28 @@ public:
     Status Insert(const char *key, const RecordID rid); 
     Status Delete(const char *key, const RecordID rid);
     
+    Status Insert(const KeyView &key, const RecordID rid); 
+    Status Delete(const KeyView &key, const RecordID rid);
+    
 	IndexFileScan *OpenScan(const char *lowKey = NULL, 
 		const char *highKey = NULL);
+	IndexFileScan *OpenScan(const KeyView &lowKey, const KeyView &highKey);
+	IndexFileScan *OpenPrefixScan(const KeyView &prefix);
+
+	Status Lookup(const char *key, RecordID *rids, int maxRids, int &numRids);
+	Status Lookup(const KeyView &key, RecordID *rids, int maxRids, int &numRids);
+	Status MultiGet(const KeyView *keys, int numKeys, RecordID *rids, int maxRids, int *numRids);
+	Status MultiGetInterleaved(const KeyView *keys, int numKeys, RecordID *rids, int maxRids, int *numRids);
+
+	Status CreateBloomFilter(int expectedKeys);
+	Status RebuildBloomFilter();
+	Status DestroyBloomFilter();
+
+	Status ReclusterLeaves();
+	Status DefragmentLeaves(int maxLeaves, bool &passDone);
 
 	Status Search(const char *key,  PageID& foundPid);
+	Status Search(const KeyView &key,  PageID& foundPid);
 
 	Status PrintTree (PageID pageID, PrintOption option);
 	Status PrintWhole ();
@@ -42,9 +101,15 @@ private:
     struct BTreeHeaderPage : HeapPage {
 	public:
 		// Initializes the header page and sets the root to be invalid.
-		void Init(PageID hpid) {
+		void Init(PageID hpid, NodeType leafType) {
 			HeapPage::Init(hpid);
 			SetRootPageID(INVALID_PAGE);
+			SetLeafType(leafType);
+			SetBloomFilter(INVALID_PAGE, 0);
+			SetBloomRebuild(INVALID_PAGE, 0);
+			SetLeafExtent(INVALID_PAGE, 0);
+			SetNextExtentSize(1);
+			SetFormatVersion(BTREE_FORMAT_VERSION);
 		}
 
 		PageID GetRootPageID() {
@@ -56,11 +121,102 @@ private:
 			PageID *ptr = (PageID *)(HeapPage::data);
 			*ptr = pid;
 		}
+
+		// The type of the leaves of the tree: LEAF_NODE, or POSTING_NODE
+		// for posting-list leaves.
+		NodeType GetLeafType() {
+			return (((int *) HeapPage::data)[1] == POSTING_NODE) ? POSTING_NODE : LEAF_NODE;
+		}
+
+		void SetLeafType(NodeType leafType) {
+			((int *) HeapPage::data)[1] = leafType;
+		}
+
+		// The Bloom filter of the keys, if there is one: a run of pages
+		// starting at the first, INVALID_PAGE if there is none (see
+		// btbloom.h).  The filter also counts the entries added and
+		// deleted since it was last built, to know when to rebuild it.
+		PageID GetBloomPageID()      { return ((int *) HeapPage::data)[2]; }
+		int    GetBloomNumPages()    { return ((int *) HeapPage::data)[3]; }
+		int    GetBloomNumEntries()  { return ((int *) HeapPage::data)[4]; }
+		int    GetBloomNumDeletes()  { return ((int *) HeapPage::data)[5]; }
+
+		void SetBloomFilter(PageID firstPage, int numPages) {
+			((int *) HeapPage::data)[2] = firstPage;
+			((int *) HeapPage::data)[3] = numPages;
+			SetBloomCounts(0, 0);
+		}
+
+		void SetBloomCounts(int numEntries, int numDeletes) {
+			((int *) HeapPage::data)[4] = numEntries;
+			((int *) HeapPage::data)[5] = numDeletes;
+		}
+
+		// The pages left in the extent new leaves are taken from: the
+		// next one and how many there are, INVALID_PAGE and 0 if none.
+		PageID GetExtentPageID()     { return ((int *) HeapPage::data)[6]; }
+		int    GetExtentNumPages()   { return ((int *) HeapPage::data)[7]; }
+
+		void SetLeafExtent(PageID nextPage, int numPages) {
+			((int *) HeapPage::data)[6] = nextPage;
+			((int *) HeapPage::data)[7] = numPages;
+		}
+
+		// The number of pages the next extent for new leaves is to have.
+		int    GetNextExtentSize()   { return ((int *) HeapPage::data)[10]; }
+		void   SetNextExtentSize(int numPages) { ((int *) HeapPage::data)[10] = numPages; }
+
+		// The layout of the index, BTREE_FORMAT_VERSION for this code.
+		int    GetFormatVersion()    { return ((int *) HeapPage::data)[11]; }
+		void   SetFormatVersion(int version) { ((int *) HeapPage::data)[11] = version; }
+
+		// The Bloom filter being built to replace the one above, if
+		// any: a run of as many pages, and the entries added to it.
+		PageID GetBloomRebuildPageID()     { return ((int *) HeapPage::data)[8]; }
+		int    GetBloomRebuildNumEntries() { return ((int *) HeapPage::data)[9]; }
+
+		void SetBloomRebuild(PageID firstPage, int numEntries) {
+			((int *) HeapPage::data)[8] = firstPage;
+			((int *) HeapPage::data)[9] = numEntries;
+		}
     };
 
 	BTreeHeaderPage *header;   // header page
     PageID           headerID; // page number of header page
     char            *dbname;       // copied from arg of the constructor.	
+	bool             readOnly;     // opened for lookups and scans only
+	BTHintTable      hints;        // adaptive hash index of hot keys (see bthint.h)
+	BTResidentTable  resident;     // index pages kept pinned (see btresident.h)
+	BTFreeExtentMap  freeLeaves;   // freed leaf pages kept for new leaves (see btextent.h)
+
+	// Where DefragmentLeaves is up to between calls
+	struct DefragState
+	{
+		bool     active;        // a pass is under way
+		bool     atStart;       // the pass has yet to visit the leftmost leaf
+		KeyType  key;           // otherwise, the separator of the next subtree to visit
+		int      keyLen;
+		RecordID rid;
+		bool     rewrite;       // the pass moves the leaves it keeps to the leaf extent
+		PageID   lastLeafID;    // last leaf kept by the pass
+		int      numLeaves;     // leaves kept by the pass so far
+		int      numJumps;      // of those, ones not on the page after the one before
+		int      lastNumLeaves; // numLeaves and numJumps of the last pass, -1 before the first
+		int      lastNumJumps;
+	};
+
+	DefragState      defrag;
+
+	// Where the rebuild of the Bloom filter is up to between calls
+	// (see BloomRebuildStep).  It starts over if the file is reopened.
+	struct BloomRebuildState
+	{
+		int      numCleared;    // pages of the new filter cleared so far
+		bool     atStart;       // the leaves have yet to be visited
+		PageID   nextLeafID;    // otherwise, the next leaf to add, INVALID_PAGE after the last
+	};
+
+	BloomRebuildState bloomRebuild;
     
 	int				totalDataPages;
 	int				totalIndexPages;
@@ -74,16 +230,41 @@ private:
 	int				totalNumData;
 	int				hight; // hight of Tree
 
-	Status _Search( const char *key,  PageID, PageID&);
-	Status _SearchIndex (const char *key,  PageID currIndexID, BTIndexPage *currIndex, PageID& foundID);
+	Status PinNode(PageID pageID, SortedPage *&page);
+	Status UnpinNode(PageID pageID, bool dirty);
+
+	Status NewLeafPage(PageID &pageID, Page *&page, PageID near);
+	Status NewLeafExtent(int numPages);
+	Status FreeLeafExtent();
+	Status AddFreeLeaves(PageID firstPageID, int numPages);
+	Status ReleaseFreeLeaves(int maxPages);
+	Status MoveLeaf(PageID pageID, SortedPage *page, PageID &newPageID);
+	Status _ReclusterLeaves(PageID indexID);
+	Status DefragmentParent(int &maxLeaves);
+	Status MergeLeaves(PageID leftID, SortedPage *left, PageID pageID, SortedPage *page);
+
+	Status _Search( const KeyView &key,  PageID, PageID&);
+	Status _SearchIndex (const KeyView &key,  PageID currIndexID, BTIndexPage *currIndex, PageID& foundID);
 	Status _PrintTree ( PageID pageID);
 
 	Status BTreeFile::_DumpStatistics(PageID);
 	Status BTreeFile::__DumpStatistics(PageID);
 
 	Status BTreeFile::_DestroyFile(PageID);
-	Status BTreeFile::SplitLeafNode(const char *key, const RecordID rid, BTLeafPage *fullPage, PageID &newPageID, KeyType &newPageFirstKey);
-	Status BTreeFile::SplitIndexNode(const char *key, const PageID pid, BTIndexPage *fullPage, PageID &newPageID, KeyType &newPageFirstKey);
+	Status BTreeFile::SplitLeafNode(const KeyView &key, const RecordID rid, BTLeafPage *fullPage, PageID &newPageID, KeyType &separatorKey, int &separatorLen, RecordID &separatorRid);
+	Status SplitPostingNode(const KeyView &key, const RecordID rid, BTPostingPage *fullPage, PageID &newPageID, KeyType &separatorKey, int &separatorLen, RecordID &separatorRid);
+	Status BTreeFile::SplitIndexNode(const KeyView &key, const RecordID &keyRid, const PageID pid, BTIndexPage *fullPage, PageID &newPageID, KeyType &newPageFirstKey, int &newPageFirstKeyLen, RecordID &newPageFirstRid);
+
+	int    LeafInsertLength(SortedPage *leaf, const KeyView &key, const RecordID rid);
+	Status LeafInsert(SortedPage *leaf, const KeyView &key, const RecordID rid);
+	Status LeafDelete(SortedPage *leaf, const KeyView &key, const RecordID rid);
+	Status CollectRids(SortedPage *leaf, int slotNo, const KeyView &key, RecordID *rids, int maxRids, int &numRids);
+	bool   IsHintValid(SortedPage *leaf, int slotNo, const KeyView &key);
+
+	Status BloomAdd(const KeyView &key);
+	Status BloomMayContain(const KeyView &key, bool &mayContain);
+	Status StartBloomRebuild();
+	Status BloomRebuildStep();
 
 	void BTreeFile::debugPrint(const char *msg);
 };
@@ -12,13 +12,21 @@ public:
 	friend class BTreeFile;
 
     Status GetNext (RecordID & rid, char* keyptr);
+    Status GetNext (RecordID & rid, char* keyptr, int &keyLen);
 
 	~BTreeFileScan();	
 
 private:
-	void Init(const char *lowKey, const char *highKey, PageID leftmostLeafPageID);
-	const char *lowKey;
-	const char *highKey;
+	void Init(const KeyView *lowKey, const KeyView *highKey, PageID leftmostLeafPageID);
+	
+	// The bounds of the scan, copied so that they outlive the caller's
+	// buffers.  lowKey and highKey are NULL for an open end.
+	KeyType lowKeyData;
+	KeyType highKeyData;
+	KeyView lowKeyView;
+	KeyView highKeyView;
+	const KeyView *lowKey;
+	const KeyView *highKey;
 	PageID leftmostLeafID;
 
 	PageID curPageID;
@@ -26,6 +34,11 @@ private:
 	
 	bool scanStarted;
 	bool scanFinished;
+
+	// Position within the posting list of the current entry, when the
+	// leaves are posting pages (see btposting.h).
+	bool inPostingList;
+	PostingCursor postingCursor;
 };
 
 #endif
\ No newline at end of file
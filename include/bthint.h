@@ -0,0 +1,81 @@
+#ifndef BTHINT_H
+#define BTHINT_H
+
+#include "minirel.h"
+#include "page.h"
+
+/*
+* Adaptive hash index.
+*
+* A BTreeFile keeps, in memory, a table of hints for the keys it sees
+* looked up again and again: for each such key, the leaf and slot of
+* its first entry.  A lookup that finds a hint goes straight to that
+* leaf instead of descending from the root.
+*
+* Hints are only hints.  The table knows keys by their hash alone, and
+* the tree moves entries about as it changes, so a lookup checks the
+* hint against the pinned leaf before trusting it (see
+* BTreeFile::Lookup).  A split leaves its hints alone: a hint whose
+* entry moved off the leaf no longer checks out, and is replaced by the
+* next lookup of its key.  A leaf emptied by a merge or move is
+* cleared before it joins the free leaf pages, so that its old entries
+* cannot pass the check.  Only when a leaf goes back to the database,
+* where another file may take it, are all the hints dropped at once,
+* by starting a new generation of them.
+*
+* A key earns a hint once it has been looked up HINT_HOT_PROBES times,
+* as counted by a table of small saturating counters that are halved
+* every so often, so that keys which have cooled down are forgotten.  The
+* table starts with HINT_MIN_ENTRIES hints and doubles, up to
+* HINT_MAX_ENTRIES, whenever hot keys keep evicting one another; it
+* halves again when few of its hints are in use.
+*/
+
+#define HINT_MIN_ENTRIES   256
+#define HINT_MAX_ENTRIES   65536
+#define HINT_HOT_PROBES    2
+#define HINT_AGING_PROBES  8    // probes per entry between two agings
+
+
+class BTHintTable {
+
+public:
+
+	BTHintTable();
+	~BTHintTable();
+
+	bool Find(unsigned long long hash, PageID &pageID, int &slotNo);
+	bool Touch(unsigned long long hash);
+	void Record(unsigned long long hash, PageID pageID, int slotNo);
+	void Forget(unsigned long long hash);
+	void ForgetAll();
+	void Clear();
+
+private:
+
+	struct Hint
+	{
+		unsigned long long hash;
+		PageID             pageID;   // INVALID_PAGE if the entry is free
+		int                slotNo;
+		unsigned int       generation;  // stale unless that of the table
+	};
+
+	Hint          *hints;
+	unsigned char *counts;      // probes per key, indexed by hash
+	int            numEntries;  // size of both arrays, a power of two
+	int            numHints;    // entries in use
+	int            numProbes;   // probes since the last aging
+	int            numEvictions;// hints evicted since the last aging
+	unsigned int   generation;  // bumped by ForgetAll
+
+	bool InUse(const Hint *hint) { return hint->pageID != INVALID_PAGE && hint->generation == generation; }
+	void Resize(int newNumEntries);
+	void Age();
+
+	// Not copyable: a copy would share the arrays of the table
+	BTHintTable(const BTHintTable &);
+	BTHintTable &operator=(const BTHintTable &);
+};
+
+#endif
@@ -17,18 +17,20 @@ private:
 
 public:
 	
-	Status Insert (const char *key, PageID pageNo, RecordID& rid);
-	Status Delete (const char *key, RecordID& curRid);
-	Status GetPageID (const char *key, PageID & pageNo);
-	Status GetSibling(const char *key, PageID & pageNo, int &left);
+	Status Insert (const KeyView &key, const RecordID &keyRid, PageID pageNo, RecordID& rid);
+	Status Delete (const KeyView &key, RecordID& curRid);
+	Status GetPageID (const KeyView &key, const RecordID &keyRid, PageID & pageNo);
+	PageID GetChild (int slotNo);
+	void   SetChild (int slotNo, PageID pageNo);
+	Status GetSibling(const KeyView &key, PageID & pageNo, int &left);
 	Status GetFirst (RecordID& rid, char *key, PageID & pageNo);
 	Status GetNext (RecordID& rid, char *key, PageID & pageNo);
 	
 	PageID GetLeftLink (void);
 	void   SetLeftLink (PageID left);
 	    
-	Status FindKey (char *key, char *entry);
-	Status AdjustKey (const char *newKey, const char *oldKey);
+	Status FindKey (const KeyView &key, KeyView &entry);
+	Status AdjustKey (const KeyView &newKey, const KeyView &oldKey);
 };
 
 #endif
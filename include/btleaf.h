@@ -16,13 +16,15 @@ private:
 	
 public:
 		
-	Status Insert (const char *key, RecordID dataRid, RecordID& rid);
+	Status Insert (const KeyView &key, RecordID dataRid, RecordID& rid);
 	
 	Status GetFirst (RecordID& rid, char* key, RecordID & dataRid);
 	Status GetNext  (RecordID& rid, char* key, RecordID & dataRid);
 	Status GetCurrent (RecordID rid, char* key, RecordID & dataRid);
 	
-	Status Delete (const char* key, const RecordID& dataRid);
+	RecordID GetDataRid (int slotNo);
+	
+	Status Delete (const KeyView &key, const RecordID& dataRid);
 };
 
 #endif
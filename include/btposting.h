@@ -0,0 +1,94 @@
+#ifndef BTPOSTING_PAGE_H
+#define BTPOSTING_PAGE_H
+
+#include "minirel.h"
+#include "page.h"
+#include "heappage.h"
+#include "sortedpage.h"
+#include "bt.h"
+
+/*
+* Posting-list leaves.
+*
+* A BTPostingPage is a leaf (of type POSTING_NODE) that stores each key
+* once, together with the sorted list of all the record ids that have
+* that key.  Each entry is laid out as
+*
+*   | key length (1 byte) | key | overflow PageID | number of rids | rids |
+*
+* The rids are delta-compressed: each one is written as the difference
+* of its page number from the previous rid's, as a variable-length
+* integer, followed by its slot number, which is again a difference if
+* the page number did not change.  Runs of rids on the same or nearby
+* pages take two or three bytes each.
+*
+* Once the rid list of an entry outgrows POSTING_INLINE_MAX bytes, it is
+* moved out to a chain of BTOverflowPages and the entry keeps only the
+* page id of the first one.  Each overflow page holds a compressed run
+* of rids, and the runs are in order along the chain.
+*/
+
+#define POSTING_INLINE_MAX  (MAX_SPACE / 8)
+
+
+struct PostingCursor
+{
+	PageID   page;   // overflow page being read, INVALID_PAGE for inline
+	int      index;  // number of rids already read from the run
+	int      offset; // byte offset of the next rid in the run
+	RecordID prev;   // last rid read
+};
+
+
+class BTOverflowPage : public HeapPage {
+
+private:
+
+	struct OverflowHeader
+	{
+		int      numRids;
+		int      length;   // bytes of compressed rids
+		RecordID firstRid;
+	};
+
+	OverflowHeader *Header() { return (OverflowHeader *)HeapPage::data; }
+
+public:
+
+	void     Init(PageID pageNo);
+
+	int      GetNumOfRids()  { return Header()->numRids; }
+	RecordID GetFirstRid()   { return Header()->firstRid; }
+	const unsigned char *GetRidData()
+		{ return (const unsigned char *)HeapPage::data + sizeof(OverflowHeader); }
+
+	int      GetRids(RecordID *rids);
+	Status   SetRids(const RecordID *rids, int numRids);
+};
+
+
+struct PostingEntry;
+
+class BTPostingPage : public SortedPage {
+
+private:
+
+	// No private variables should be declared.
+
+	void   GetEntry(int slotNo, PostingEntry &e);
+	Status ReplaceEntry(int slotNo, char *entry, int len);
+
+public:
+
+	int    GetInsertLength(const KeyView &key, RecordID dataRid);
+	Status Insert(const KeyView &key, RecordID dataRid);
+	Status Delete(const KeyView &key, const RecordID &dataRid);
+
+	int    GetNumOfRids(int slotNo);
+	Status FreeOverflowPages();
+
+	void   InitCursor(int slotNo, PostingCursor &cursor);
+	Status NextRid(int slotNo, PostingCursor &cursor, RecordID &dataRid);
+};
+
+#endif
@@ -4,6 +4,7 @@
 #include "btfile.h"
 #include "index.h"
 #include <vector>
+#include <string>
 
 const int BTREE_DEFAULT_PAD = 4;
 const int BTREE_DEFAULT_RID_OFFSET = 1;
@@ -37,8 +38,17 @@ private:
 										   int pad);
 
 	static PageID GetLeftmostLeaf(BTreeFile *btf);
+	static int CountLeafJumps(BTreeFile *btf, int &numLeaves);
 
 	static bool TestScanCount(IndexFileScan* scan, int expected);
+	static bool TestSameEntries(IndexFileScan *scan, IndexFileScan *refScan);
+	static bool TestSameEntries(IndexFileScan *scan, BTreeFile *ref);
+	static bool TestSameEntries(BTreeFile *btf, BTreeFile *ref);
+	static bool TestMultiGet(BTreeFile *btf, const std::vector<int> &keys,
+							 const std::vector<int> &counts,
+							 bool interleaved = false);
+	static bool TestSameLookups(IndexFile *index, BTreeFile *ref,
+								const std::vector<std::string> &keys);
 
 
 
@@ -50,6 +60,25 @@ private:
 	bool Test5();
 	bool Test6();
 	bool Test7();
+	bool Test8();
+	bool Test9();
+	bool Test10();
+	bool Test11();
+	bool Test12();
+	bool Test13();
+	bool Test14();
+	bool Test15();
+	bool Test16();
+	bool Test17();
+	bool Test18();
+	bool Test19();
+	bool Test20();
+	bool Test21();
+	bool Test22();
+	bool Test23();
+	bool Test24();
+	bool Test25();
+	bool Test26();
 };
 
 
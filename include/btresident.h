@@ -0,0 +1,74 @@
+#ifndef BTRESIDENT_H
+#define BTRESIDENT_H
+
+#include "minirel.h"
+#include "page.h"
+#include "sortedpage.h"
+
+/*
+* Resident index pages.
+*
+* Every step down a tree pins the next page, which costs a lookup in
+* the buffer manager's page table, and unpins the last one.  For the
+* upper levels of the tree, which nearly every operation goes through,
+* this is most of the work of a descent.
+*
+* A BTreeFile therefore keeps up to RESIDENT_MAX_PAGES of its index
+* pages pinned for as long as it is open, in a small table of its own
+* that maps their page ids to their frames.  This is still a hash
+* lookup, not a pointer held in the parent, but in a table of a few
+* dozen entries that only this tree uses, and with no pin count to
+* keep.  Descents look there first and only go to the buffer manager
+* for the pages that are not resident.  Index pages join the table as descents first pin
+* them, so it fills with the root and the levels just below it.  The
+* frames are shared out first come, first served: all open trees
+* together keep at most 1/RESIDENT_POOL_SHARE of the buffer pool
+* resident, so that many open trees cannot pin the pool dry.
+*
+* A resident page cannot be evicted, so its frame stays valid until the
+* tree lets go of it, when the file is destroyed or closed.  Index
+* pages are not freed before then.  The first change to a resident
+* page is passed on to the buffer manager by pinning the page once more
+* and unpinning it dirty, so that a flush of the pool writes it out like
+* any other page; later changes only find the page already marked.  The
+* page is unpinned dirty when it is let go, should a flush have cleaned
+* it since.
+*/
+
+#define RESIDENT_MAX_PAGES   16                         // per tree
+#define RESIDENT_TABLE_SIZE  (2 * RESIDENT_MAX_PAGES)   // a power of two
+#define RESIDENT_POOL_SHARE  8                          // of the buffer pool, over all trees
+
+
+class BTResidentTable {
+
+public:
+
+	BTResidentTable();
+
+	SortedPage *Find(PageID pageID);
+	bool   Add(PageID pageID, SortedPage *page);
+	Status Unpin(PageID pageID, bool dirty);
+	Status ReleaseAll();
+
+	int        GetNumPages()   { return numPages; }
+	static int GetTotalPages() { return totalPages; }
+
+private:
+
+	struct Entry
+	{
+		PageID      pageID;   // INVALID_PAGE if the entry is free
+		SortedPage *page;
+		bool        dirty;    // changed since it was made resident
+	};
+
+	Entry entries[RESIDENT_TABLE_SIZE];
+	int   numPages;
+
+	static int totalPages;   // resident pages of all tables
+
+	int Slot(PageID pageID);
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef _COMPOSITE_KEY_H
+#define _COMPOSITE_KEY_H
+
+#include "minirel.h"
+#include "bt.h"
+
+/*
+* Composite (multi-column) keys.
+*
+* A KeySchema lists the types and lengths of the columns of a key, in
+* the order they are compared.  A CompositeKey encodes values for those
+* columns into a single byte string whose memcmp order (see KeyCmp) is
+* the order of the columns compared one after another:
+*
+*   - attrInteger : two's complement, sign bit flipped, big-endian.
+*   - attrReal    : IEEE bits, big-endian; the sign bit is flipped for
+*                   positive numbers and all bits are flipped for
+*                   negative ones.
+*   - attrString  : the bytes of the string with every 0x00 written as
+*                   0x00 0xFF, followed by 0x00 0x01.  The terminator
+*                   sorts below every byte that can follow it, so a
+*                   string sorts before any longer string it begins.
+*
+* Because every column is self-delimiting, the encoding of the first n
+* columns is a prefix of the encoding of the whole key, which is what
+* BTreeFile::OpenPrefixScan relies on to scan the leading columns.
+*/
+
+#define MAX_KEY_COLUMNS     8
+
+class KeySchema {
+
+public:
+
+	KeySchema();
+
+	Status AddColumn(AttrType type, int length);
+
+	// Add a column described by a catalog attribute record (AttrDesc).
+	// This is a template so that the index code does not have to pull
+	// in the catalog headers.
+	template <class AttrDescT>
+	Status AddColumn(const AttrDescT &attr)
+	{
+		return AddColumn(attr.attrType, attr.attrLen);
+	}
+
+	int      GetNumOfColumns() const     { return numOfColumns; }
+	AttrType GetType(int column) const   { return types[column]; }
+	int      GetLength(int column) const { return lengths[column]; }
+
+private:
+
+	int      numOfColumns;
+	AttrType types[MAX_KEY_COLUMNS];
+	int      lengths[MAX_KEY_COLUMNS];
+};
+
+
+class CompositeKey {
+
+public:
+
+	CompositeKey(const KeySchema &schema);
+
+	void   Clear();
+
+	Status AppendInt(int value);
+	Status AppendReal(double value);
+	Status AppendString(const char *value);
+	Status AppendString(const char *value, int length);
+	Status AppendColumn(const char *value);
+
+	int     GetNumOfColumns() const { return numOfColumns; }
+	KeyView GetKeyView() const;
+
+private:
+
+	Status AppendInteger(long long value);
+	Status AppendBytes(const unsigned char *bytes, int length);
+	Status CheckColumn(AttrType type);
+
+	const KeySchema &schema;
+	int              numOfColumns; // columns appended so far
+	int              length;       // bytes of key used so far
+	KeyType          key;
+};
+
+#endif // _COMPOSITE_KEY_H
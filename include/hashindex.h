@@ -0,0 +1,104 @@
+#ifndef _HASHINDEX_H
+#define _HASHINDEX_H
+
+#include "minirel.h"
+#include "page.h"
+#include "heappage.h"
+#include "index.h"
+#include "bt.h"
+
+/*
+* Extendible hash index.
+*
+* A HashIndexFile keeps the same (key, record id) entries as a BTreeFile
+* with LEAF_NODE leaves, but in buckets chosen by the hash of the key
+* (GetKeyHash) instead of in key order, so it can only answer equality
+* lookups; in return a lookup reads one directory page and one bucket
+* page, whatever the size of the index.
+*
+* The directory is a run of pages holding 2^globalDepth bucket page ids,
+* HASH_DIR_ENTRIES_PER_PAGE to a page, and is indexed by the low
+* globalDepth bits of the hash.  A bucket has a local depth d <= the
+* global depth, and all the directory entries that agree with it on the
+* low d bits point to it.  A full bucket is split in two on bit d, which
+* doubles the directory first if d is already the global depth.
+*
+* Entries whose hashes agree on all HASH_MAX_GLOBAL_DEPTH bits cannot be
+* split apart, so once a bucket holds nothing else it grows a chain of
+* overflow pages instead.  Buckets are never merged.
+*/
+
+#define HASH_DIR_ENTRIES_PER_PAGE  ((int)(MAX_SPACE / sizeof(PageID)))
+#define HASH_MAX_GLOBAL_DEPTH      20
+
+
+class HashBucketPage : public HeapPage {
+
+public:
+
+	void Init(PageID pageNo, int localDepth) {
+		HeapPage::Init(pageNo);
+		SetLocalDepth(localDepth);
+	}
+
+	// The local depth of the bucket; only kept on its first page.
+	int  GetLocalDepth()               { return type; }
+	void SetLocalDepth(int localDepth) { type = (short)localDepth; }
+};
+
+
+class HashIndexFile : public IndexFile {
+
+public:
+
+	HashIndexFile(Status& status, const char *filename);
+
+	~HashIndexFile();
+
+	Status DestroyFile();
+
+	Status Insert(const char *key, const RecordID rid);
+	Status Delete(const char *key, const RecordID rid);
+
+	Status Insert(const KeyView &key, const RecordID rid);
+	Status Delete(const KeyView &key, const RecordID rid);
+
+	Status Lookup(const char *key, RecordID *rids, int maxRids, int &numRids);
+	Status Lookup(const KeyView &key, RecordID *rids, int maxRids, int &numRids);
+
+private:
+
+	struct HashHeaderPage : HeapPage {
+	public:
+		void Init(PageID hpid) {
+			HeapPage::Init(hpid);
+			SetDirectory(0, INVALID_PAGE, 0);
+		}
+
+		int    GetGlobalDepth()   { return ((int *) HeapPage::data)[0]; }
+		PageID GetDirPageID()     { return ((int *) HeapPage::data)[1]; }
+		int    GetDirNumPages()   { return ((int *) HeapPage::data)[2]; }
+
+		void SetDirectory(int globalDepth, PageID firstPage, int numPages) {
+			((int *) HeapPage::data)[0] = globalDepth;
+			((int *) HeapPage::data)[1] = firstPage;
+			((int *) HeapPage::data)[2] = numPages;
+		}
+	};
+
+	HashHeaderPage *header;   // header page
+	PageID          headerID; // page number of header page
+	char           *dbname;   // copied from arg of the constructor.
+
+	Status CreateDirectory();
+	Status GetBucket(unsigned long long hash, PageID &bucketID);
+	Status SetBuckets(unsigned long long hash, int localDepth, PageID bucketID);
+	Status DoubleDirectory();
+	Status SplitBucket(PageID bucketID, HashBucketPage *bucket, unsigned long long hash);
+	Status ChainInsert(PageID bucketID, HashBucketPage *bucket, char *entry, int len);
+	Status CanSplit(HashBucketPage *bucket, unsigned long long hash, bool &canSplit);
+	Status FreeChain(PageID pageID);
+	Status FreeDirectory(PageID firstID, int numPages);
+};
+
+#endif // _HASHINDEX_H
@@ -15,10 +15,30 @@ public:
 	
     virtual Status Insert (const char* data, const RecordID rid) = 0;
     virtual Status Delete (const char* data, const RecordID rid) = 0;
+    
+    // Find the record ids of all entries with key.  Returns OK if they
+    // all fit in rids, DONE if it filled up first.
+    virtual Status Lookup (const char* key, RecordID *rids, int maxRids, int &numRids) = 0;
 	
 };
 
 
+// Open the index file of the given type, creating it if it does not
+// exist.  B_Index opens a BTreeFile; SH_Index and Hash both open a
+// HashIndexFile.  The caller deletes the index when done with it.
+IndexFile *OpenIndexFile (Status &status, const char *filename, IndexType type);
+
+// MINIBASE_DB->GetFileEntry, AddFileEntry and DeleteFileEntry for the
+// indexes, which remember the header page of each index they have seen
+// in a hash table, so that opening an index again does not search the
+// file directory of the database.  An index also writes its name on
+// its header page, which is checked before an entry of the table is
+// trusted.
+Status GetIndexFileEntry (const char *filename, PageID &headerID);
+Status AddIndexFileEntry (const char *filename, PageID headerID);
+Status DeleteIndexFileEntry (const char *filename, PageID headerID);
+
+
 class IndexFileScan {
 
 public:
@@ -0,0 +1,120 @@
+#ifndef _MEMINDEX_H
+#define _MEMINDEX_H
+
+#include "minirel.h"
+#include "index.h"
+#include "bt.h"
+
+/*
+* In-memory B+ tree.
+*
+* A MemIndexFile holds the same (key, record id) entries as a BTreeFile
+* with LEAF_NODE leaves, in the same order, but in nodes on the heap
+* that point straight at their children.  Nothing goes through the
+* buffer manager, so an index that fits in memory is searched without
+* a single pin.  It is meant for small, hot indexes; Checkpoint and
+* Restore copy it to and from a BTreeFile to keep it across runs.
+*
+* A node holds up to MEM_NODE_FANOUT entries.  Their KeyPrefixes are
+* packed at the front of the node, so that a search usually reads one
+* cache line of them and settles only the ties against the keys
+* themselves, which are allocated separately.  The node as a whole
+* spans several cache lines (480 bytes on a 64-bit build); only the
+* prefixes are meant to share one.  Index nodes hold the
+* (key, record id) separators between their children; leaves are
+* linked both ways for scans.
+*
+* As in BTreeFile, nodes are not merged when they run low, but a leaf
+* that is left empty is freed, along with any index node left without
+* children.
+*/
+
+#define MEM_NODE_FANOUT  16
+
+
+struct MemKey
+{
+	int  length;
+	char bytes[1];   // really length bytes
+};
+
+
+struct MemNode
+{
+	KeyPrefix prefixes[MEM_NODE_FANOUT];         // prefix of each key, searched first
+	short     numKeys;
+	short     isLeaf;
+	MemKey   *keys[MEM_NODE_FANOUT];
+	RecordID  rids[MEM_NODE_FANOUT];             // data of a leaf entry, or half of a separator
+	MemNode  *children[MEM_NODE_FANOUT + 1];     // index nodes only
+	MemNode  *prevLeaf;                          // leaves only
+	MemNode  *nextLeaf;
+};
+
+
+class BTreeFile;
+class MemIndexFileScan;
+
+class MemIndexFile : public IndexFile {
+
+public:
+
+	friend class MemIndexFileScan;
+
+	MemIndexFile();
+	~MemIndexFile();
+
+	Status Insert(const char *key, const RecordID rid);
+	Status Delete(const char *key, const RecordID rid);
+
+	Status Insert(const KeyView &key, const RecordID rid);
+	Status Delete(const KeyView &key, const RecordID rid);
+
+	Status Lookup(const char *key, RecordID *rids, int maxRids, int &numRids);
+	Status Lookup(const KeyView &key, RecordID *rids, int maxRids, int &numRids);
+
+	IndexFileScan *OpenScan(const char *lowKey = NULL, const char *highKey = NULL);
+	IndexFileScan *OpenScan(const KeyView *lowKey, const KeyView *highKey);
+
+	Status Checkpoint(BTreeFile *file);
+	Status Restore(BTreeFile *file);
+	void   Clear();
+
+	Status DumpStatistics();
+
+private:
+
+	MemNode *root;      // never NULL; an empty index has an empty leaf
+	int      height;    // number of levels, 1 for a lone leaf
+
+	MemNode *NewNode(bool isLeaf);
+	void     FreeNode(MemNode *node);
+	MemNode *FindLeaf(const KeyView &key, const RecordID &rid, bool leftmost, MemNode **path, int *pathSlots);
+	bool     NextLeaf(MemNode **path, int *pathSlots, MemNode *&leaf);
+	void     InsertAt(MemNode *node, int pos, MemKey *key, const RecordID &rid, MemNode *child);
+	void     RemoveAt(MemNode *node, int pos, int childPos);
+	MemNode *Split(MemNode *node, MemKey *&separator, RecordID &separatorRid);
+};
+
+
+class MemIndexFileScan : public IndexFileScan {
+
+public:
+
+	friend class MemIndexFile;
+
+	Status GetNext(RecordID &rid, char *keyptr);
+	Status GetNext(RecordID &rid, char *keyptr, int &keyLen);
+
+	~MemIndexFileScan() {}
+
+private:
+
+	MemNode *leaf;      // leaf of the next entry, NULL once the scan is done
+	int      slot;      // slot of the next entry on leaf
+	KeyType  highKeyData;
+	KeyView  highKeyView;
+	bool     hasHighKey;
+};
+
+#endif // _MEMINDEX_H
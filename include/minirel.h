@@ -14,11 +14,11 @@ using namespace std;
 
 enum AttrType {
     attrString,
- //   attrInteger,
- //   attrReal,
  //   attrSymbol,
 	//attrFoo,
-    attrNull
+    attrNull,
+    attrInteger, // after attrNull, so its value does not change
+    attrReal
 };
 
 enum AttrOperator {
@@ -49,7 +49,8 @@ enum IndexType {
     None,
 //  B_Index,
     SH_Index,    // Static Hashing
-    Hash
+    Hash,
+    B_Index      // after the hashes, so their values do not change
 };
 
 enum SelectType {
@@ -14,12 +14,22 @@ private:
 	
 	// No private variables should be declared.
 	
+	int SearchSlots(const KeyView &key, const RecordID &rid, int count, bool upper);
+	
 public:
 		
 	Status InsertRecord(char * recPtr, int recLen, RecordID& rid);	
 	Status DeleteRecord(const RecordID& rid);
+
+	void     Prefetch();
+	
+	KeyView  GetKeyView(int slotNo);
+	RecordID GetKeyRid(int slotNo);
+	int      LowerBound(const KeyView &key, const RecordID &rid = LOWEST_RID);
+	int      UpperBound(const KeyView &key, const RecordID &rid = LOWEST_RID);
 	
 	void  SetType(NodeType t)  { type = (short)t; }
+	void  SetPageNo(PageID p)  { pid = p; }   // for a page image copied to another page
 
 	NodeType GetType()         { return (NodeType)type; }
 	int   GetNumOfRecords() { return numOfSlots; }